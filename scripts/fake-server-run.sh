@@ -0,0 +1,80 @@
+#!/usr/bin/env bash
+# Plays the ladder build of the bot against BlankBotFakeServer and checks the
+# outcome of the scripted game.
+#
+# Usage: scripts/fake-server-run.sh [build-dir] [game-loops] [port]
+#
+# Checks:
+#   - mining is balanced: no Nexus is left short of its ideal harvesters
+#     while another one has more than it needs
+#   - with a bot configured with -DENABLE_ALLOC_PROFILER=ON, none of the step
+#     phases below allocates in steady state
+
+set -euo pipefail
+
+# Step phases expected to run without heap allocations once the game is
+# under way, as named in the allocation profiler report. The others still
+# copy unit lists out of cpp-sc2 or issue commands through it.
+alloc_free_phases=("decide" "record")
+
+build_dir=${1:-build}
+loops=${2:-22400}
+port=${3:-5677}
+bin="$build_dir/bin"
+log_dir=$(mktemp -d)
+trap 'rm -rf "$log_dir"' EXIT
+
+"$bin/BlankBotFakeServer" "$port" "$loops" > "$log_dir/server.log" 2>&1 &
+server=$!
+sleep 1
+
+bot_status=0
+"$bin/BlankBot" --GamePort "$port" --StartPort "$((port + 1))" --LadderServer 127.0.0.1 \
+    > "$log_dir/bot.log" 2>&1 || bot_status=$?
+wait "$server"
+
+cat "$log_dir/server.log"
+failed=0
+
+if [ "$bot_status" -ne 0 ]; then
+    echo "FAIL: bot exited with status $bot_status"
+    tail -n 20 "$log_dir/bot.log"
+    failed=1
+fi
+
+# "Harvesters at Nexus <x>,<y>: <assigned>/<ideal>", one line per Nexus
+if ! awk '/^Harvesters at Nexus/ {
+        split($NF, counts, "/")
+        excess = counts[1] - counts[2]
+        if (!seen || excess > most) most = excess
+        if (!seen || excess < least) least = excess
+        seen = 1
+    }
+    END {
+        if (!seen) { print "FAIL: server reported no Nexus"; exit 1 }
+        if (least < 0 && most > 1) { print "FAIL: workers not balanced between bases"; exit 1 }
+        print "OK: workers balanced between bases"
+    }' "$log_dir/server.log"; then
+    failed=1
+fi
+
+if grep -q "^Heap allocations per step" "$log_dir/bot.log"; then
+    awk '/^Heap allocations per step/ { report = 1; print; next } report && /^  / { print; next } { report = 0 }' \
+        "$log_dir/bot.log"
+    allocating=0
+    for phase in "${alloc_free_phases[@]}"; do
+        if grep -qE "^  $phase +allocations.*<- allocates in steady state" "$log_dir/bot.log"; then
+            echo "FAIL: $phase phase allocates in steady state"
+            allocating=1
+        fi
+    done
+    if [ "$allocating" -eq 0 ]; then
+        echo "OK: ${alloc_free_phases[*]} free of allocations in steady state"
+    else
+        failed=1
+    fi
+else
+    echo "SKIP: bot built without the allocation profiler"
+fi
+
+exit "$failed"
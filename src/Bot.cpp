@@ -3,6 +3,7 @@
 // Copyright (c) 2021-2024 Alexander Kurbatov
 
 #include "Bot.h"
+#include "allocProfiler.h"
 
 #include <sc2api/sc2_common.h>
 #include <sc2api/sc2_unit.h>
@@ -21,6 +22,8 @@ void Bot::OnGameEnd()
 
 void Bot::OnBuildingConstructionComplete(const sc2::Unit* building_)
 {
+    AllocProfiler::Scope phase(StepPhase::EVENTS);
+
     std::cout << sc2::UnitTypeToName(building_->unit_type) <<
         "(" << building_->tag << ") constructed" << std::endl;
 }
@@ -32,24 +35,32 @@ void Bot::OnStep()
 
 void Bot::OnUnitCreated(const sc2::Unit* unit_)
 {
+    AllocProfiler::Scope phase(StepPhase::EVENTS);
+
     std::cout << sc2::UnitTypeToName(unit_->unit_type) <<
         "(" << unit_->tag << ") was created" << std::endl;
 }
 
 void Bot::OnUnitIdle(const sc2::Unit* unit_)
 {
+    AllocProfiler::Scope phase(StepPhase::EVENTS);
+
     std::cout << sc2::UnitTypeToName(unit_->unit_type) <<
          "(" << unit_->tag << ") is idle" << std::endl;
 }
 
 void Bot::OnUnitDestroyed(const sc2::Unit* unit_)
 {
+    AllocProfiler::Scope phase(StepPhase::EVENTS);
+
     std::cout << sc2::UnitTypeToName(unit_->unit_type) <<
          "(" << unit_->tag << ") was destroyed" << std::endl;
 }
 
 void Bot::OnUpgradeCompleted(sc2::UpgradeID id_)
 {
+    AllocProfiler::Scope phase(StepPhase::EVENTS);
+
     std::cout << sc2::UpgradeIDToName(id_) << " completed" << std::endl;
 }
 
@@ -5,8 +5,14 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <filesystem>
+#include <unordered_set>
+#include "allocProfiler.h"
 #include "protossUnits.h"
 #include "pylonManager.h"
+#include "unitStats.h"
 
 // Called when the game starts
 void DecisionTreeBot::OnGameStart() {
@@ -26,28 +32,145 @@ void DecisionTreeBot::OnGameStart() {
 	
 	// Make an educated guess about enemy location (opposite corner for now)
 	const GameInfo& game_info = Observation()->GetGameInfo();
-	Point2D map_center = game_info.playable_max / 2;
 	enemy_base_location = Point2D(
 		game_info.playable_max.x - main_base_location.x,
 		game_info.playable_max.y - main_base_location.y
 	);
+	// Snap the guess to the closest start location the map actually has
+	float closest_start = std::numeric_limits<float>::max();
+	Point2D mirrored = enemy_base_location;
+	for (const auto& location : game_info.enemy_start_locations) {
+		if (DistanceSquared2D(location, mirrored) < closest_start) {
+			closest_start = DistanceSquared2D(location, mirrored);
+			enemy_base_location = location;
+		}
+	}
 
 	// Store player race
 	race = game_info.player_info[0].race_actual;
+
+	enemy_memory.Reset(game_info);
+	damage_tracker.Reset();
+	command_latency.Attach(Agent::Actions());
+
+	// Map analysis and data tables are built in the background; until they
+	// are swapped in, placement, worker assignment and scouting use their
+	// query-based fallbacks
+	power_grid = PowerGrid();
+	pathfinder = Pathfinder();
+	base_index = BaseIndex();
+	visibility = VisibilityGrid();
+	composition = CompositionSolver();
+	build_time_by_ability.clear();
+	scout_planner = ScoutPlanner();
+	scout_route.clear();
+	scout_stop = 0;
+	scout_tag = 0;
+	warm_up_adopted = false;
+	warm_up_neutral_losses.clear();
+	warm_up.Start(game_info, Observation()->GetUnits(Unit::Alliance::Neutral), Observation()->GetUnitTypeData());
+
+	for (const auto& unit : Observation()->GetUnits(Unit::Alliance::Self)) {
+		if (unit->build_progress >= 1.0f) {
+			production.OnStructureCompleted(unit);
+		}
+	}
+
+	// Pick the opening from what worked against this opponent before
+	current_game = {};
+	for (const auto& player : game_info.player_info) {
+		if (player.player_id != Observation()->GetPlayerID()) {
+			current_game.enemy_race = static_cast<uint8_t>(player.race_requested);
+		}
+	}
+	if (!opponent_id.empty()) {
+		std::error_code ec;
+		std::filesystem::create_directories("data", ec);
+		if (opponent_history.Open("data/opponent_history.bin")) {
+			ApplyStrategy(opponent_history.ChooseStrategy(opponent_id));
+		}
+		else {
+			std::cerr << "Opponent history unavailable" << std::endl;
+		}
+	}
+
+	if (state_policy.Load("data/state_policy.bin")) {
+		if (state_policy.InputSize() == STATE_POLICY_INPUTS && state_policy.OutputSize() == STATE_POLICY_OUTPUTS) {
+			state_policy.SetBudget(std::chrono::microseconds(200));
+			std::cout << "State policy loaded" << std::endl;
+		}
+		else {
+			std::cerr << "State policy has the wrong shape, ignoring it" << std::endl;
+			state_policy.Close();
+		}
+	}
+
+	if (pipelined_decisions) {
+		decision_pipeline.Start(Observation()->GetUnitTypeData());
+	}
+
+	// One feature recording per game
+	std::error_code features_ec;
+	std::filesystem::create_directories("data/features", features_ec);
+	std::string features_path = "data/features/" + (opponent_id.empty() ? std::string("local") : opponent_id) +
+		"_" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count()) + ".bbfr";
+	if (!feature_recorder.Start(features_path)) {
+		std::cerr << "Feature recording unavailable" << std::endl;
+	}
+
+	std::string telemetry_name = TelemetrySegmentName(TelemetryProcessId());
+	if (telemetry.Create(telemetry_name.c_str())) {
+		std::cout << "Publishing telemetry to " << telemetry_name << std::endl;
+	}
+	else {
+		std::cerr << "Telemetry segment unavailable, continuing without it" << std::endl;
+	}
 }
 
 // Called on each game step
 void DecisionTreeBot::OnStep() {
+	auto step_start = std::chrono::steady_clock::now();
+	query_count = 0;
+	AllocProfiler::BeginStep();
+	AllocProfiler::SetPhase(StepPhase::OBSERVE);
+
+	AdoptWarmUp();
+	command_latency.Observe(Observation());
+
 	// Update our unit lists
+	AllocProfiler::SetPhase(StepPhase::UNIT_LISTS);
 	UpdateUnitLists();
 
+	// Squads are kept current every step: the attack and defend handlers
+	// order them, and the step size looks for enemies around them
+	squads.Update(our_army, Observation());
+	AllocProfiler::SetPhase(StepPhase::OBSERVE);
+	damage_tracker.Observe(our_units, Observation()->GetGameLoop());
+
+	// Enemy and neutral structures block placement too, and unit events
+	// only report ours
+	power_grid.ObserveForeignStructures(enemy_units, Observation()->GetUnitTypeData());
+	power_grid.ObserveForeignStructures(neutral_units, Observation()->GetUnitTypeData());
+	if (const auto* raw = Observation()->GetRawObservation()) {
+		visibility.Update(raw->raw_data().map_state().visibility(), Observation()->GetGameLoop());
+	}
+	enemy_memory.Observe(enemy_units, Observation());
+	enemy_memory.ForgetVanishedStructures(Observation()->GetGameLoop(),
+		[this](const Point2D& pos) { return visibility.IsVisible(pos); });
+	UpdateEnemyBaseGuess();
+	TrackOpponent();
+	production.ClearDemand();
+
 	//int minerals = Observation()->GetMinerals();
 	
     // Create a pylonManager instance
     static PylonManager pylonManager;
 
 	// Manager workers
-	pylonManager.ManageWorkerAssignments(Actions(), Observation());
+	AllocProfiler::SetPhase(StepPhase::WORKERS);
+	command_latency.SetSource(CommandSource::WORKERS);
+	pylonManager.ManageWorkerAssignments(Actions(), Observation(), base_index);
 
 
     // Build a pylon if we're close to supply cap
@@ -55,67 +178,162 @@ void DecisionTreeBot::OnStep() {
         Observation()->GetFoodCap() < 200 && 
         Observation()->GetMinerals() >= 100) {
         // Find a place near our base to build the pylon
+        AllocProfiler::SetPhase(StepPhase::SUPPLY);
+        command_latency.SetSource(CommandSource::SUPPLY);
         const Unit* builder = FindBuilder();
         if (builder) {
-            Point2D build_location = FindPlacement(ABILITY_ID::BUILD_PYLON, main_base_location, 15.0f);
+            Point2D build_location = FindStructurePlacement(ABILITY_ID::BUILD_PYLON, main_base_location, 15.0f);
             if (build_location.x != 0) {
                 Actions()->UnitCommand(builder, ABILITY_ID::BUILD_PYLON, build_location);
             }
         }
     }
 
+	AllocProfiler::SetPhase(StepPhase::STATE);
+
+	// Walk the scout along its route and send it home when it is done
+	command_latency.SetSource(CommandSource::SCOUT);
+	UpdateScout();
+
 	// Execute the current state of our behavior tree
 	switch (current_state) {
 		case INIT:
 			HandleInitState();
 			break;
 		case ECONOMY:
+			command_latency.SetSource(CommandSource::ECONOMY);
 			HandleEconomyState();
 			break;
 		case ARMY:
+			command_latency.SetSource(CommandSource::ARMY);
 			HandleArmyState();
 			break;
 		case ATTACK:
+			command_latency.SetSource(CommandSource::ATTACK);
 			HandleAttackState();
 			break;
 		case DEFEND:
+			command_latency.SetSource(CommandSource::DEFEND);
 			HandleDefendState();
 			break;
 		case SCOUT:
+			command_latency.SetSource(CommandSource::SCOUT);
 			HandleScoutState();
 			break;
 	}
+
+	// Start whatever the state asked for on structures that came free
+	AllocProfiler::SetPhase(StepPhase::PRODUCTION);
+	command_latency.SetSource(CommandSource::PRODUCTION);
+	production.Dispatch(Observation(), Actions(), power_grid, main_base_location);
 	
-	// Transition between states based on conditions
+	// Transition between states based on conditions, keeping the state that
+	// issued this step's commands for the recorder
+	AllocProfiler::SetPhase(StepPhase::DECIDE);
+	BotState acted_state = current_state;
 	DetermineNextState();
+
+	step_size = ChooseStepSize();
+
+	AllocProfiler::SetPhase(StepPhase::RECORD);
+	RecordFeatures(acted_state);
+
+	PublishTelemetry(step_start);
+	AllocProfiler::EndStep(Observation()->GetGameLoop());
+}
+
+void DecisionTreeBot::OnUnitDestroyed(const Unit* unit) {
+	AllocProfiler::Scope phase(StepPhase::EVENTS);
+	if (!warm_up_adopted && unit->alliance == Unit::Alliance::Neutral) {
+		warm_up_neutral_losses.push_back(*unit);
+	}
+	if (unit->alliance == Unit::Alliance::Enemy) {
+		enemy_memory.Forget(unit->tag);
+		power_grid.OnForeignStructureDestroyed(unit->tag);
+	}
+	else if (unit->alliance == Unit::Alliance::Self) {
+		power_grid.OnStructureDestroyed(unit);
+		pathfinder.OnStructureDestroyed(unit);
+		base_index.OnStructureDestroyed(unit);
+		production.OnStructureDestroyed(unit);
+	}
+	else if (unit->alliance == Unit::Alliance::Neutral) {
+		power_grid.OnForeignStructureDestroyed(unit->tag);
+		pathfinder.OnStructureDestroyed(unit);
+		base_index.OnResourceDepleted(unit->tag, Observation());
+	}
+}
+
+ActionInterface* DecisionTreeBot::Actions() {
+	return &command_latency;
+}
+
+void DecisionTreeBot::OnUnitCreated(const Unit* unit) {
+	AllocProfiler::Scope phase(StepPhase::EVENTS);
+	power_grid.OnStructureCreated(unit);
+	pathfinder.OnStructureCreated(unit);
+	base_index.OnStructureCreated(unit, Observation());
+}
+
+void DecisionTreeBot::OnBuildingConstructionComplete(const Unit* building) {
+	AllocProfiler::Scope phase(StepPhase::EVENTS);
+	power_grid.OnStructureCompleted(building);
+	production.OnStructureCompleted(building);
+}
+
+void DecisionTreeBot::OnUnitIdle(const Unit* unit) {
+	AllocProfiler::Scope phase(StepPhase::EVENTS);
+	production.OnStructureIdle(unit);
 }
 
 // Determines what state to transition to next
 void DecisionTreeBot::DetermineNextState() {
-	// Check if we're under attack
-	bool under_attack = false;
-	for (const auto& enemy : enemy_units) {
-		float distance_to_base = Distance2D(enemy->pos, main_base_location);
-		if (distance_to_base < 30.0f) {
-			under_attack = true;
-			break;
-		}
+	// Check if we're under attack, remembering enemies that just left vision
+	uint32_t game_loop = Observation()->GetGameLoop();
+	uint32_t recent_loop = game_loop > ATTACK_WINDOW_LOOPS ? game_loop - ATTACK_WINDOW_LOOPS : 0;
+	nearby_sightings.clear();
+	enemy_memory.Query(main_base_location, 30.0f, recent_loop, &nearby_sightings);
+	bool under_attack = !nearby_sightings.empty();
+	defend_location = main_base_location;
+
+	// Anything of ours taking damage at one of our bases counts too, even
+	// when we cannot see who is shooting
+	Point2D damaged;
+	if (FindBaseUnderFire(recent_loop, &damaged)) {
+		under_attack = true;
+		defend_location = damaged;
 	}
 	
-	// If we're under attack, switch to defense
+	// If we're under attack, switch to defense. Scouting workers and
+	// overlords are worth defending against, but only army counts as an attack
 	if (under_attack) {
+		if (current_game.first_attack_loop == 0) {
+			for (const auto& sighting : nearby_sightings) {
+				if (IsEnemyArmy(sighting->unit_type)) {
+					current_game.first_attack_loop = game_loop;
+					break;
+				}
+			}
+		}
 		current_state = DEFEND;
 		return;
 	}
 	
+	// A trained policy, if we have one, picks among the macro states
+	BotState learned;
+	if (PolicyState(&learned)) {
+		current_state = learned;
+		return;
+	}
+
 	// If we have a decent army size, go attack
-	if (our_army.size() >= 15) {
+	if (our_army.size() >= attack_army_size) {
 		current_state = ATTACK;
 		return;
 	}
 	
 	// If we need more army, focus on that
-	if (our_army.size() < 15 && our_workers.size() >= 16 && our_production_buildings.size() > 5) {
+	if (our_workers.size() >= army_worker_count && our_production_buildings.size() > 5) {
 		current_state = ARMY;
 		return;
 	}
@@ -130,8 +348,179 @@ void DecisionTreeBot::DetermineNextState() {
 	current_state = ECONOMY;
 }
 
+void DecisionTreeBot::AdoptWarmUp() {
+	if (warm_up_adopted || !warm_up.Ready()) {
+		return;
+	}
+
+	// Swapped in between steps, so every consumer sees either the fallbacks
+	// or the full results, never a mix
+	WarmUpResults results = warm_up.Take();
+	power_grid = std::move(results.power_grid);
+	pathfinder = std::move(results.pathfinder);
+	base_index = std::move(results.base_index);
+	visibility = std::move(results.visibility);
+	composition = std::move(results.composition);
+	build_time_by_ability = std::move(results.build_time_by_ability);
+	warm_up_adopted = true;
+
+	// Catch up on what happened while they were built from the start snapshot
+	for (const auto& unit : warm_up_neutral_losses) {
+		pathfinder.OnStructureDestroyed(&unit);
+		base_index.OnResourceDepleted(unit.tag, Observation());
+	}
+	warm_up_neutral_losses.clear();
+	for (const auto& unit : Observation()->GetUnits(Unit::Alliance::Self)) {
+		power_grid.OnStructureCreated(unit);
+		pathfinder.OnStructureCreated(unit);
+		if (unit->build_progress >= 1.0f) {
+			power_grid.OnStructureCompleted(unit);
+		}
+		base_index.OnStructureCreated(unit, Observation());
+	}
+
+	std::cout << "Map analysis ready after " << warm_up.Elapsed().count() / 1000 << " ms, loop "
+		<< Observation()->GetGameLoop() << std::endl;
+
+	// The scout route only depends on the map and our start, so it is kept
+	// on disk and planned once per map
+	std::error_code ec;
+	std::filesystem::create_directories("data/scout_routes", ec);
+	if (scout_planner.Plan(Observation()->GetGameInfo(), main_base_location, base_index, pathfinder,
+			"data/scout_routes")) {
+		std::cout << "Scout route: " << scout_planner.Route().size() << " stops, "
+			<< static_cast<int>(scout_planner.Length()) << " cells"
+			<< (scout_planner.FromCache() ? " (cached)" : "") << std::endl;
+	}
+}
+
+void DecisionTreeBot::UpdateEnemyBaseGuess() {
+	if (!visibility.IsExplored(enemy_base_location)) {
+		return;
+	}
+
+	nearby_sightings.clear();
+	enemy_memory.Query(enemy_base_location, 15.0f, 0, &nearby_sightings);
+	for (const auto* sighting : nearby_sightings) {
+		if (sighting->is_structure) {
+			return;
+		}
+	}
+
+	// Nothing there: try the closest start location nobody has looked at
+	std::vector<Point2D> unexplored;
+	visibility.UnexploredStartLocations(&unexplored);
+	float closest = std::numeric_limits<float>::max();
+	for (const auto& location : unexplored) {
+		if (DistanceSquared2D(location, main_base_location) < closest) {
+			closest = DistanceSquared2D(location, main_base_location);
+			enemy_base_location = location;
+		}
+	}
+}
+
+bool DecisionTreeBot::FindBaseUnderFire(uint32_t min_loop, Point2D* where) {
+	std::vector<const BaseSite*> owned;
+	base_index.OwnedSites(&owned);
+	std::vector<Point2D> bases;
+	for (const auto* site : owned) {
+		bases.push_back(site->town_hall_pos);
+	}
+	if (bases.empty()) {
+		bases.push_back(main_base_location);
+	}
+
+	std::vector<float> damage(bases.size(), 0.0f);
+	float radius_sq = BASE_DEFENCE_RADIUS * BASE_DEFENCE_RADIUS;
+	damage_tracker.ForEachSince(min_loop, [&](const DamageEvent& event) {
+		Point2D pos(event.x, event.y);
+		for (size_t i = 0; i < bases.size(); ++i) {
+			if (DistanceSquared2D(pos, bases[i]) <= radius_sq) {
+				damage[i] += event.damage;
+				break;
+			}
+		}
+	});
+
+	size_t worst = std::max_element(damage.begin(), damage.end()) - damage.begin();
+	if (damage[worst] < BASE_DAMAGE_TRIGGER) {
+		return false;
+	}
+	*where = bases[worst];
+	return true;
+}
+
+bool DecisionTreeBot::PolicyState(BotState* state) {
+	if (!state_policy.IsLoaded()) {
+		return false;
+	}
+
+	// Features are scaled to roughly 0..1
+	const ObservationInterface* observation = Observation();
+	float features[STATE_POLICY_INPUTS] = {
+		our_workers.size() / 100.0f,
+		our_army.size() / 100.0f,
+		our_production_buildings.size() / 10.0f,
+		our_tech_buildings.size() / 10.0f,
+		our_base_buildings.size() / 10.0f,
+		enemy_units.size() / 100.0f,
+		observation->GetMinerals() / 1000.0f,
+		observation->GetVespene() / 1000.0f,
+		observation->GetFoodUsed() / 200.0f,
+		observation->GetFoodCap() / 200.0f,
+		observation->GetGameLoop() / 26880.0f,     // 20 minutes
+		scouting_initiated ? 1.0f : 0.0f
+	};
+
+	float logits[STATE_POLICY_OUTPUTS];
+	if (state_policy.Evaluate(features, 1, logits) != 1) {
+		return false;
+	}
+
+	static const BotState states[STATE_POLICY_OUTPUTS] = {ECONOMY, ARMY, ATTACK, SCOUT};
+	*state = states[std::max_element(logits, logits + STATE_POLICY_OUTPUTS) - logits];
+	return true;
+}
+
+void DecisionTreeBot::ApplyStrategy(OpeningStrategy opening) {
+	strategy = opening;
+	switch (opening) {
+		case OpeningStrategy::DEFENSIVE:
+			attack_army_size = 20;
+			army_worker_count = 12;
+			break;
+		case OpeningStrategy::AGGRESSIVE:
+			attack_army_size = 8;
+			army_worker_count = 14;
+			break;
+		default:
+			attack_army_size = 15;
+			army_worker_count = 16;
+			break;
+	}
+	std::cout << "Opening strategy: " << static_cast<int>(opening) << std::endl;
+}
+
+void DecisionTreeBot::TrackOpponent() {
+	if (current_game.first_army_loop != 0) {
+		return;
+	}
+
+	for (const auto& enemy : enemy_units) {
+		if (IsEnemyArmy(enemy->unit_type)) {
+			current_game.first_army_loop = Observation()->GetGameLoop();
+			return;
+		}
+	}
+}
+
+bool DecisionTreeBot::IsEnemyArmy(UnitTypeID unit_type) {
+	return UnitStats::IsArmy(unit_type, Observation()->GetUnitTypeData());
+}
+
 // Updates our lists of units
 void DecisionTreeBot::UpdateUnitLists() {
+	our_units.clear();
 	our_workers.clear();
 	our_army.clear();
 	our_production_buildings.clear();
@@ -139,11 +528,13 @@ void DecisionTreeBot::UpdateUnitLists() {
 	our_base_buildings.clear();
 	our_defensive_buildings.clear();
 	enemy_units.clear();
+	neutral_units.clear();
 	
 	Units units = Observation()->GetUnits();
 	for (const auto& unit : units) {
 		if (unit->alliance == Unit::Alliance::Self) {
 			UnitTypeID unit_type = unit->unit_type;
+			our_units.push_back(unit);
 			
 			if (protoss.IsWorker(unit_type))
 				our_workers.push_back(unit);
@@ -166,6 +557,9 @@ void DecisionTreeBot::UpdateUnitLists() {
 		else if (unit->alliance == Unit::Alliance::Enemy) {
 			enemy_units.push_back(unit);
 		}
+		else if (unit->alliance == Unit::Alliance::Neutral) {
+			neutral_units.push_back(unit);
+		}
 	}
 }
 
@@ -180,12 +574,9 @@ void DecisionTreeBot::HandleInitState() {
 void DecisionTreeBot::HandleEconomyState() {
     std::cout << "Economy state..." << std::endl;
     
-    // Track if we've constructed an assimilator this step
-    static bool assimilator_built_this_step = false;
-    
 	// Build workers if we need more
     int workersPerAssimilator = 3; // Ideal number of workers per assimilator
-	int workers_required = 0;
+	size_t workers_required = 0;
 
 	for (auto building : our_base_buildings) {
 		if (building->unit_type == sc2::UNIT_TYPEID::PROTOSS_NEXUS) {
@@ -197,15 +588,9 @@ void DecisionTreeBot::HandleEconomyState() {
 		}
 	}
 
-    if (our_workers.size() < workers_required && !our_base_buildings.empty()) {
-        for (const auto& base : our_base_buildings) {
-            if (base->unit_type == UNIT_TYPEID::PROTOSS_NEXUS && 
-                base->orders.empty() && 
-                Observation()->GetMinerals() >= 50) {
-                Actions()->UnitCommand(base, ABILITY_ID::TRAIN_PROBE);
-                break;
-            }
-        }
+    // Idle Nexuses pick these up in the production dispatcher
+    if (our_workers.size() < workers_required) {
+        production.SetDemand(UNIT_TYPEID::PROTOSS_PROBE, static_cast<int>(workers_required - our_workers.size()));
     }
 
     // Count existing assimilators and ones under construction
@@ -216,7 +601,7 @@ void DecisionTreeBot::HandleEconomyState() {
     bool needMoreAssimilators = false;
     
     // We want at least one assimilator when we have enough workers
-    if (our_workers.size() >= 12 && assimilatorCount < our_base_buildings.size() * maxAssimilatorsPerBase) {
+    if (our_workers.size() >= 12 && static_cast<size_t>(assimilatorCount) < our_base_buildings.size() * maxAssimilatorsPerBase) {
         needMoreAssimilators = true;
     }
     
@@ -226,8 +611,7 @@ void DecisionTreeBot::HandleEconomyState() {
     // Only try to build an assimilator if we need more and have enough minerals
 	// TODO: Also only build assimilator if we have less than a 2 Assim to 1 Nexus ratio
     if (needMoreAssimilators && Observation()->GetMinerals() >= 75) {
-        pylonManager.BuildAssimilator(Observation(), Actions());
-        assimilator_built_this_step = true;
+        pylonManager.BuildAssimilator(Observation(), Actions(), base_index);
     }
     
     // Build a gateway if we have at least 16 workers and enough minerals
@@ -237,7 +621,7 @@ void DecisionTreeBot::HandleEconomyState() {
         // Find a place to build a gateway
         const Unit* builder = FindBuilder();
         if (builder) {
-            Point2D build_location = FindPlacement(ABILITY_ID::BUILD_GATEWAY, main_base_location, 20.0f);
+            Point2D build_location = FindStructurePlacement(ABILITY_ID::BUILD_GATEWAY, main_base_location, 20.0f);
             if (build_location.x != 0) {
                 Actions()->UnitCommand(builder, ABILITY_ID::BUILD_GATEWAY, build_location);
             }
@@ -250,7 +634,7 @@ void DecisionTreeBot::HandleEconomyState() {
         // Find a place to build
         const Unit* builder = FindBuilder();
         if (builder) {
-            Point2D build_location = FindPlacement(ABILITY_ID::BUILD_CYBERNETICSCORE, main_base_location, 20.0f);
+            Point2D build_location = FindStructurePlacement(ABILITY_ID::BUILD_CYBERNETICSCORE, main_base_location, 20.0f);
             if (build_location.x != 0) {
                 Actions()->UnitCommand(builder, ABILITY_ID::BUILD_CYBERNETICSCORE, build_location);
             }
@@ -276,44 +660,144 @@ void DecisionTreeBot::HandleEconomyState() {
 void DecisionTreeBot::HandleArmyState() {
 	std::cout << "Army state..." << std::endl;
 	
-	// Find all barracks using our custom filter
-	Units gateways;
-	Units all_units = Observation()->GetUnits(Unit::Alliance::Self);
-	for (const auto& unit : all_units) {
-		if (unit->unit_type == UNIT_TYPEID::PROTOSS_GATEWAY) {
-			gateways.push_back(unit);
+	// What we can train right now
+	ProductionCapacity capacity;
+	for (const auto* unit : our_production_buildings) {
+		if (unit->build_progress < 1.0f) {
+			continue;
+		}
+		if (unit->unit_type == UNIT_TYPEID::PROTOSS_GATEWAY || unit->unit_type == UNIT_TYPEID::PROTOSS_WARPGATE) {
+			++capacity.gateways;
+		}
+		else if (unit->unit_type == UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY) {
+			++capacity.robotics;
+		}
+		else if (unit->unit_type == UNIT_TYPEID::PROTOSS_STARGATE) {
+			++capacity.stargates;
 		}
 	}
-	
-	// Train zealot from barracks
-	for (const auto& barrack : gateways) {
-		if (barrack->orders.empty() && Observation()->GetMinerals() >= 100) {
-			Actions()->UnitCommand(barrack, ABILITY_ID::TRAIN_ZEALOT);
+	for (const auto* unit : our_tech_buildings) {
+		if (unit->build_progress < 1.0f) {
+			continue;
 		}
+		capacity.cybernetics_core |= unit->unit_type == UNIT_TYPEID::PROTOSS_CYBERNETICSCORE;
+		capacity.robotics_bay |= unit->unit_type == UNIT_TYPEID::PROTOSS_ROBOTICSBAY;
 	}
 
-	// TODO: Check if we have cybernetics core to build stalkers
+	// Answer what the enemy has shown recently
+	const GameInfo& game_info = Observation()->GetGameInfo();
+	uint32_t game_loop = Observation()->GetGameLoop();
+	nearby_sightings.clear();
+	enemy_memory.Query(Point2D(game_info.width / 2.0f, game_info.height / 2.0f),
+		static_cast<float>(game_info.width + game_info.height),
+		game_loop > COMPOSITION_WINDOW_LOOPS ? game_loop - COMPOSITION_WINDOW_LOOPS : 0, &nearby_sightings);
+	composition.Update(nearby_sightings, capacity);
+
+	// Ask for whatever is furthest below its share, most behind first; the
+	// dispatcher trains or warps them in as resources allow
+	std::unordered_map<uint32_t, int> have;
+	for (const auto* unit : our_army) {
+		++have[unit->unit_type];
+	}
+	float target_size = static_cast<float>(our_army.size() + our_production_buildings.size());
+	std::vector<std::pair<UNIT_TYPEID, int>> wanted;
+	for (const auto& entry : composition.Mix()) {
+		int missing = static_cast<int>(std::ceil(entry.second * target_size)) - have[static_cast<uint32_t>(entry.first)];
+		if (missing > 0) {
+			wanted.push_back({entry.first, missing});
+		}
+	}
+	std::stable_sort(wanted.begin(), wanted.end(), [](const std::pair<UNIT_TYPEID, int>& a, const std::pair<UNIT_TYPEID, int>& b) {
+		return a.second > b.second;
+	});
+	for (const auto& entry : wanted) {
+		production.SetDemand(entry.first, entry.second);
+	}
 }
 
 // Handles the attack state
 void DecisionTreeBot::HandleAttackState() {
 	std::cout << "Attack state..." << std::endl;
 
-	// TODO: Pick smarter targets to attack while advancing to enemy base
-	
-	// If we have enough army units, attack the enemy base
-	if (our_army.size() >= 15) {
-		for (const auto& unit : our_army) {
-			Actions()->UnitCommand(unit, ABILITY_ID::ATTACK_ATTACK, enemy_base_location);
+	// Head for the closest enemy structure we know of, else the guessed base
+	Point2D attack_target = enemy_base_location;
+	if (const EnemySighting* structure = enemy_memory.NearestStructure(main_base_location)) {
+		attack_target = structure->pos;
+	}
+
+	// Decide once per squad: advance, engage or fall back
+	Units engaging;
+	for (auto& squad : squads.Squads()) {
+		float enemy_strength = squads.EnemyStrengthNear(
+			squad.centroid, squad.radius + SQUAD_ENGAGE_RANGE, enemy_units, Observation());
+
+		// Between the two ratios a squad keeps doing what it was doing
+		bool retreating = squad.order == SquadOrder::RETREAT;
+		if (enemy_strength <= 0.0f) {
+			squads.Order(squad, SquadOrder::ADVANCE, attack_target, Actions());
+		}
+		else if (enemy_strength > squad.strength * SQUAD_RETREAT_RATIO ||
+			(retreating && enemy_strength >= squad.strength * SQUAD_REENGAGE_RATIO)) {
+			squads.Order(squad, SquadOrder::RETREAT, main_base_location, Actions());
+		}
+		else {
+			squads.Release(squad);
+			engaging.insert(engaging.end(), squad.units.begin(), squad.units.end());
 		}
 	}
-	
-	// If we see enemy units, attack them
-	if (!enemy_units.empty() && !our_army.empty()) {
-		const Unit* target = enemy_units.front();
-		for (const auto& unit : our_army) {
-			Actions()->UnitCommand(unit, ABILITY_ID::ATTACK_ATTACK, target);
+
+	// Engaged squads focus fire, keeping targets stable
+	Units unassigned;
+	if (decision_pipeline.Running()) {
+		// Issue what the decision thread worked out from an earlier step,
+		// for units that are still engaged, then hand it this step
+		std::unordered_set<Tag> engaged_tags;
+		for (const auto& unit : engaging) {
+			engaged_tags.insert(unit->tag);
+		}
+
+		PipelinedCommand command;
+		while (decision_pipeline.Poll(&command)) {
+			if (command.kind == PipelinedCommand::Kind::END_OF_BATCH || engaged_tags.count(command.unit) == 0) {
+				continue;
+			}
+			const Unit* unit = Observation()->GetUnit(command.unit);
+			if (!unit) {
+				continue;
+			}
+			if (command.kind == PipelinedCommand::Kind::ADVANCE) {
+				unassigned.push_back(unit);
+				continue;
+			}
+			const Unit* target = Observation()->GetUnit(command.target);
+			if (target && target->is_alive) {
+				Actions()->UnitCommand(unit, ABILITY_ID::ATTACK_ATTACK, target);
+			}
+		}
+
+		decision_pipeline.Submit(Observation()->GetGameLoop(), engaging, enemy_units);
+	}
+	else {
+		target_selector.Update(engaging, enemy_units, Observation());
+		for (const auto& assignment : target_selector.Retargeted()) {
+			Actions()->UnitCommand(assignment.attacker, ABILITY_ID::ATTACK_ATTACK, assignment.target);
 		}
+		unassigned = target_selector.Unassigned();
+	}
+
+	// Engaged units without a target in reach close in with one group command
+	Units advancing;
+	for (const auto& unit : unassigned) {
+		bool already_advancing = !unit->orders.empty() &&
+			unit->orders.front().ability_id == ABILITY_ID::ATTACK_ATTACK &&
+			unit->orders.front().target_unit_tag == 0 &&
+			Distance2D(unit->orders.front().target_pos, attack_target) < 1.0f;
+		if (!already_advancing) {
+			advancing.push_back(unit);
+		}
+	}
+	if (!advancing.empty()) {
+		Actions()->UnitCommand(advancing, ABILITY_ID::ATTACK_ATTACK, attack_target);
 	}
 }
 
@@ -323,11 +807,14 @@ void DecisionTreeBot::HandleDefendState() {
 	HandleArmyState();
 
 	std::cout << "Defend state..." << std::endl;
-	
-	// If there are enemies near our base, defend
-	Point2D defense_point = main_base_location;
-	for (const auto& unit : our_army) {
-		Actions()->UnitCommand(unit, ABILITY_ID::ATTACK_ATTACK, defense_point);
+
+	// Defence orders override any focus-fire assignment
+	target_selector.Reset();
+	decision_pipeline.Reset();
+
+	// Defend the base that is under attack as squads
+	for (auto& squad : squads.Squads()) {
+		squads.Order(squad, SquadOrder::DEFEND, defend_location, Actions());
 	}
 
 	// TODO: utilise defensive structures if available
@@ -340,12 +827,123 @@ void DecisionTreeBot::HandleScoutState() {
 	// Send a worker to scout if we haven't already
 	if (!scouting_initiated && our_workers.size() > 10) {
 		const Unit* scout = our_workers.back(); // Use the last worker
-		// Use the proper move command
-		Actions()->UnitCommand(scout, ABILITY_ID::MOVE_MOVE, enemy_base_location);
+
+		// Before the map analysis is in there is no planned route, only the
+		// current guess
+		scout_route = scout_planner.Route();
+		if (scout_route.empty()) {
+			scout_route.push_back({enemy_base_location, true});
+		}
+		scout_stop = 0;
+		scout_tag = scout->tag;
+		scout_route_loop = Observation()->GetGameLoop();
+		SendScoutRoute(scout);
 		scouting_initiated = true;
 	}
 }
 
+void DecisionTreeBot::SendScoutRoute(const Unit* scout) {
+	if (scout_stop >= scout_route.size()) {
+		return;
+	}
+
+	// Walk our own route to the next stop so the scout's path is known in
+	// advance; fall back to the game's pathing if we have none. Later
+	// stops are queued behind it
+	std::vector<Point2D> path;
+	if (!pathfinder.FindPath(scout->pos, scout_route[scout_stop].pos, &path) || path.empty()) {
+		path.assign(1, scout_route[scout_stop].pos);
+	}
+	for (size_t i = scout_stop + 1; i < scout_route.size(); ++i) {
+		path.push_back(scout_route[i].pos);
+	}
+	for (size_t i = 0; i < path.size(); ++i) {
+		Actions()->UnitCommand(scout, ABILITY_ID::MOVE_MOVE, path[i], i > 0);
+	}
+}
+
+void DecisionTreeBot::UpdateScout() {
+	if (scout_tag == 0) {
+		return;
+	}
+	const Unit* scout = Observation()->GetUnit(scout_tag);
+	if (!scout || !scout->is_alive) {
+		scout_tag = 0;
+		return;
+	}
+
+	// Enemy structures at one of the mains end the search early
+	bool found = false;
+	for (const auto& stop : scout_route) {
+		if (!stop.start_location) {
+			continue;
+		}
+		nearby_sightings.clear();
+		enemy_memory.Query(stop.pos, 15.0f, 0, &nearby_sightings);
+		for (const auto* sighting : nearby_sightings) {
+			if (sighting->is_structure) {
+				found = true;
+				enemy_base_location = stop.pos;
+				break;
+			}
+		}
+		if (found) {
+			break;
+		}
+	}
+
+	// On the sweep the enemy may have settled anywhere, so any structure
+	// it revealed will do
+	if (!found && scout_swept) {
+		const EnemySighting* structure = enemy_memory.NearestStructure(scout->pos);
+		if (structure) {
+			found = true;
+			enemy_base_location = structure->pos;
+		}
+	}
+
+	size_t previous_stop = scout_stop;
+	while (scout_stop < scout_route.size()) {
+		const Point2D& stop = scout_route[scout_stop].pos;
+		if (visibility.LastSeen(stop) <= scout_route_loop && Distance2D(scout->pos, stop) > SCOUT_STOP_RADIUS) {
+			break;
+		}
+		++scout_stop;
+	}
+
+	// Nothing at the mains: sweep the stalest regions once before giving up
+	if (!found && scout_stop >= scout_route.size() && !scout_swept &&
+		visibility.ExploredShare() < SCOUT_SWEEP_EXPLORED) {
+		std::vector<Point2D> regions;
+		visibility.StalestRegions(SCOUT_SWEEP_STOPS, &regions);
+		if (!regions.empty()) {
+			scout_route.clear();
+			for (const auto& region : regions) {
+				scout_route.push_back({region, false});
+			}
+			scout_stop = 0;
+			scout_route_loop = Observation()->GetGameLoop();
+			scout_swept = true;
+			SendScoutRoute(scout);
+			return;
+		}
+	}
+
+	if (found || scout_stop >= scout_route.size()) {
+		const Unit* mineral = FindNearestMineralPatch(main_base_location);
+		if (mineral) {
+			Actions()->UnitCommand(scout, ABILITY_ID::HARVEST_GATHER, mineral);
+		}
+		scout_tag = 0;
+		return;
+	}
+
+	// Stops seen by someone else are skipped, so the orders need redoing
+	if (scout_stop != previous_stop) {
+		SendScoutRoute(scout);
+	}
+}
+
 // Helper functions
 const Unit* DecisionTreeBot::FindBuilder() {
 	if (our_workers.empty()) {
@@ -390,6 +988,7 @@ Point2D DecisionTreeBot::FindPlacement(AbilityID ability_type_for_structure, Poi
 		Point2D try_location = GetRandomPointInCircle(near_to, distance);
 		
 		// Query if this location is valid for this building type
+		++query_count;
 		if (Query()->Placement(ability_type_for_structure, try_location)) {
 			return try_location;
 		}
@@ -401,6 +1000,43 @@ Point2D DecisionTreeBot::FindPlacement(AbilityID ability_type_for_structure, Poi
 	return result; // Return 0,0 if no placement found
 }
 
+Point2D DecisionTreeBot::FindStructurePlacement(AbilityID ability_type_for_structure, Point2D near_to, float max_distance) {
+	int size = PowerGrid::FootprintSize(ability_type_for_structure);
+	if (!power_grid.IsInitialized() || size == 0) {
+		return FindPlacement(ability_type_for_structure, near_to, max_distance);
+	}
+
+	// Pylons only need free ground
+	Point2D location;
+	if (ability_type_for_structure == ABILITY_ID::BUILD_PYLON) {
+		if (power_grid.FindPlacement(near_to, size, false, max_distance, &location)) {
+			return location;
+		}
+		return Point2D(0, 0);
+	}
+
+	// Everything else goes into the field of the completed pylon closest to near_to
+	std::vector<const Unit*> pylons;
+	for (const auto& building : our_base_buildings) {
+		if (building->unit_type == UNIT_TYPEID::PROTOSS_PYLON && building->build_progress >= 1.0f &&
+			Distance2D(building->pos, near_to) <= max_distance) {
+			pylons.push_back(building);
+		}
+	}
+	std::sort(pylons.begin(), pylons.end(), [&near_to](const Unit* a, const Unit* b) {
+		return DistanceSquared2D(a->pos, near_to) < DistanceSquared2D(b->pos, near_to);
+	});
+
+	for (const auto& pylon : pylons) {
+		location = PylonManager::FindBuildLocationNearPylon(pylon, power_grid, size);
+		if (location.x != 0) {
+			return location;
+		}
+	}
+
+	return Point2D(0, 0);
+}
+
 Point2D DecisionTreeBot::GetRandomPointInCircle(const Point2D& center, float radius) {
 	float angle = GetRandomScalar() * 3.14159f * 2.0f;
 	float distance = sqrt(GetRandomScalar()) * radius;
@@ -413,10 +1049,10 @@ float DecisionTreeBot::GetRandomScalar() {
 }
 
 int DecisionTreeBot::CountUnitType(UNIT_TYPEID unit_type) {
+	// Runs every step from the state handlers; our units are already
+	// listed, so no Units vector is built per call
 	int count = 0;
-	Units units = Observation()->GetUnits(Unit::Alliance::Self);
-	
-	for (const auto& unit : units) {
+	for (const auto& unit : our_units) {
 		if (unit->unit_type == unit_type) {
 			++count;
 		}
@@ -425,7 +1061,176 @@ int DecisionTreeBot::CountUnitType(UNIT_TYPEID unit_type) {
 	return count;
 }
 
+int DecisionTreeBot::ChooseStepSize() {
+	// Visible armed enemies near one of our bases or squads: react every
+	// loop. The enemy memory grid only hands back sightings around those
+	// few places, instead of pairing every enemy with every unit of ours
+	uint32_t game_loop = Observation()->GetGameLoop();
+	const UnitTypes& types = Observation()->GetUnitTypeData();
+	float nearest = std::numeric_limits<float>::max();
+	auto scan = [&](const Point2D& center, float extent) {
+		nearby_sightings.clear();
+		enemy_memory.Query(center, extent + 2.0f * STEP_FIGHT_RANGE, game_loop, &nearby_sightings);
+		for (const auto* sighting : nearby_sightings) {
+			uint32_t id = sighting->unit_type;
+			if (id < types.size() && types[id].weapons.empty()) {
+				continue;
+			}
+			nearest = std::min(nearest, std::max(0.0f, Distance2D(sighting->pos, center) - extent));
+		}
+	};
+	for (const auto& base : our_base_buildings) {
+		scan(base->pos, STEP_BASE_EXTENT);
+	}
+	for (const auto& squad : squads.Squads()) {
+		scan(squad.centroid, squad.radius);
+	}
+	if (nearest < STEP_FIGHT_RANGE) {
+		return 1;
+	}
+
+	// Something is closing in: keep steps short
+	int step = MAX_STEP_SIZE;
+	if (nearest < 2.0f * STEP_FIGHT_RANGE) {
+		step = MAX_STEP_SIZE / 4;
+	}
+
+	// Do not sleep through a structure or unit finishing
+	auto remaining_loops = [this](AbilityID ability, float progress) {
+		auto it = build_time_by_ability.find(ability);
+		return it != build_time_by_ability.end() ? (1.0f - progress) * it->second : 0.0f;
+	};
+	for (const auto* group : {&our_production_buildings, &our_tech_buildings, &our_base_buildings, &our_defensive_buildings}) {
+		for (const auto& building : *group) {
+			uint32_t id = building->unit_type;
+			if (building->build_progress < 1.0f && id < types.size()) {
+				float loops = remaining_loops(types[id].ability_id, building->build_progress);
+				step = std::min(step, std::max(1, static_cast<int>(loops)));
+			}
+			else if (!building->orders.empty()) {
+				float loops = remaining_loops(building->orders.front().ability_id, building->orders.front().progress);
+				step = std::min(step, std::max(1, static_cast<int>(loops)));
+			}
+		}
+	}
+
+	return step;
+}
+
+void DecisionTreeBot::RecordFeatures(BotState acted_state) {
+	if (!feature_recorder.IsRecording()) {
+		return;
+	}
+
+	const ObservationInterface* observation = Observation();
+	FeatureRow row;
+	row.game_loop = observation->GetGameLoop();
+	row.bot_state = static_cast<uint32_t>(acted_state);
+	row.workers = static_cast<uint32_t>(our_workers.size());
+	row.army = static_cast<uint32_t>(our_army.size());
+	row.production_buildings = static_cast<uint32_t>(our_production_buildings.size());
+	row.tech_buildings = static_cast<uint32_t>(our_tech_buildings.size());
+	row.base_buildings = static_cast<uint32_t>(our_base_buildings.size());
+	row.defensive_buildings = static_cast<uint32_t>(our_defensive_buildings.size());
+	row.minerals = static_cast<uint32_t>(observation->GetMinerals());
+	row.vespene = static_cast<uint32_t>(observation->GetVespene());
+	row.food_used = static_cast<uint32_t>(observation->GetFoodUsed());
+	row.food_cap = static_cast<uint32_t>(observation->GetFoodCap());
+	row.enemy_visible = static_cast<uint32_t>(enemy_units.size());
+
+	// Same window DetermineNextState uses to call an attack
+	nearby_sightings.clear();
+	uint32_t recent_loop = row.game_loop > ATTACK_WINDOW_LOOPS ? row.game_loop - ATTACK_WINDOW_LOOPS : 0;
+	enemy_memory.Query(main_base_location, 30.0f, recent_loop, &nearby_sightings);
+	row.enemy_near_base = static_cast<uint32_t>(nearby_sightings.size());
+
+	for (Tag tag : Actions()->Commands()) {
+		const Unit* unit = observation->GetUnit(tag);
+		if (!unit) {
+			continue;
+		}
+		if (protoss.IsWorker(unit->unit_type)) {
+			++row.commanded_workers;
+		}
+		else if (protoss.IsArmyUnit(unit->unit_type)) {
+			++row.commanded_army;
+		}
+		else {
+			++row.commanded_structures;
+		}
+	}
+
+	feature_recorder.Record(row);
+}
+
+void DecisionTreeBot::PublishTelemetry(std::chrono::steady_clock::time_point step_start) {
+	if (!telemetry.IsOpen()) {
+		return;
+	}
+
+	TelemetrySample sample;
+	sample.game_loop = Observation()->GetGameLoop();
+	sample.actions_sent = static_cast<uint32_t>(Actions()->Commands().size());
+	sample.query_count = query_count;
+
+	const ScoreDetails& score = Observation()->GetScore().score_details;
+	sample.minerals_rate = static_cast<uint32_t>(score.collection_rate_minerals);
+	sample.vespene_rate = static_cast<uint32_t>(score.collection_rate_vespene);
+
+	// Nexuses and assimilators report their harvester saturation
+	int assigned = 0;
+	int ideal = 0;
+	for (const auto& building : our_base_buildings) {
+		assigned += building->assigned_harvesters;
+		ideal += building->ideal_harvesters;
+	}
+	sample.worker_saturation = ideal > 0 ? static_cast<uint32_t>(assigned * 1000 / ideal) : 0;
+
+	sample.bot_state = static_cast<uint32_t>(current_state);
+	sample.workers = static_cast<uint32_t>(our_workers.size());
+	sample.army = static_cast<uint32_t>(our_army.size());
+	sample.production_buildings = static_cast<uint32_t>(our_production_buildings.size());
+	sample.tech_buildings = static_cast<uint32_t>(our_tech_buildings.size());
+	sample.base_buildings = static_cast<uint32_t>(our_base_buildings.size());
+	sample.defensive_buildings = static_cast<uint32_t>(our_defensive_buildings.size());
+	sample.enemy_units = static_cast<uint32_t>(enemy_units.size());
+
+	auto elapsed = std::chrono::steady_clock::now() - step_start;
+	sample.step_duration_us = static_cast<uint32_t>(
+		std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+	telemetry.Publish(sample);
+}
+
 // This function is called when the bot's game ends
 void DecisionTreeBot::OnGameEnd() {
 	std::cout << "Game ended!" << std::endl;
+
+	current_game.result = HistoryResult::UNDECIDED;
+	for (const auto& result : Observation()->GetResults()) {
+		if (result.player_id == Observation()->GetPlayerID()) {
+			current_game.result = static_cast<HistoryResult>(result.result);
+		}
+	}
+	current_game.game_loops = Observation()->GetGameLoop();
+
+	if (!opponent_id.empty()) {
+		current_game.enemy_build = OpponentHistory::ClassifyBuild(current_game.first_attack_loop);
+		current_game.strategy = strategy;
+		opponent_history.Record(opponent_id, current_game);
+		opponent_history.Close();
+	}
+
+	if (!feature_recorder.Finish(static_cast<uint32_t>(current_game.result), current_game.game_loops)) {
+		std::cerr << "Feature recording could not be written completely" << std::endl;
+	}
+	if (feature_recorder.Dropped() > 0) {
+		std::cerr << "Feature recorder dropped " << feature_recorder.Dropped() << " rows" << std::endl;
+	}
+
+	command_latency.Report(std::cout);
+	AllocProfiler::Report(std::cout);
+
+	decision_pipeline.Stop();
+	telemetry.Close();
 }
@@ -1,8 +1,28 @@
 #pragma once
 
 #include <sc2api/sc2_api.h>
+#include <chrono>
+#include <unordered_map>
 #include <vector>
+#include "baseIndex.h"
+#include "commandLatency.h"
+#include "compositionSolver.h"
+#include "damageTracker.h"
+#include "decisionPipeline.h"
+#include "enemyMemory.h"
+#include "featureRecorder.h"
+#include "opponentHistory.h"
+#include "pathfinder.h"
+#include "policyNet.h"
+#include "powerGrid.h"
+#include "productionDispatcher.h"
 #include "protossUnits.h"
+#include "scoutPlanner.h"
+#include "squadManager.h"
+#include "targetSelector.h"
+#include "telemetry.h"
+#include "visibilityGrid.h"
+#include "warmUp.h"
 
 using namespace sc2;
 
@@ -32,6 +52,7 @@ public:
 	BotState current_state = INIT;
 
 	// Track our buildings, units, and enemy units
+	std::vector<const Unit*> our_units;
 	std::vector<const Unit*> our_workers;
 	std::vector<const Unit*> our_army;
 	std::vector<const Unit*> our_production_buildings;
@@ -39,10 +60,142 @@ public:
 	std::vector<const Unit*> our_base_buildings;
 	std::vector<const Unit*> our_defensive_buildings;
 	std::vector<const Unit*> enemy_units;
+	std::vector<const Unit*> neutral_units;
+
+	// Damage our units took between observations, seen or not
+	DamageTracker damage_tracker;
+
+	// Where the defend state sends the army
+	Point2D defend_location;
+
+	// Damage within this distance of one of our Nexuses counts against that base
+	static constexpr float BASE_DEFENCE_RADIUS = 20.0f;
+
+	// Damage taken near one base within the attack window that triggers defence
+	static constexpr float BASE_DAMAGE_TRIGGER = 30.0f;
+
+	// Loops the attack window reaches back: enemies remembered near the main
+	// and damage taken within it mean we are under attack
+	static constexpr uint32_t ATTACK_WINDOW_LOOPS = 45;
+
 	Point2D enemy_base_location;
+
+	// Everything we have seen of the enemy, including units out of vision
+	EnemyMemory enemy_memory;
+
+	// Answer buffer for the per-step enemy memory queries, kept between steps
+	std::vector<const EnemySighting*> nearby_sightings;
+
+	// Which cells we see now, have ever seen, and when we last did
+	VisibilityGrid visibility;
+
+	// Placement and pylon power coverage, updated from unit events
+	PowerGrid power_grid;
+
+	// Expansion sites and which of them we hold, built at game start
+	BaseIndex base_index;
+
+	// Local ground routes, kept in step with the same unit events
+	Pathfinder pathfinder;
+
+	// Builds the map analysis above off the game thread at game start
+	WarmUp warm_up;
+	bool warm_up_adopted = false;
+
+	// Neutral units that died before the analysis was swapped in
+	std::vector<Unit> warm_up_neutral_losses;
+
+	// Production structures waiting for something to build
+	ProductionDispatcher production;
+
+	// Army mix answering the enemy units seen recently
+	CompositionSolver composition;
+
+	// How far back, in loops, enemy sightings shape the army mix: two minutes
+	static constexpr uint32_t COMPOSITION_WINDOW_LOOPS = 2688;
 	Point2D main_base_location;
 	bool scouting_initiated = false;
 
+	// Worker scout route over the enemy mains and naturals, and its progress
+	ScoutPlanner scout_planner;
+	std::vector<ScoutStop> scout_route;
+	size_t scout_stop = 0;
+	Tag scout_tag = 0;
+	uint32_t scout_route_loop = 0;
+	bool scout_swept = false;
+
+	// A stop counts as visited once seen after the route was sent or when the
+	// scout gets this close
+	static constexpr float SCOUT_STOP_RADIUS = 6.0f;
+
+	// If no main turned up, the scout sweeps this many of the regions seen
+	// longest ago, unless most of the map is explored already
+	static constexpr size_t SCOUT_SWEEP_STOPS = 4;
+	static constexpr float SCOUT_SWEEP_EXPLORED = 0.5f;
+
+	// Focus-fire assignments for the attack state
+	TargetSelector target_selector;
+
+	// Optional decision thread scoring focus-fire targets one step behind
+	bool pipelined_decisions = false;
+	DecisionPipeline decision_pipeline;
+
+	// Army clustered into squads that receive group orders
+	SquadManager squads;
+
+	// Enemies this far beyond a squad's radius are considered engaged with it
+	static constexpr float SQUAD_ENGAGE_RANGE = 12.0f;
+
+	// A squad falls back when local enemy strength exceeds its own by this factor
+	static constexpr float SQUAD_RETREAT_RATIO = 1.5f;
+
+	// A retreating squad turns back only once local enemy strength drops below its
+	// own times this factor, so it does not flip between orders around the retreat ratio
+	static constexpr float SQUAD_REENGAGE_RATIO = 1.0f;
+
+	// Opponent we are playing on the ladder, empty for local games
+	std::string opponent_id;
+
+	// Per-opponent history and the opening picked from it
+	OpponentHistory opponent_history;
+	OpeningStrategy strategy = OpeningStrategy::STANDARD;
+	OpponentGame current_game = {};
+
+	// Learned replacement for the macro branches of DetermineNextState,
+	// used when data/state_policy.bin is present
+	PolicyNet state_policy;
+	static constexpr size_t STATE_POLICY_INPUTS = 12;
+	static constexpr size_t STATE_POLICY_OUTPUTS = 4;
+
+	// Thresholds driven by the opening strategy
+	size_t attack_army_size = 15;
+	size_t army_worker_count = 16;
+
+	// Live telemetry published to shared memory every step
+	TelemetrySegment telemetry;
+	uint32_t query_count = 0;
+
+	// Per-step training data written in the background
+	FeatureRecorder feature_recorder;
+
+	// Wraps the game's action interface to time commands until they show up
+	CommandLatency command_latency;
+
+	// Game loops the coordinator should advance before our next step
+	int step_size = 1;
+
+	// Coarsest step taken while nothing needs attention
+	static constexpr int MAX_STEP_SIZE = 8;
+
+	// Enemies this close to our units mean single-loop steps
+	static constexpr float STEP_FIGHT_RANGE = 15.0f;
+
+	// Workers and structures of a base sit about this far from its town hall
+	static constexpr float STEP_BASE_EXTENT = 12.0f;
+
+	// Build time in loops of the unit or structure each ability produces
+	std::unordered_map<uint32_t, float> build_time_by_ability;
+
     
     // Called when the game starts
     virtual void OnGameStart() final;
@@ -50,6 +203,18 @@ public:
     // Called on each game step
     virtual void OnStep() final;
 
+    // Called when any unit we know of dies
+    virtual void OnUnitDestroyed(const Unit* unit) final;
+
+    // Called when one of our units or structures appears
+    virtual void OnUnitCreated(const Unit* unit) final;
+
+    // Called when one of our structures finishes construction
+    virtual void OnBuildingConstructionComplete(const Unit* building) final;
+
+    // Called when one of our units or structures runs out of orders
+    virtual void OnUnitIdle(const Unit* unit) final;
+
     // Updates our lists of units
     void UpdateUnitLists();
 
@@ -74,6 +239,40 @@ public:
     // Determines what state to transition to next
     void DetermineNextState();
 
+    // Our base that took the most damage since min_loop, if that passed
+    // BASE_DAMAGE_TRIGGER
+    bool FindBaseUnderFire(uint32_t min_loop, Point2D* where);
+
+    // Asks the state policy for the next macro state; false if it is not
+    // loaded or ran out of time, leaving the decision to the rules
+    bool PolicyState(BotState* state);
+
+    // Adjusts state thresholds for the chosen opening
+    void ApplyStrategy(OpeningStrategy opening);
+
+    // Notes opponent timings for the history record
+    void TrackOpponent();
+
+    // Whether the enemy type is army: armed, and neither a worker nor a structure
+    bool IsEnemyArmy(UnitTypeID unit_type);
+
+    // Swaps in the background map analysis once it is ready
+    void AdoptWarmUp();
+
+    // Moves the enemy base guess to another start location once the
+    // current one has been seen without enemy structures near it
+    void UpdateEnemyBaseGuess();
+
+    // Hides Agent::Actions() so every command goes through command_latency
+    ActionInterface* Actions();
+
+    // Moves the scout along its route; once the enemy main is found or
+    // the route is done, sends it back to mining
+    void UpdateScout();
+
+    // Orders the scout through the stops it has left
+    void SendScoutRoute(const Unit* scout);
+
     // Helper functions
     const Unit* FindBuilder();
 
@@ -81,12 +280,27 @@ public:
 
     Point2D FindPlacement(AbilityID ability_type_for_structure, Point2D near_to, float max_distance);
 
+    // Picks a free (and powered, where required) spot from the power grid
+    Point2D FindStructurePlacement(AbilityID ability_type_for_structure, Point2D near_to, float max_distance);
+
     Point2D GetRandomPointInCircle(const Point2D& center, float radius);
 
     float GetRandomScalar();
 
     int CountUnitType(UNIT_TYPEID unit_type);
 
+    // Picks how many loops to skip until the next step: one loop while
+    // fighting, up to MAX_STEP_SIZE when quiet, never past a pending
+    // construction or production finishing
+    int ChooseStepSize();
+
+    // Queues this step's features and commanded units for the recorder,
+    // labelled with the state whose handler issued the commands
+    void RecordFeatures(BotState acted_state);
+
+    // Publishes this step's timings and economy to the telemetry segment
+    void PublishTelemetry(std::chrono::steady_clock::time_point step_start);
+
     // This function is called when the bot's game ends
     virtual void OnGameEnd() final;
 };
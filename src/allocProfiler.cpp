@@ -0,0 +1,271 @@
+#include "allocProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#ifdef BLANKBOT_ALLOC_PROFILER
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace {
+
+const char* PHASE_NAMES[] = {"other", "observe", "unit lists", "workers", "supply", "state", "production",
+                             "decide", "record", "events"};
+
+const size_t PHASES = static_cast<size_t>(StepPhase::COUNT);
+
+#ifdef BLANKBOT_ALLOC_PROFILER
+
+struct PhaseCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    int64_t live;       // frees on another thread land there, so this can dip below zero
+    int64_t peak;       // since the step began
+};
+
+struct ThreadCounters {
+    StepPhase phase;
+    PhaseCounters phases[PHASES];
+};
+
+// Plain data, so every thread gets it zeroed without running any code
+thread_local ThreadCounters counters = {};
+
+// Keeps the block as aligned as malloc returned it
+struct alignas(16) BlockHeader {
+    uint64_t size;
+    uint32_t phase;
+};
+
+struct PhaseSummary {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t max_allocations = 0;
+    uint64_t max_bytes = 0;
+    int64_t peak_live = 0;
+    uint32_t steady_allocating = 0;
+};
+
+// Step bookkeeping, only touched from the game thread
+PhaseCounters step_start[PHASES] = {};
+PhaseAllocations last_step[PHASES];
+PhaseSummary summary[PHASES];
+uint32_t steps = 0;
+uint32_t steady_steps = 0;
+
+void* Allocate(size_t size) {
+    auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (!header)
+        return nullptr;
+
+    header->size = size;
+    header->phase = static_cast<uint32_t>(counters.phase);
+
+    PhaseCounters& phase = counters.phases[header->phase];
+    ++phase.allocations;
+    phase.bytes += size;
+    phase.live += static_cast<int64_t>(size);
+    phase.peak = std::max(phase.peak, phase.live);
+    return header + 1;
+}
+
+void Release(void* block) {
+    if (!block)
+        return;
+
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    counters.phases[header->phase].live -= static_cast<int64_t>(header->size);
+    std::free(header);
+}
+
+#endif
+
+}  // namespace
+
+#ifdef BLANKBOT_ALLOC_PROFILER
+
+// Aligned overloads are left to the library; they do not come through here
+void* operator new(size_t size) {
+    void* block = Allocate(size);
+    if (!block)
+        throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](size_t size) {
+    void* block = Allocate(size);
+    if (!block)
+        throw std::bad_alloc();
+    return block;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void* block) noexcept {
+    Release(block);
+}
+
+void operator delete[](void* block) noexcept {
+    Release(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    Release(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    Release(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    Release(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    Release(block);
+}
+
+AllocProfiler::Scope::Scope(StepPhase phase) : previous_(counters.phase) {
+    counters.phase = phase;
+}
+
+AllocProfiler::Scope::~Scope() {
+    counters.phase = previous_;
+}
+
+bool AllocProfiler::Enabled() {
+    return true;
+}
+
+void AllocProfiler::SetPhase(StepPhase phase) {
+    counters.phase = phase;
+}
+
+StepPhase AllocProfiler::Phase() {
+    return counters.phase;
+}
+
+void AllocProfiler::BeginStep() {
+    for (size_t i = 0; i < PHASES; ++i) {
+        counters.phases[i].peak = counters.phases[i].live;
+        step_start[i] = counters.phases[i];
+    }
+}
+
+void AllocProfiler::EndStep(uint32_t game_loop) {
+    counters.phase = StepPhase::OTHER;
+    bool steady = game_loop >= STEADY_LOOP;
+    ++steps;
+    if (steady)
+        ++steady_steps;
+
+    for (size_t i = 0; i < PHASES; ++i) {
+        const PhaseCounters& now = counters.phases[i];
+        PhaseAllocations& last = last_step[i];
+        last.allocations = now.allocations - step_start[i].allocations;
+        last.bytes = now.bytes - step_start[i].bytes;
+        last.peak_live = now.peak;
+
+        PhaseSummary& total = summary[i];
+        total.allocations += last.allocations;
+        total.bytes += last.bytes;
+        total.max_allocations = std::max(total.max_allocations, last.allocations);
+        total.max_bytes = std::max(total.max_bytes, last.bytes);
+        total.peak_live = std::max(total.peak_live, last.peak_live);
+        if (steady && last.allocations > 0)
+            ++total.steady_allocating;
+    }
+}
+
+PhaseAllocations AllocProfiler::LastStep(StepPhase phase) {
+    return last_step[static_cast<size_t>(phase)];
+}
+
+std::vector<StepPhase> AllocProfiler::SteadyStateAllocators() {
+    std::vector<StepPhase> phases;
+    if (steady_steps == 0)
+        return phases;
+
+    // The coordinator's own work between steps is not ours to fix
+    for (size_t i = 1; i < PHASES; ++i) {
+        if (summary[i].steady_allocating > STEADY_TOLERANCE * steady_steps)
+            phases.push_back(static_cast<StepPhase>(i));
+    }
+    return phases;
+}
+
+void AllocProfiler::Report(std::ostream& out) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Heap allocations per step over " << steps << " steps, " << steady_steps << " in steady state:"
+        << std::endl;
+    std::vector<StepPhase> flagged = SteadyStateAllocators();
+    for (size_t i = 0; i < PHASES; ++i) {
+        const PhaseSummary& total = summary[i];
+        if (total.allocations == 0 && total.peak_live <= 0)
+            continue;
+
+        out << "  " << std::left << std::setw(11) << PHASE_NAMES[i] << std::right << std::fixed
+            << std::setprecision(1) << " allocations mean " << (steps ? double(total.allocations) / steps : 0.0)
+            << " max " << total.max_allocations << ", bytes mean " << (steps ? double(total.bytes) / steps : 0.0)
+            << " max " << total.max_bytes << ", peak live " << total.peak_live << " bytes, steady steps allocating "
+            << total.steady_allocating;
+        if (std::find(flagged.begin(), flagged.end(), static_cast<StepPhase>(i)) != flagged.end())
+            out << "  <- allocates in steady state";
+        out << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+#else
+
+AllocProfiler::Scope::Scope(StepPhase phase) : previous_(phase) {
+}
+
+AllocProfiler::Scope::~Scope() {
+}
+
+bool AllocProfiler::Enabled() {
+    return false;
+}
+
+void AllocProfiler::SetPhase(StepPhase) {
+}
+
+StepPhase AllocProfiler::Phase() {
+    return StepPhase::OTHER;
+}
+
+void AllocProfiler::BeginStep() {
+}
+
+void AllocProfiler::EndStep(uint32_t) {
+}
+
+PhaseAllocations AllocProfiler::LastStep(StepPhase) {
+    return PhaseAllocations();
+}
+
+std::vector<StepPhase> AllocProfiler::SteadyStateAllocators() {
+    return {};
+}
+
+void AllocProfiler::Report(std::ostream&) {
+}
+
+#endif
+
+const char* AllocProfiler::PhaseName(StepPhase phase) {
+    size_t index = static_cast<size_t>(phase);
+    return index < PHASES ? PHASE_NAMES[index] : "unknown";
+}
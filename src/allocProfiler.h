@@ -0,0 +1,83 @@
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Part of the step loop heap allocations are charged to.
+enum class StepPhase : uint8_t {
+    OTHER,          // outside any phase: the coordinator, other threads
+    OBSERVE,        // decoding and folding in the observation
+    UNIT_LISTS,
+    WORKERS,
+    SUPPLY,
+    STATE,          // the behavior tree state handler
+    PRODUCTION,
+    DECIDE,         // state transition and step size
+    RECORD,         // features and telemetry
+    EVENTS,         // unit and game callbacks
+    COUNT
+};
+
+// Allocations made in one phase.
+struct PhaseAllocations {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    int64_t peak_live = 0;      // most bytes allocated in the phase and still live
+};
+
+// Heap allocations per step phase, for builds configured with
+// ENABLE_ALLOC_PROFILER. Global operator new and delete are replaced to
+// count into thread-local counters charged to the calling thread's current
+// phase; each block carries a small header with its size and phase so the
+// free is charged back to where it was allocated. Without the option the
+// calls below do nothing and the allocator is untouched.
+//
+// A phase counts as allocating in steady state when, after STEADY_LOOP,
+// it allocates in more than STEADY_TOLERANCE of the steps: occasional
+// growth of a reused buffer is tolerated, a per-step allocation is not.
+class AllocProfiler {
+public:
+    // One game minute: past the opening, the warm-up and early growth
+    static constexpr uint32_t STEADY_LOOP = 1344;
+    static constexpr float STEADY_TOLERANCE = 0.05f;
+
+    // Charges the enclosed allocations to a phase, restoring the previous
+    // one on exit.
+    class Scope {
+    public:
+        explicit Scope(StepPhase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        StepPhase previous_;
+    };
+
+    static bool Enabled();
+
+    // Allocations from now on are charged to phase, on this thread.
+    static void SetPhase(StepPhase phase);
+    static StepPhase Phase();
+
+    // Bracket one step on the game thread; EndStep returns to OTHER.
+    static void BeginStep();
+    static void EndStep(uint32_t game_loop);
+
+    // What a phase allocated in the last completed step.
+    static PhaseAllocations LastStep(StepPhase phase);
+
+    // Phases that allocated in steady state, see above.
+    static std::vector<StepPhase> SteadyStateAllocators();
+
+    static const char* PhaseName(StepPhase phase);
+
+    // Per-phase allocations and bytes per step, peak live bytes and the
+    // steady-state verdict.
+    static void Report(std::ostream& out);
+};
+
+#endif // ALLOC_PROFILER_H
@@ -0,0 +1,270 @@
+#include "baseIndex.h"
+
+#include "powerGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+
+using namespace sc2;
+
+namespace {
+
+// Town halls keep three cells clear of resource footprints.
+const float RESOURCE_GAP = 3.0f;
+const float TOWN_HALL_HALF = 2.5f;
+
+// How far from a cluster's center town hall spots are searched.
+const int TOWN_HALL_SEARCH = 12;
+
+struct Resource {
+    Tag tag;
+    Point2D pos;
+    bool is_geyser;
+    int minerals;
+};
+
+int Find(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// True if a town hall centered at pos keeps its distance from the resource.
+bool ClearOf(const Point2D& pos, const Resource& resource) {
+    float half_w = resource.is_geyser ? 1.5f : 1.0f;
+    float half_h = resource.is_geyser ? 1.5f : 0.5f;
+    return std::fabs(pos.x - resource.pos.x) >= TOWN_HALL_HALF + half_w + RESOURCE_GAP ||
+        std::fabs(pos.y - resource.pos.y) >= TOWN_HALL_HALF + half_h + RESOURCE_GAP;
+}
+
+bool IsTownHall(UNIT_TYPEID type) {
+    return type == UNIT_TYPEID::PROTOSS_NEXUS;
+}
+
+bool IsAssimilator(UNIT_TYPEID type) {
+    return type == UNIT_TYPEID::PROTOSS_ASSIMILATOR || type == UNIT_TYPEID::PROTOSS_ASSIMILATORRICH;
+}
+
+}  // namespace
+
+void BaseIndex::Build(const GameInfo& game_info, const Units& neutral_units,
+                      const UnitTypes& types, const PowerGrid& grid) {
+    sites_.clear();
+    site_of_.clear();
+
+    std::vector<Resource> resources;
+    for (const auto& unit : neutral_units) {
+        uint32_t id = unit->unit_type;
+        if (id >= types.size())
+            continue;
+        if (types[id].has_minerals)
+            resources.push_back({unit->tag, unit->pos, false, unit->mineral_contents});
+        else if (types[id].has_vespene)
+            resources.push_back({unit->tag, unit->pos, true, 0});
+    }
+
+    // Single-linkage clustering; a map has a couple of hundred resources
+    std::vector<int> parent(resources.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    float link_sq = CLUSTER_DISTANCE * CLUSTER_DISTANCE;
+    for (size_t i = 0; i < resources.size(); ++i) {
+        for (size_t j = i + 1; j < resources.size(); ++j) {
+            if (DistanceSquared2D(resources[i].pos, resources[j].pos) <= link_sq)
+                parent[Find(parent, static_cast<int>(i))] = Find(parent, static_cast<int>(j));
+        }
+    }
+
+    std::map<int, std::vector<const Resource*>> clusters;
+    for (size_t i = 0; i < resources.size(); ++i)
+        clusters[Find(parent, static_cast<int>(i))].push_back(&resources[i]);
+
+    for (const auto& entry : clusters) {
+        const auto& members = entry.second;
+
+        // Lone geysers or a stray patch are not a base
+        size_t patches = std::count_if(members.begin(), members.end(),
+            [](const Resource* r) { return !r->is_geyser; });
+        if (patches < 4)
+            continue;
+
+        BaseSite site;
+        site.id = static_cast<uint32_t>(sites_.size());
+        for (const auto* resource : members) {
+            site.resource_center += resource->pos;
+            if (resource->is_geyser) {
+                site.geysers.push_back(resource->tag);
+                site.assimilators.push_back(0);
+            }
+            else {
+                site.minerals.push_back(resource->tag);
+                site.remaining_minerals += static_cast<uint32_t>(std::max(resource->minerals, 0));
+            }
+        }
+        site.resource_center /= static_cast<float>(members.size());
+
+        // Town hall spot: the buildable, legal center closest to all resources
+        float best_cost = std::numeric_limits<float>::max();
+        Point2D origin(std::floor(site.resource_center.x) + 0.5f, std::floor(site.resource_center.y) + 0.5f);
+        for (int dy = -TOWN_HALL_SEARCH; dy <= TOWN_HALL_SEARCH; ++dy) {
+            for (int dx = -TOWN_HALL_SEARCH; dx <= TOWN_HALL_SEARCH; ++dx) {
+                Point2D pos(origin.x + dx, origin.y + dy);
+                if (pos.x < game_info.playable_min.x || pos.y < game_info.playable_min.y ||
+                    pos.x > game_info.playable_max.x || pos.y > game_info.playable_max.y)
+                    continue;
+
+                bool legal = std::all_of(members.begin(), members.end(),
+                    [&pos](const Resource* r) { return ClearOf(pos, *r); });
+                if (!legal || (grid.IsInitialized() && !grid.CanPlace(pos, 5, false)))
+                    continue;
+
+                float cost = 0.0f;
+                for (const auto* resource : members)
+                    cost += Distance2D(pos, resource->pos);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    site.town_hall_pos = pos;
+                }
+            }
+        }
+        if (best_cost == std::numeric_limits<float>::max())
+            site.town_hall_pos = site.resource_center;
+
+        for (const auto& start : game_info.start_locations) {
+            if (Distance2D(start, site.town_hall_pos) < CLAIM_DISTANCE) {
+                site.town_hall_pos = start;
+                site.is_start_location = true;
+            }
+        }
+
+        for (Tag tag : site.minerals)
+            site_of_[tag] = site.id;
+        for (Tag tag : site.geysers)
+            site_of_[tag] = site.id;
+        sites_.push_back(std::move(site));
+    }
+}
+
+int BaseIndex::SiteIndexNear(const Point2D& pos, float max_distance) const {
+    int best = -1;
+    float best_sq = max_distance * max_distance;
+    for (const auto& site : sites_) {
+        float distance_sq = DistanceSquared2D(site.town_hall_pos, pos);
+        if (distance_sq <= best_sq) {
+            best_sq = distance_sq;
+            best = static_cast<int>(site.id);
+        }
+    }
+    return best;
+}
+
+void BaseIndex::RecountMinerals(BaseSite& site, size_t previous_count, const ObservationInterface* observation) {
+    // Contents are only known for patches in vision; keep the old share of
+    // the rest rather than count them as empty
+    uint32_t known = 0;
+    uint32_t known_count = 0;
+    for (Tag tag : site.minerals) {
+        const Unit* patch = observation->GetUnit(tag);
+        if (patch && patch->mineral_contents > 0) {
+            known += static_cast<uint32_t>(patch->mineral_contents);
+            ++known_count;
+        }
+    }
+
+    size_t unknown_count = site.minerals.size() - known_count;
+    uint32_t per_patch = previous_count > 0 ? site.remaining_minerals / static_cast<uint32_t>(previous_count) : 0;
+    site.remaining_minerals = known + per_patch * static_cast<uint32_t>(unknown_count);
+}
+
+void BaseIndex::OnStructureCreated(const Unit* unit, const ObservationInterface* observation) {
+    if (IsTownHall(unit->unit_type)) {
+        int index = SiteIndexNear(unit->pos, CLAIM_DISTANCE);
+        if (index < 0)
+            return;
+
+        BaseSite& site = sites_[index];
+        site.town_hall = unit->tag;
+        site.town_hall_pos = unit->pos;
+        site_of_[unit->tag] = site.id;
+        RecountMinerals(site, site.minerals.size(), observation);
+        return;
+    }
+
+    if (!IsAssimilator(unit->unit_type))
+        return;
+
+    for (auto& site : sites_) {
+        for (size_t i = 0; i < site.geysers.size(); ++i) {
+            const Unit* geyser = observation->GetUnit(site.geysers[i]);
+            if (geyser && DistanceSquared2D(geyser->pos, unit->pos) < 1.0f) {
+                site.assimilators[i] = unit->tag;
+                site_of_[unit->tag] = site.id;
+                return;
+            }
+        }
+    }
+}
+
+void BaseIndex::OnStructureDestroyed(const Unit* unit) {
+    auto it = site_of_.find(unit->tag);
+    if (it == site_of_.end())
+        return;
+
+    BaseSite& site = sites_[it->second];
+    if (site.town_hall == unit->tag)
+        site.town_hall = 0;
+    std::replace(site.assimilators.begin(), site.assimilators.end(), unit->tag, Tag(0));
+    site_of_.erase(it);
+}
+
+void BaseIndex::OnResourceDepleted(Tag tag, const ObservationInterface* observation) {
+    auto it = site_of_.find(tag);
+    if (it == site_of_.end())
+        return;
+
+    BaseSite& site = sites_[it->second];
+    site_of_.erase(it);
+
+    auto mineral = std::find(site.minerals.begin(), site.minerals.end(), tag);
+    if (mineral != site.minerals.end()) {
+        site.minerals.erase(mineral);
+        RecountMinerals(site, site.minerals.size() + 1, observation);
+        return;
+    }
+
+    // A geyser never leaves the map, but keep the lists consistent if it does
+    auto geyser = std::find(site.geysers.begin(), site.geysers.end(), tag);
+    if (geyser != site.geysers.end()) {
+        size_t i = geyser - site.geysers.begin();
+        site.geysers.erase(geyser);
+        site.assimilators.erase(site.assimilators.begin() + i);
+    }
+}
+
+const BaseSite* BaseIndex::SiteOf(Tag tag) const {
+    auto it = site_of_.find(tag);
+    return it != site_of_.end() ? &sites_[it->second] : nullptr;
+}
+
+const BaseSite* BaseIndex::NearestSite(const Point2D& pos) const {
+    int index = SiteIndexNear(pos, std::numeric_limits<float>::infinity());
+    return index >= 0 ? &sites_[index] : nullptr;
+}
+
+void BaseIndex::FreeGeysers(const BaseSite& site, std::vector<Tag>* out) const {
+    for (size_t i = 0; i < site.geysers.size(); ++i) {
+        if (site.assimilators[i] == 0)
+            out->push_back(site.geysers[i]);
+    }
+}
+
+void BaseIndex::OwnedSites(std::vector<const BaseSite*>* out) const {
+    for (const auto& site : sites_) {
+        if (site.town_hall != 0)
+            out->push_back(&site);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef BASE_INDEX_H
+#define BASE_INDEX_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class PowerGrid;
+
+// One expansion site: a cluster of mineral fields and geysers.
+struct BaseSite {
+    uint32_t id = 0;
+    sc2::Point2D resource_center;
+    sc2::Point2D town_hall_pos;         // where a Nexus fits best
+    std::vector<sc2::Tag> minerals;     // patches still on the map
+    std::vector<sc2::Tag> geysers;
+    std::vector<sc2::Tag> assimilators; // per geyser, 0 if none
+    sc2::Tag town_hall = 0;             // our Nexus here, 0 if none
+    uint32_t remaining_minerals = 0;    // as of the last event touching the site
+    bool is_start_location = false;
+};
+
+// Expansion sites found once at game start by clustering resources.
+// Sites are only touched when a patch runs out or a Nexus or assimilator
+// is placed or lost, so "patches of base B" and "free geysers at base B"
+// are plain lookups.
+class BaseIndex {
+public:
+    // Clusters the neutral resources into sites. The grid, if initialized,
+    // rules out town hall spots that are not buildable.
+    void Build(const sc2::GameInfo& game_info, const sc2::Units& neutral_units,
+               const sc2::UnitTypes& types, const PowerGrid& grid);
+
+    // Our Nexus or assimilator appeared.
+    void OnStructureCreated(const sc2::Unit* unit, const sc2::ObservationInterface* observation);
+
+    // Our Nexus or assimilator was destroyed.
+    void OnStructureDestroyed(const sc2::Unit* unit);
+
+    // A mineral field or geyser left the map.
+    void OnResourceDepleted(sc2::Tag tag, const sc2::ObservationInterface* observation);
+
+    const std::vector<BaseSite>& Sites() const { return sites_; }
+
+    // Site owning a resource, assimilator or Nexus, nullptr if none.
+    const BaseSite* SiteOf(sc2::Tag tag) const;
+
+    // Site whose town hall spot is closest to pos.
+    const BaseSite* NearestSite(const sc2::Point2D& pos) const;
+
+    // Geysers at a site without an assimilator.
+    void FreeGeysers(const BaseSite& site, std::vector<sc2::Tag>* out) const;
+
+    // Sites with one of our Nexuses on them.
+    void OwnedSites(std::vector<const BaseSite*>* out) const;
+
+private:
+    // Resources closer than this belong to the same site.
+    static constexpr float CLUSTER_DISTANCE = 8.0f;
+
+    // A Nexus within this distance of a site's spot takes the site.
+    static constexpr float CLAIM_DISTANCE = 6.0f;
+
+    // Re-sums a site's minerals after its patch list went from previous_count
+    void RecountMinerals(BaseSite& site, size_t previous_count, const sc2::ObservationInterface* observation);
+    int SiteIndexNear(const sc2::Point2D& pos, float max_distance) const;
+
+    std::vector<BaseSite> sites_;
+    std::unordered_map<sc2::Tag, uint32_t> site_of_;     // any indexed tag -> site
+};
+
+#endif // BASE_INDEX_H
@@ -0,0 +1,241 @@
+#include "commandLatency.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace sc2;
+
+namespace {
+
+const char* SOURCE_NAMES[] = {"workers", "supply", "economy", "army", "attack", "defend", "scout", "production"};
+
+void WriteLatency(std::ostream& out, uint32_t loops) {
+    if (loops + 1 >= CommandLatency::BUCKETS)
+        out << loops << "+";
+    else
+        out << loops;
+}
+
+void WriteStats(std::ostream& out, const CommandLatency::Stats& stats) {
+    uint32_t resolved = stats.seen + stats.dropped;
+    out << "issued " << stats.issued << ", seen " << stats.seen << ", dropped " << stats.dropped << " ("
+        << std::fixed << std::setprecision(1) << (resolved > 0 ? 100.0f * stats.dropped / resolved : 0.0f)
+        << "%), superseded " << stats.superseded << ", lost " << stats.lost;
+    if (stats.seen == 0)
+        return;
+
+    out << "; loops mean " << std::setprecision(2) << static_cast<double>(stats.total_latency) / stats.seen
+        << " p50 ";
+    WriteLatency(out, stats.Percentile(0.5f));
+    out << " p90 ";
+    WriteLatency(out, stats.Percentile(0.9f));
+    out << " max " << stats.max_latency;
+}
+
+}  // namespace
+
+uint32_t CommandLatency::Stats::Percentile(float share) const {
+    uint32_t wanted = static_cast<uint32_t>(share * seen + 0.5f);
+    uint32_t count = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        count += histogram[i];
+        if (count >= wanted && count > 0)
+            return static_cast<uint32_t>(i);
+    }
+    return BUCKETS - 1;
+}
+
+void CommandLatency::Attach(ActionInterface* actions) {
+    actions_ = actions;
+    source_ = CommandSource::WORKERS;
+    game_loop_ = 0;
+    pending_.clear();
+    by_ability_.clear();
+    by_source_ = {};
+}
+
+void CommandLatency::Count(Stats* stats, Outcome outcome, uint32_t latency) {
+    switch (outcome) {
+        case Outcome::SEEN:
+            ++stats->seen;
+            stats->total_latency += latency;
+            stats->max_latency = std::max(stats->max_latency, latency);
+            ++stats->histogram[std::min<size_t>(latency, BUCKETS - 1)];
+            break;
+        case Outcome::DROPPED:
+            ++stats->dropped;
+            break;
+        case Outcome::SUPERSEDED:
+            ++stats->superseded;
+            break;
+        case Outcome::LOST:
+            ++stats->lost;
+            break;
+    }
+}
+
+void CommandLatency::Resolve(const PendingCommand& command, Outcome outcome, uint32_t latency) {
+    Count(&by_ability_[command.ability], outcome, latency);
+    Count(&by_source_[static_cast<size_t>(command.source)], outcome, latency);
+}
+
+void CommandLatency::Track(const Unit* unit, AbilityID ability, bool queued) {
+    if (!unit)
+        return;
+
+    // An unqueued command replaces whatever the unit was told before
+    if (!queued) {
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->tag == unit->tag) {
+                Resolve(*it, Outcome::SUPERSEDED, 0);
+                it = pending_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    PendingCommand command = {unit->tag, static_cast<uint32_t>(ability), game_loop_, source_};
+    pending_.push_back(command);
+    ++by_ability_[command.ability].issued;
+    ++by_source_[static_cast<size_t>(source_)].issued;
+}
+
+void CommandLatency::Observe(const ObservationInterface* observation) {
+    game_loop_ = observation->GetGameLoop();
+    if (pending_.empty())
+        return;
+
+    // Orders report the specific ability, e.g. ATTACK_ATTACK for an issued ATTACK
+    const Abilities& abilities = observation->GetAbilityData();
+
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        const PendingCommand& command = pending_[i];
+        uint32_t latency = game_loop_ - command.issued_loop;
+        if (game_loop_ <= command.issued_loop) {
+            pending_[kept++] = command;
+            continue;
+        }
+
+        const Unit* unit = observation->GetUnit(command.tag);
+        if (!unit || !unit->is_alive) {
+            Resolve(command, Outcome::LOST, latency);
+            continue;
+        }
+
+        bool seen = std::any_of(unit->orders.begin(), unit->orders.end(), [&](const UnitOrder& order) {
+            uint32_t id = static_cast<uint32_t>(order.ability_id);
+            uint32_t general = id < abilities.size() ? abilities[id].remaps_to_ability_id : 0;
+            return id == command.ability || (general != 0 && general == command.ability);
+        });
+
+        if (seen)
+            Resolve(command, Outcome::SEEN, latency);
+        else if (latency >= TIMEOUT_LOOPS)
+            Resolve(command, Outcome::DROPPED, latency);
+        else
+            pending_[kept++] = command;
+    }
+    pending_.resize(kept);
+}
+
+void CommandLatency::Report(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    std::vector<std::pair<uint32_t, const Stats*>> abilities;
+    for (const auto& entry : by_ability_)
+        abilities.push_back({entry.first, &entry.second});
+    std::sort(abilities.begin(), abilities.end(), [](const auto& a, const auto& b) {
+        return a.second->issued != b.second->issued ? a.second->issued > b.second->issued : a.first < b.first;
+    });
+
+    out << "Command latency by ability:" << std::endl;
+    for (const auto& entry : abilities) {
+        const Stats& stats = *entry.second;
+        out << "  " << AbilityTypeToName(AbilityID(entry.first)) << ": ";
+        WriteStats(out, stats);
+        out << std::endl;
+        if (stats.seen == 0)
+            continue;
+
+        out << "    loops";
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            if (stats.histogram[i] == 0)
+                continue;
+            out << " ";
+            WriteLatency(out, static_cast<uint32_t>(i));
+            out << ":" << stats.histogram[i];
+        }
+        out << std::endl;
+    }
+
+    out << "Command latency by source:" << std::endl;
+    for (size_t i = 0; i < by_source_.size(); ++i) {
+        if (by_source_[i].issued == 0)
+            continue;
+        out << "  " << SOURCE_NAMES[i] << ": ";
+        WriteStats(out, by_source_[i]);
+        out << std::endl;
+    }
+    if (!pending_.empty())
+        out << "  " << pending_.size() << " commands still pending" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void CommandLatency::UnitCommand(const Unit* unit, AbilityID ability, bool queued_command) {
+    Track(unit, ability, queued_command);
+    actions_->UnitCommand(unit, ability, queued_command);
+}
+
+void CommandLatency::UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command) {
+    Track(unit, ability, queued_command);
+    actions_->UnitCommand(unit, ability, point, queued_command);
+}
+
+void CommandLatency::UnitCommand(const Unit* unit, AbilityID ability, const Unit* target, bool queued_command) {
+    Track(unit, ability, queued_command);
+    actions_->UnitCommand(unit, ability, target, queued_command);
+}
+
+void CommandLatency::UnitCommand(const Units& units, AbilityID ability, bool queued_move) {
+    for (const auto& unit : units)
+        Track(unit, ability, queued_move);
+    actions_->UnitCommand(units, ability, queued_move);
+}
+
+void CommandLatency::UnitCommand(const Units& units, AbilityID ability, const Point2D& point, bool queued_command) {
+    for (const auto& unit : units)
+        Track(unit, ability, queued_command);
+    actions_->UnitCommand(units, ability, point, queued_command);
+}
+
+void CommandLatency::UnitCommand(const Units& units, AbilityID ability, const Unit* target, bool queued_command) {
+    for (const auto& unit : units)
+        Track(unit, ability, queued_command);
+    actions_->UnitCommand(units, ability, target, queued_command);
+}
+
+const std::vector<Tag>& CommandLatency::Commands() const {
+    return actions_->Commands();
+}
+
+void CommandLatency::ToggleAutocast(Tag unit_tag, AbilityID ability) {
+    actions_->ToggleAutocast(unit_tag, ability);
+}
+
+void CommandLatency::ToggleAutocast(const std::vector<Tag>& unit_tags, AbilityID ability) {
+    actions_->ToggleAutocast(unit_tags, ability);
+}
+
+void CommandLatency::SendChat(const std::string& message, ChatChannel channel) {
+    actions_->SendChat(message, channel);
+}
+
+void CommandLatency::SendActions() {
+    actions_->SendActions();
+}
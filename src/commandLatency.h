@@ -0,0 +1,112 @@
+#ifndef COMMAND_LATENCY_H
+#define COMMAND_LATENCY_H
+
+#include <sc2api/sc2_api.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Part of the bot a command came from.
+enum class CommandSource : uint8_t {
+    WORKERS,
+    SUPPLY,
+    ECONOMY,
+    ARMY,
+    ATTACK,
+    DEFEND,
+    SCOUT,
+    PRODUCTION,
+    COUNT
+};
+
+// Measures how long commands take to show up on the units they were sent
+// to. Sits in front of the game's action interface: every unit command is
+// forwarded unchanged and remembered with the loop it was issued on and
+// the source set at the time. Each observation then looks for the ability
+// among the orders of the commanded unit. A command counts as seen on the
+// first observation that shows it, as dropped if it is not seen within
+// TIMEOUT_LOOPS, and as superseded if a later unqueued command for the
+// same unit replaces it first. Orders that finish before the next
+// observation, such as very short moves, look the same as drops.
+class CommandLatency : public sc2::ActionInterface {
+public:
+    // Loops after which an unseen command is counted as dropped
+    static constexpr uint32_t TIMEOUT_LOOPS = 112;
+
+    // Histogram buckets: one per loop of latency, the last takes the rest
+    static constexpr size_t BUCKETS = 17;
+
+    struct Stats {
+        uint32_t issued = 0;
+        uint32_t seen = 0;
+        uint32_t dropped = 0;
+        uint32_t superseded = 0;
+        uint32_t lost = 0;              // the unit died first
+        uint64_t total_latency = 0;     // over seen commands
+        uint32_t max_latency = 0;
+        std::array<uint32_t, BUCKETS> histogram = {};
+
+        // Latency below which the given share of seen commands fall.
+        uint32_t Percentile(float share) const;
+    };
+
+    // Forwards to actions from now on and forgets everything measured.
+    void Attach(sc2::ActionInterface* actions);
+
+    // Commands issued from now on are attributed to source.
+    void SetSource(CommandSource source) { source_ = source; }
+
+    // Matches pending commands against this observation's unit orders.
+    void Observe(const sc2::ObservationInterface* observation);
+
+    // Per-ability histograms and drop rates, then totals per source.
+    void Report(std::ostream& out) const;
+
+    size_t Pending() const { return pending_.size(); }
+    const Stats& BySource(CommandSource source) const { return by_source_[static_cast<size_t>(source)]; }
+
+    void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, bool queued_command = false) override;
+    void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Point2D& point,
+                     bool queued_command = false) override;
+    void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Unit* target,
+                     bool queued_command = false) override;
+    void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, bool queued_move = false) override;
+    void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Point2D& point,
+                     bool queued_command = false) override;
+    void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Unit* target,
+                     bool queued_command = false) override;
+
+    const std::vector<sc2::Tag>& Commands() const override;
+    void ToggleAutocast(sc2::Tag unit_tag, sc2::AbilityID ability) override;
+    void ToggleAutocast(const std::vector<sc2::Tag>& unit_tags, sc2::AbilityID ability) override;
+    void SendChat(const std::string& message, sc2::ChatChannel channel = sc2::ChatChannel::All) override;
+    void SendActions() override;
+
+private:
+    struct PendingCommand {
+        sc2::Tag tag;
+        uint32_t ability;
+        uint32_t issued_loop;
+        CommandSource source;
+    };
+
+    enum class Outcome { SEEN, DROPPED, SUPERSEDED, LOST };
+
+    void Track(const sc2::Unit* unit, sc2::AbilityID ability, bool queued);
+    void Resolve(const PendingCommand& command, Outcome outcome, uint32_t latency);
+    static void Count(Stats* stats, Outcome outcome, uint32_t latency);
+
+    sc2::ActionInterface* actions_ = nullptr;
+    CommandSource source_ = CommandSource::WORKERS;
+    uint32_t game_loop_ = 0;
+
+    std::vector<PendingCommand> pending_;
+    std::unordered_map<uint32_t, Stats> by_ability_;
+    std::array<Stats, static_cast<size_t>(CommandSource::COUNT)> by_source_ = {};
+};
+
+#endif // COMMAND_LATENCY_H
@@ -0,0 +1,259 @@
+#include "compositionSolver.h"
+
+#include "unitStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sc2;
+
+namespace {
+
+// Seconds a candidate is assumed to last against something that cannot
+// shoot back, so harmless targets do not dominate the cover
+const float LIFE_CAP = 30.0f;
+
+// Used until an enemy type has been seen at full health
+const float DEFAULT_DURABILITY = 100.0f;
+
+// Times the enemy army is assumed to double while filling one batch
+const int MAX_RAISES = 8;
+
+// Floor on enemy value so free units (broodlings, interceptors) still count
+const float MIN_VALUE = 25.0f;
+
+}  // namespace
+
+const CompositionSolver::Candidate CompositionSolver::CANDIDATES[CANDIDATE_COUNT] = {
+    {UNIT_TYPEID::PROTOSS_ZEALOT, 150.0f, GATEWAY, false, false, false},
+    {UNIT_TYPEID::PROTOSS_ADEPT, 140.0f, GATEWAY, true, false, false},
+    {UNIT_TYPEID::PROTOSS_STALKER, 160.0f, GATEWAY, true, false, false},
+    {UNIT_TYPEID::PROTOSS_IMMORTAL, 300.0f, ROBOTICS, false, false, false},
+    {UNIT_TYPEID::PROTOSS_COLOSSUS, 350.0f, ROBOTICS, false, true, false},
+    {UNIT_TYPEID::PROTOSS_PHOENIX, 180.0f, STARGATE, false, false, true},
+    {UNIT_TYPEID::PROTOSS_VOIDRAY, 250.0f, STARGATE, false, false, true},
+};
+
+void CompositionSolver::Initialize(const UnitTypes& types) {
+    matchups_.assign(types.size(), Matchup());
+    cost_.fill(0.0f);
+    for (size_t c = 0; c < CANDIDATE_COUNT; ++c) {
+        uint32_t id = static_cast<uint32_t>(CANDIDATES[c].type);
+        if (id < types.size())
+            cost_[c] = static_cast<float>(types[id].mineral_cost + types[id].vespene_cost);
+    }
+
+    for (size_t t = 0; t < types.size(); ++t) {
+        const UnitTypeData& theirs = types[t];
+        Matchup& matchup = matchups_[t];
+        matchup.value = std::max(MIN_VALUE, static_cast<float>(theirs.mineral_cost + theirs.vespene_cost));
+        matchup.army = UnitStats::IsArmy(static_cast<uint32_t>(t), types);
+
+        for (size_t c = 0; c < CANDIDATE_COUNT; ++c) {
+            uint32_t id = static_cast<uint32_t>(CANDIDATES[c].type);
+            if (id >= types.size())
+                continue;
+            const UnitTypeData& ours = types[id];
+            matchup.dealt[c][0] = UnitStats::Dps(ours, theirs, false);
+            matchup.dealt[c][1] = UnitStats::Dps(ours, theirs, true);
+            matchup.taken[c] = UnitStats::Dps(theirs, ours, CANDIDATES[c].is_flying);
+        }
+    }
+
+    groups_.clear();
+    solved_groups_.clear();
+    solved_ = false;
+    mix_.clear();
+}
+
+bool CompositionSolver::Available(const Candidate& candidate, const ProductionCapacity& capacity) const {
+    if (candidate.needs_core && !capacity.cybernetics_core)
+        return false;
+    if (candidate.needs_bay && !capacity.robotics_bay)
+        return false;
+
+    switch (candidate.producer) {
+        case GATEWAY:
+            return capacity.gateways > 0;
+        case ROBOTICS:
+            return capacity.robotics > 0;
+        case STARGATE:
+            return capacity.stargates > 0;
+        default:
+            return false;
+    }
+}
+
+float CompositionSolver::Kills(size_t candidate, const Group& group) const {
+    const Matchup& matchup = matchups_[group.type];
+    float dealt = matchup.dealt[candidate][group.is_flying ? 1 : 0];
+    if (dealt <= 0.0f)
+        return 0.0f;
+
+    float taken = matchup.taken[candidate];
+    float life = taken > 0.0f ? std::min(LIFE_CAP, CANDIDATES[candidate].durability / taken) : LIFE_CAP;
+
+    auto durability = durability_.find(group.type);
+    float health = durability != durability_.end() && durability->second > 0.0f ? durability->second : DEFAULT_DURABILITY;
+    return dealt * life / health;
+}
+
+bool CompositionSolver::Update(const std::vector<const EnemySighting*>& enemies, const ProductionCapacity& capacity) {
+    if (!IsInitialized()) {
+        if (solved_ && capacity == solved_capacity_)
+            return false;
+        Fallback(capacity);
+        solved_capacity_ = capacity;
+        solved_ = true;
+        return true;
+    }
+
+    groups_.clear();
+    for (const auto* enemy : enemies) {
+        uint32_t type = enemy->unit_type;
+        if (type >= matchups_.size() || !matchups_[type].army)
+            continue;
+
+        float& durability = durability_[type];
+        durability = std::max(durability, enemy->health + enemy->shield);
+
+        auto group = std::find_if(groups_.begin(), groups_.end(), [type, enemy](const Group& g) {
+            return g.type == type && g.is_flying == enemy->is_flying;
+        });
+        if (group == groups_.end()) {
+            groups_.push_back({type, enemy->is_flying, 0, 0.0f});
+            group = groups_.end() - 1;
+        }
+        ++group->count;
+        group->value += matchups_[type].value;
+    }
+
+    if (solved_ && !Changed(capacity))
+        return false;
+
+    Solve(capacity);
+    solved_groups_ = groups_;
+    solved_capacity_ = capacity;
+    solved_ = true;
+    ++solves_;
+    return true;
+}
+
+bool CompositionSolver::Changed(const ProductionCapacity& capacity) const {
+    if (!(capacity == solved_capacity_))
+        return true;
+
+    float now = 0.0f;
+    float before = 0.0f;
+    float moved = 0.0f;
+    for (const auto& group : groups_) {
+        now += group.value;
+        auto old = std::find_if(solved_groups_.begin(), solved_groups_.end(), [&group](const Group& g) {
+            return g.type == group.type && g.is_flying == group.is_flying;
+        });
+        moved += std::fabs(group.value - (old != solved_groups_.end() ? old->value : 0.0f));
+    }
+    for (const auto& old : solved_groups_) {
+        before += old.value;
+        auto group = std::find_if(groups_.begin(), groups_.end(), [&old](const Group& g) {
+            return g.type == old.type && g.is_flying == old.is_flying;
+        });
+        if (group == groups_.end())
+            moved += old.value;
+    }
+
+    float total = std::max(now, before);
+    return total > 0.0f && moved / total > CHANGE_THRESHOLD;
+}
+
+void CompositionSolver::Solve(const ProductionCapacity& capacity) {
+    int producers[PRODUCER_COUNT] = {capacity.gateways, capacity.robotics, capacity.stargates};
+    int total_producers = capacity.gateways + capacity.robotics + capacity.stargates;
+    if (groups_.empty() || total_producers == 0) {
+        Fallback(capacity);
+        return;
+    }
+
+    // Each kind of structure gets a share of the batch matching its count
+    int limit[PRODUCER_COUNT];
+    for (int p = 0; p < PRODUCER_COUNT; ++p)
+        limit[p] = (BATCH * producers[p] + total_producers - 1) / total_producers;
+
+    std::vector<float> need(groups_.size());
+    for (size_t g = 0; g < groups_.size(); ++g)
+        need[g] = groups_[g].value;
+    std::vector<float> covered(groups_.size(), 0.0f);
+    std::array<int, CANDIDATE_COUNT> picks{};
+    int used[PRODUCER_COUNT] = {};
+    int picked = 0;
+    int raises = 0;
+
+    while (picked < BATCH) {
+        size_t best = CANDIDATE_COUNT;
+        float best_gain = 0.0f;
+        for (size_t c = 0; c < CANDIDATE_COUNT; ++c) {
+            const Candidate& candidate = CANDIDATES[c];
+            if (!Available(candidate, capacity) || used[candidate.producer] >= limit[candidate.producer] || cost_[c] <= 0.0f)
+                continue;
+
+            float gain = 0.0f;
+            for (size_t g = 0; g < groups_.size(); ++g) {
+                float add = Kills(c, groups_[g]) * groups_[g].value / groups_[g].count;
+                gain += std::min(need[g], covered[g] + add) - std::min(need[g], covered[g]);
+            }
+            gain /= cost_[c];
+            if (gain > best_gain) {
+                best_gain = gain;
+                best = c;
+            }
+        }
+
+        // Everything is answered: plan for the enemy army growing, so the
+        // rest of the batch still spreads over our other structures
+        if (best == CANDIDATE_COUNT) {
+            if (picked == 0 || ++raises > MAX_RAISES)
+                break;
+            for (auto& value : need)
+                value *= 2.0f;
+            continue;
+        }
+
+        for (size_t g = 0; g < groups_.size(); ++g)
+            covered[g] += Kills(best, groups_[g]) * groups_[g].value / groups_[g].count;
+        ++picks[best];
+        ++used[CANDIDATES[best].producer];
+        ++picked;
+    }
+
+    if (picked == 0) {
+        Fallback(capacity);
+        return;
+    }
+
+    mix_.clear();
+    for (size_t c = 0; c < CANDIDATE_COUNT; ++c) {
+        if (picks[c] > 0)
+            mix_.push_back({CANDIDATES[c].type, static_cast<float>(picks[c]) / picked});
+    }
+    std::sort(mix_.begin(), mix_.end(), [](const std::pair<UNIT_TYPEID, float>& a, const std::pair<UNIT_TYPEID, float>& b) {
+        return a.second > b.second;
+    });
+}
+
+void CompositionSolver::Fallback(const ProductionCapacity& capacity) {
+    // Nothing seen worth answering yet: a general-purpose gateway army
+    mix_.clear();
+    if (capacity.gateways > 0 && capacity.cybernetics_core) {
+        mix_.push_back({UNIT_TYPEID::PROTOSS_STALKER, 0.5f});
+        mix_.push_back({UNIT_TYPEID::PROTOSS_ZEALOT, 0.5f});
+    }
+    else if (capacity.gateways > 0) {
+        mix_.push_back({UNIT_TYPEID::PROTOSS_ZEALOT, 1.0f});
+    }
+    else if (capacity.robotics > 0) {
+        mix_.push_back({UNIT_TYPEID::PROTOSS_IMMORTAL, 1.0f});
+    }
+    else if (capacity.stargates > 0) {
+        mix_.push_back({UNIT_TYPEID::PROTOSS_VOIDRAY, 1.0f});
+    }
+}
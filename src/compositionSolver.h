@@ -0,0 +1,118 @@
+#ifndef COMPOSITION_SOLVER_H
+#define COMPOSITION_SOLVER_H
+
+#include "enemyMemory.h"
+
+#include <sc2api/sc2_api.h>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Finished production and tech that decide what we can train.
+struct ProductionCapacity {
+    int gateways = 0;           // gateways and warp gates
+    int robotics = 0;
+    int stargates = 0;
+    bool cybernetics_core = false;
+    bool robotics_bay = false;
+
+    bool operator==(const ProductionCapacity& other) const {
+        return gateways == other.gateways && robotics == other.robotics && stargates == other.stargates &&
+            cybernetics_core == other.cybernetics_core && robotics_bay == other.robotics_bay;
+    }
+};
+
+// Picks the mix of army units to train against what the enemy has shown.
+// Damage per second between each of our candidate units and every unit
+// type, both ways, is precomputed from the unit type data with attribute
+// bonuses, armor and air/ground reach. Solving is a greedy cover over a
+// batch of units: each pick is the candidate that answers the most enemy
+// value not yet answered per resource spent, within a share of the batch
+// proportional to how many structures can make it. It runs in
+// microseconds, and only when the enemy composition or our tech changed
+// enough to matter.
+class CompositionSolver {
+public:
+    static constexpr size_t CANDIDATE_COUNT = 7;
+
+    // Units planned per solve; only the proportions are used
+    static constexpr int BATCH = 24;
+
+    // Share of enemy value that has to move before the mix is re-solved
+    static constexpr float CHANGE_THRESHOLD = 0.2f;
+
+    // Precomputes the matchup table.
+    void Initialize(const sc2::UnitTypes& types);
+
+    // Folds in recently seen enemy army, leaving out workers and static
+    // defence, and re-solves if it or our capacity changed enough. True if
+    // the mix was recomputed.
+    bool Update(const std::vector<const EnemySighting*>& enemies, const ProductionCapacity& capacity);
+
+    // Share of each unit in the current mix, largest first.
+    const std::vector<std::pair<sc2::UNIT_TYPEID, float>>& Mix() const { return mix_; }
+
+    uint64_t Solves() const { return solves_; }
+    bool IsInitialized() const { return !matchups_.empty(); }
+
+private:
+    enum Producer {
+        GATEWAY,
+        ROBOTICS,
+        STARGATE,
+        PRODUCER_COUNT
+    };
+
+    struct Candidate {
+        sc2::UNIT_TYPEID type;
+        float durability;       // hit points plus shields
+        Producer producer;
+        bool needs_core;
+        bool needs_bay;
+        bool is_flying;
+    };
+
+    struct Matchup {
+        std::array<std::array<float, 2>, CANDIDATE_COUNT> dealt{};  // by the candidate, vs ground [0] or air [1]
+        std::array<float, CANDIDATE_COUNT> taken{};                 // by this type to the candidate
+        float value = 0.0f;                                         // minerals plus vespene
+        bool army = false;                                          // see UnitStats::IsArmy
+    };
+
+    // Enemies of one type and layer
+    struct Group {
+        uint32_t type;
+        bool is_flying;
+        int count;
+        float value;
+    };
+
+    static const Candidate CANDIDATES[CANDIDATE_COUNT];
+
+    bool Available(const Candidate& candidate, const ProductionCapacity& capacity) const;
+    bool Changed(const ProductionCapacity& capacity) const;
+    void Solve(const ProductionCapacity& capacity);
+    void Fallback(const ProductionCapacity& capacity);
+
+    // Enemy units of this group one candidate kills over its lifetime
+    float Kills(size_t candidate, const Group& group) const;
+
+    std::vector<Matchup> matchups_;     // by unit type id
+    std::array<float, CANDIDATE_COUNT> cost_{};
+
+    // Most hit points plus shields seen per enemy type
+    std::unordered_map<uint32_t, float> durability_;
+
+    std::vector<Group> groups_;
+    std::vector<Group> solved_groups_;
+    ProductionCapacity solved_capacity_;
+    bool solved_ = false;
+
+    std::vector<std::pair<sc2::UNIT_TYPEID, float>> mix_;
+    uint64_t solves_ = 0;
+};
+
+#endif // COMPOSITION_SOLVER_H
@@ -0,0 +1,64 @@
+#include "damageTracker.h"
+
+#include <algorithm>
+
+namespace {
+
+// Game loops per second on faster speed
+const float LOOPS_PER_SECOND = 22.4f;
+
+}  // namespace
+
+void DamageTracker::Reset() {
+    written_ = 0;
+    previous_.clear();
+}
+
+void DamageTracker::Append(const DamageEvent& event) {
+    ring_[written_ % CAPACITY] = event;
+    ++written_;
+}
+
+void DamageTracker::Observe(const std::vector<const sc2::Unit*>& own, uint32_t game_loop) {
+    for (const sc2::Unit* unit : own) {
+        float health = unit->health + unit->shield;
+        auto found = previous_.find(unit->tag);
+        if (found == previous_.end()) {
+            previous_.emplace(unit->tag, Previous{health, game_loop});
+            continue;
+        }
+
+        Previous& previous = found->second;
+        float lost = previous.health - health;
+        if (lost >= MIN_DAMAGE && game_loop > previous.game_loop) {
+            DamageEvent event;
+            event.tag = unit->tag;
+            event.x = unit->pos.x;
+            event.y = unit->pos.y;
+            event.damage = lost;
+            event.dps = lost * LOOPS_PER_SECOND / (game_loop - previous.game_loop);
+            event.game_loop = game_loop;
+            event.unit_type = static_cast<uint32_t>(unit->unit_type);
+            Append(event);
+        }
+        previous.health = health;
+        previous.game_loop = game_loop;
+    }
+
+    // Units that were not in this observation are gone
+    for (auto it = previous_.begin(); it != previous_.end();) {
+        if (it->second.game_loop != game_loop)
+            it = previous_.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t DamageTracker::Read(uint64_t* cursor, std::vector<DamageEvent>* out) const {
+    uint64_t oldest = written_ > CAPACITY ? written_ - CAPACITY : 0;
+    uint64_t from = std::max(*cursor, oldest);
+    for (uint64_t i = from; i < written_; ++i)
+        out->push_back(ring_[i % CAPACITY]);
+    *cursor = written_;
+    return static_cast<size_t>(written_ - from);
+}
@@ -0,0 +1,75 @@
+#ifndef DAMAGE_TRACKER_H
+#define DAMAGE_TRACKER_H
+
+#include <sc2api/sc2_unit.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// One of our units lost hit points or shields between two observations.
+struct DamageEvent {
+    uint64_t tag = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    float damage = 0.0f;        // hit points plus shields lost
+    float dps = 0.0f;           // damage over the time since the previous observation
+    uint32_t game_loop = 0;
+    uint32_t unit_type = 0;
+};
+
+// Notices our units taking damage, whoever dealt it and wherever it
+// happened. Health plus shields of every one of our units is diffed against the previous observation; drops become events in a
+// fixed-size ring, so consumers read what happened since they last looked
+// instead of scanning every unit against every enemy.
+class DamageTracker {
+public:
+    static constexpr uint32_t CAPACITY = 1024;
+
+    // Drops below this are rounding or regeneration noise.
+    static constexpr float MIN_DAMAGE = 1.0f;
+
+    DamageTracker() : ring_(CAPACITY) {}
+
+    // Forgets all units and events.
+    void Reset();
+
+    // Diffs our units against the previous call.
+    void Observe(const std::vector<const sc2::Unit*>& own, uint32_t game_loop);
+
+    // Events from min_loop on, newest first, until the ring has wrapped.
+    template <typename Visitor>
+    void ForEachSince(uint32_t min_loop, Visitor visit) const;
+
+    // Appends the events written since *cursor and moves it forward; events
+    // overwritten in between are skipped. Returns how many were appended.
+    size_t Read(uint64_t* cursor, std::vector<DamageEvent>* out) const;
+
+    // Events ever written; also the cursor of the next one.
+    uint64_t Written() const { return written_; }
+
+private:
+    struct Previous {
+        float health;
+        uint32_t game_loop;
+    };
+
+    void Append(const DamageEvent& event);
+
+    std::vector<DamageEvent> ring_;
+    uint64_t written_ = 0;
+    std::unordered_map<uint64_t, Previous> previous_;
+};
+
+template <typename Visitor>
+void DamageTracker::ForEachSince(uint32_t min_loop, Visitor visit) const {
+    uint64_t oldest = written_ > CAPACITY ? written_ - CAPACITY : 0;
+    for (uint64_t i = written_; i > oldest; --i) {
+        const DamageEvent& event = ring_[(i - 1) % CAPACITY];
+        if (event.game_loop < min_loop)
+            return;
+        visit(event);
+    }
+}
+
+#endif // DAMAGE_TRACKER_H
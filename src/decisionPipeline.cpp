@@ -0,0 +1,186 @@
+#include "decisionPipeline.h"
+
+#include <chrono>
+
+using namespace sc2;
+
+namespace {
+
+// The decision thread re-checks for work this often even without a wake-up.
+const auto IDLE_WAIT = std::chrono::milliseconds(5);
+
+}  // namespace
+
+DecisionPipeline::~DecisionPipeline() {
+    Stop();
+}
+
+void DecisionPipeline::Start(const UnitTypes& types) {
+    if (Running())
+        return;
+
+    types_ = types;
+    selector_.Reset();
+    stopping_.store(false);
+    thread_ = std::thread(&DecisionPipeline::Run, this);
+}
+
+void DecisionPipeline::Stop() {
+    if (!Running())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_.store(true);
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    PipelinedCommand discarded;
+    while (commands_.Pop(&discarded)) {
+    }
+    for (auto& buffer : buffers_)
+        buffer.state.store(FREE);
+}
+
+void DecisionPipeline::Submit(uint32_t game_loop, const Units& attackers, const Units& enemies) {
+    if (!Running())
+        return;
+
+    // Prefer an empty half, else overwrite a snapshot nobody has taken yet.
+    // With a single reader at most one half is ever being read.
+    Snapshot* snapshot = nullptr;
+    for (int wanted : {FREE, READY}) {
+        for (auto& buffer : buffers_) {
+            int expected = wanted;
+            if (buffer.state.compare_exchange_strong(expected, WRITING, std::memory_order_acquire)) {
+                snapshot = &buffer;
+                break;
+            }
+        }
+        if (snapshot)
+            break;
+    }
+    if (!snapshot)
+        return;
+
+    snapshot->sequence.store(next_sequence_++, std::memory_order_relaxed);
+    snapshot->game_loop = game_loop;
+    snapshot->generation = generation_.load(std::memory_order_relaxed);
+    snapshot->attackers.clear();
+    snapshot->enemies.clear();
+    for (const auto& unit : attackers)
+        snapshot->attackers.push_back(*unit);
+    for (const auto& unit : enemies)
+        snapshot->enemies.push_back(*unit);
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        snapshot->state.store(READY, std::memory_order_release);
+    }
+    wake_.notify_one();
+}
+
+bool DecisionPipeline::Poll(PipelinedCommand* out) {
+    uint32_t generation = generation_.load(std::memory_order_relaxed);
+    while (commands_.Pop(out)) {
+        if (out->generation == generation)
+            return true;
+    }
+    return false;
+}
+
+void DecisionPipeline::Reset() {
+    generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DecisionPipeline::Run() {
+    uint64_t last_sequence = 0;
+
+    while (!stopping_.load()) {
+        // Take the newest ready snapshot; older ones are stale
+        // The sequence is only a hint until the buffer is ours; the
+        // coordinator may be rewriting it while we look
+        Snapshot* newest = nullptr;
+        uint64_t newest_sequence = 0;
+        for (auto& buffer : buffers_) {
+            if (buffer.state.load(std::memory_order_acquire) != READY)
+                continue;
+            uint64_t sequence = buffer.sequence.load(std::memory_order_relaxed);
+            if (!newest || sequence > newest_sequence) {
+                newest = &buffer;
+                newest_sequence = sequence;
+            }
+        }
+
+        if (newest) {
+            int expected = READY;
+            if (!newest->state.compare_exchange_strong(expected, READING, std::memory_order_acquire))
+                continue;   // the coordinator is overwriting it with a fresher one
+
+            uint64_t sequence = newest->sequence.load(std::memory_order_relaxed);
+            if (sequence > last_sequence) {
+                last_sequence = sequence;
+                Decide(*newest);
+            }
+            newest->state.store(FREE, std::memory_order_release);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, IDLE_WAIT, [this] {
+            return stopping_.load() ||
+                buffers_[0].state.load() == READY || buffers_[1].state.load() == READY;
+        });
+    }
+}
+
+void DecisionPipeline::Decide(const Snapshot& snapshot) {
+    if (snapshot.generation != selector_generation_) {
+        selector_.Reset();
+        selector_generation_ = snapshot.generation;
+    }
+
+    std::vector<const Unit*> attackers;
+    attackers.reserve(snapshot.attackers.size());
+    for (const auto& unit : snapshot.attackers)
+        attackers.push_back(&unit);
+
+    std::vector<const Unit*> enemies;
+    enemies.reserve(snapshot.enemies.size());
+    for (const auto& unit : snapshot.enemies)
+        enemies.push_back(&unit);
+
+    selector_.Update(attackers, enemies, types_, snapshot.game_loop);
+
+    PipelinedCommand command;
+    command.game_loop = snapshot.game_loop;
+    command.generation = snapshot.generation;
+
+    command.kind = PipelinedCommand::Kind::ATTACK_UNIT;
+    for (const auto& assignment : selector_.Retargeted()) {
+        command.unit = assignment.attacker->tag;
+        command.target = assignment.target->tag;
+        Emit(command);
+    }
+
+    command.kind = PipelinedCommand::Kind::ADVANCE;
+    command.target = 0;
+    for (const auto& unit : selector_.Unassigned()) {
+        command.unit = unit->tag;
+        Emit(command);
+    }
+
+    command.kind = PipelinedCommand::Kind::END_OF_BATCH;
+    command.unit = 0;
+    Emit(command);
+}
+
+void DecisionPipeline::Emit(const PipelinedCommand& command) {
+    // The coordinator drains every step, so a full queue clears quickly
+    while (!commands_.Push(command)) {
+        if (stopping_.load())
+            return;
+        std::this_thread::yield();
+    }
+}
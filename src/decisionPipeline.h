@@ -0,0 +1,103 @@
+#ifndef DECISION_PIPELINE_H
+#define DECISION_PIPELINE_H
+
+#include "spscQueue.h"
+#include "targetSelector.h"
+
+#include <sc2api/sc2_api.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One decision produced off-thread for the coordinator to issue.
+struct PipelinedCommand {
+    enum class Kind : uint8_t {
+        ATTACK_UNIT,    // focus fire on target
+        ADVANCE,        // nothing in reach, close in on the objective
+        END_OF_BATCH    // every command of one snapshot has been delivered
+    };
+
+    Kind kind = Kind::END_OF_BATCH;
+    sc2::Tag unit = 0;
+    sc2::Tag target = 0;
+    uint32_t game_loop = 0;     // loop of the snapshot it was computed from
+    uint32_t generation = 0;
+};
+
+// Runs focus-fire target scoring on a decision thread.
+// The coordinator thread copies the units it needs into one half of a
+// double-buffered snapshot and returns straight to protocol I/O; the
+// decision thread scores the newest complete snapshot and hands back
+// commands through a lock-free single-producer/single-consumer queue. The
+// coordinator drains them on a later step, so decisions trail the game by
+// one step in exchange for overlapping thinking with observation decoding.
+class DecisionPipeline {
+public:
+    DecisionPipeline() = default;
+    DecisionPipeline(const DecisionPipeline&) = delete;
+    DecisionPipeline& operator=(const DecisionPipeline&) = delete;
+    ~DecisionPipeline();
+
+    // Starts the decision thread with its own copy of the unit type data.
+    void Start(const sc2::UnitTypes& types);
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    // Coordinator thread: publish this step's attackers and enemies. A
+    // snapshot the decision thread has not picked up yet is replaced.
+    void Submit(uint32_t game_loop, const sc2::Units& attackers, const sc2::Units& enemies);
+
+    // Coordinator thread: next finished command, false when none is waiting.
+    // Commands issued before the last Reset are dropped here.
+    bool Poll(PipelinedCommand* out);
+
+    // Coordinator thread: forget all assignments, e.g. when the army is
+    // given other orders.
+    void Reset();
+
+private:
+    enum BufferState : int {
+        FREE,
+        WRITING,
+        READY,
+        READING
+    };
+
+    struct Snapshot {
+        std::atomic<int> state{FREE};
+        std::atomic<uint64_t> sequence{0};  // read by the decision thread before it owns the buffer
+        uint32_t game_loop = 0;
+        uint32_t generation = 0;
+        std::vector<sc2::Unit> attackers;
+        std::vector<sc2::Unit> enemies;
+    };
+
+    void Run();
+    void Decide(const Snapshot& snapshot);
+    void Emit(const PipelinedCommand& command);
+
+    Snapshot buffers_[2];
+    uint64_t next_sequence_ = 1;
+
+    SpscQueue<PipelinedCommand, 4096> commands_;
+
+    // Decision thread only
+    TargetSelector selector_;
+    sc2::UnitTypes types_;
+    uint32_t selector_generation_ = 0;
+
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<bool> stopping_{false};
+
+    // Wakes the decision thread; not on the data path
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+
+    std::thread thread_;
+};
+
+#endif // DECISION_PIPELINE_H
@@ -0,0 +1,198 @@
+// Benchmark for the observation decode path.
+//
+// Builds synthetic observations with 100, 400 and 1000 units, changes a
+// fifth of them every step and times two ways of getting them into the bot:
+//   stock - parse into a fresh heap message and convert every unit into a
+//           full sc2::Unit kept in a tag-keyed pool, as cpp-sc2 does for
+//           ObservationInterface
+//   lean  - parse into a reused arena and update the compact UnitTable
+//
+// Usage: BlankBotDecodeBench [steps]
+
+#include "unitTable.h"
+
+#include <sc2api/sc2_unit.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Share of units that move or take damage each step
+const float CHANGED_SHARE = 0.2f;
+
+void ConvertFull(const SC2APIProtocol::Unit& in, sc2::Unit& out, uint32_t game_loop) {
+    out.display_type = static_cast<sc2::Unit::DisplayType>(in.display_type());
+    out.alliance = static_cast<sc2::Unit::Alliance>(in.alliance());
+    out.tag = in.tag();
+    out.unit_type = in.unit_type();
+    out.owner = in.owner();
+    out.pos = sc2::Point3D(in.pos().x(), in.pos().y(), in.pos().z());
+    out.facing = in.facing();
+    out.radius = in.radius();
+    out.build_progress = in.build_progress();
+    out.cloak = static_cast<sc2::Unit::CloakState>(in.cloak());
+    out.detect_range = in.detect_range();
+    out.radar_range = in.radar_range();
+    out.is_selected = in.is_selected();
+    out.is_on_screen = in.is_on_screen();
+    out.is_blip = in.is_blip();
+    out.health = in.health();
+    out.health_max = in.health_max();
+    out.shield = in.shield();
+    out.shield_max = in.shield_max();
+    out.energy = in.energy();
+    out.energy_max = in.energy_max();
+    out.mineral_contents = in.mineral_contents();
+    out.vespene_contents = in.vespene_contents();
+    out.is_flying = in.is_flying();
+    out.is_burrowed = in.is_burrowed();
+    out.is_hallucination = in.is_hallucination();
+    out.add_on_tag = in.add_on_tag();
+    out.cargo_space_taken = in.cargo_space_taken();
+    out.cargo_space_max = in.cargo_space_max();
+    out.assigned_harvesters = in.assigned_harvesters();
+    out.ideal_harvesters = in.ideal_harvesters();
+    out.weapon_cooldown = in.weapon_cooldown();
+    out.engaged_target_tag = in.engaged_target_tag();
+    out.is_powered = in.is_powered();
+    out.is_alive = true;
+    out.last_seen_game_loop = game_loop;
+
+    out.orders.clear();
+    for (const auto& order : in.orders()) {
+        sc2::UnitOrder converted;
+        converted.ability_id = order.ability_id();
+        converted.target_unit_tag = order.target_unit_tag();
+        converted.target_pos = sc2::Point2D(order.target_world_space_pos().x(), order.target_world_space_pos().y());
+        converted.progress = order.progress();
+        out.orders.push_back(converted);
+    }
+
+    out.buffs.clear();
+    for (uint32_t buff : in.buff_ids())
+        out.buffs.push_back(buff);
+}
+
+SC2APIProtocol::Response MakeObservation(size_t unit_count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> coord(10.0f, 150.0f);
+    SC2APIProtocol::Response response;
+    auto* raw = response.mutable_observation()->mutable_observation()->mutable_raw_data();
+
+    for (size_t i = 0; i < unit_count; ++i) {
+        auto* unit = raw->add_units();
+        unit->set_tag(0x100000000ull + i);
+        unit->set_unit_type(i % 3 == 0 ? 84 : 73);      // probes and zealots
+        unit->set_alliance(i % 2 == 0 ? SC2APIProtocol::Self : SC2APIProtocol::Enemy);
+        unit->set_display_type(SC2APIProtocol::Visible);
+        unit->set_owner(i % 2 == 0 ? 1 : 2);
+        unit->mutable_pos()->set_x(coord(rng));
+        unit->mutable_pos()->set_y(coord(rng));
+        unit->mutable_pos()->set_z(10.0f);
+        unit->set_facing(1.0f);
+        unit->set_radius(0.5f);
+        unit->set_build_progress(1.0f);
+        unit->set_cloak(SC2APIProtocol::NotCloaked);
+        unit->set_health(100.0f);
+        unit->set_health_max(100.0f);
+        unit->set_shield(50.0f);
+        unit->set_shield_max(50.0f);
+        unit->set_is_on_screen(true);
+        if (i % 4 == 0) {
+            auto* order = unit->add_orders();
+            order->set_ability_id(23);
+            order->set_target_unit_tag(0x100000000ull + (i + 1) % unit_count);
+        }
+    }
+    return response;
+}
+
+void Mutate(SC2APIProtocol::Response* response, uint32_t game_loop, std::mt19937& rng) {
+    auto* observation = response->mutable_observation()->mutable_observation();
+    observation->set_game_loop(game_loop);
+
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+    for (auto& unit : *observation->mutable_raw_data()->mutable_units()) {
+        if (chance(rng) >= CHANGED_SHARE)
+            continue;
+        unit.mutable_pos()->set_x(unit.pos().x() + step(rng));
+        unit.mutable_pos()->set_y(unit.pos().y() + step(rng));
+        unit.set_shield(std::max(0.0f, unit.shield() - 1.0f));
+    }
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(fraction * (values.size() - 1))];
+}
+
+void Run(size_t unit_count, int steps) {
+    std::mt19937 rng(11);
+    SC2APIProtocol::Response response = MakeObservation(unit_count, rng);
+
+    std::unordered_map<sc2::Tag, sc2::Unit> pool;
+    std::vector<const sc2::Unit*> units;
+    ObservationDecoder decoder;
+    UnitTable table;
+
+    std::vector<double> stock;
+    std::vector<double> lean;
+    stock.reserve(steps);
+    lean.reserve(steps);
+    std::string bytes;
+
+    for (int i = 0; i < steps; ++i) {
+        uint32_t game_loop = static_cast<uint32_t>(i + 1);
+        Mutate(&response, game_loop, rng);
+        response.SerializeToString(&bytes);
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            auto parsed = std::make_unique<SC2APIProtocol::Response>();
+            parsed->ParseFromString(bytes);
+            units.clear();
+            for (const auto& unit : parsed->observation().observation().raw_data().units()) {
+                sc2::Unit& converted = pool[unit.tag()];
+                ConvertFull(unit, converted, game_loop);
+                units.push_back(&converted);
+            }
+        }
+        auto middle = std::chrono::steady_clock::now();
+        {
+            const SC2APIProtocol::ResponseObservation* parsed = decoder.Decode(bytes);
+            if (parsed)
+                table.Update(parsed->observation().raw_data(), game_loop);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        stock.push_back(std::chrono::duration<double, std::micro>(middle - start).count());
+        lean.push_back(std::chrono::duration<double, std::micro>(end - middle).count());
+    }
+
+    std::cout << std::setw(8) << unit_count << std::fixed << std::setprecision(1)
+        << std::setw(12) << Percentile(stock, 0.50) << std::setw(12) << Percentile(stock, 0.99)
+        << std::setw(12) << Percentile(lean, 0.50) << std::setw(12) << Percentile(lean, 0.99) << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int steps = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (steps <= 0)
+        steps = 2000;
+
+    std::cout << std::setw(8) << "units" << std::setw(12) << "stock p50" << std::setw(12) << "stock p99"
+        << std::setw(12) << "lean p50" << std::setw(12) << "lean p99" << std::endl;
+    for (size_t unit_count : {100, 400, 1000})
+        Run(unit_count, steps);
+    return 0;
+}
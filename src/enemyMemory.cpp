@@ -0,0 +1,176 @@
+#include "enemyMemory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace sc2;
+
+void EnemyMemory::Reset(const GameInfo& game_info) {
+    grid_width_ = std::max(1, static_cast<int>(std::ceil(game_info.width / CELL_SIZE)));
+    grid_height_ = std::max(1, static_cast<int>(std::ceil(game_info.height / CELL_SIZE)));
+    cells_.assign(static_cast<size_t>(grid_width_) * grid_height_, {});
+
+    slots_.clear();
+    free_slots_.clear();
+    index_.clear();
+
+    history_.assign(HISTORY_SIZE, Trail{0, 0.0f, 0.0f, 0, NO_ENTRY});
+    history_head_ = 0;
+}
+
+uint32_t EnemyMemory::CellOf(const Point2D& pos) const {
+    int x = std::min(std::max(static_cast<int>(pos.x / CELL_SIZE), 0), grid_width_ - 1);
+    int y = std::min(std::max(static_cast<int>(pos.y / CELL_SIZE), 0), grid_height_ - 1);
+    return static_cast<uint32_t>(y * grid_width_ + x);
+}
+
+void EnemyMemory::Link(uint32_t slot, uint32_t cell) {
+    slots_[slot].cell = cell;
+    cells_[cell].push_back(slot);
+}
+
+void EnemyMemory::Unlink(uint32_t slot) {
+    auto& cell = cells_[slots_[slot].cell];
+    auto it = std::find(cell.begin(), cell.end(), slot);
+    if (it != cell.end()) {
+        *it = cell.back();
+        cell.pop_back();
+    }
+}
+
+void EnemyMemory::AppendTrail(Slot& slot) {
+    Trail& trail = history_[history_head_];
+    trail.tag = slot.sighting.tag;
+    trail.x = slot.sighting.pos.x;
+    trail.y = slot.sighting.pos.y;
+    trail.game_loop = slot.sighting.game_loop;
+    trail.previous = slot.last_trail;
+
+    slot.last_trail = history_head_;
+    history_head_ = (history_head_ + 1) % HISTORY_SIZE;
+}
+
+void EnemyMemory::Observe(const Units& enemies, const ObservationInterface* observation) {
+    if (cells_.empty())
+        Reset(observation->GetGameInfo());
+
+    uint32_t game_loop = observation->GetGameLoop();
+    const UnitTypes& types = observation->GetUnitTypeData();
+
+    for (const auto& enemy : enemies) {
+        if (enemy->display_type != Unit::DisplayType::Visible)
+            continue;
+
+        auto it = index_.find(enemy->tag);
+        if (it == index_.end()) {
+            uint32_t id;
+            if (!free_slots_.empty()) {
+                id = free_slots_.back();
+                free_slots_.pop_back();
+            }
+            else {
+                id = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+
+            Slot& slot = slots_[id];
+            slot = Slot();
+            slot.used = true;
+            slot.sighting.tag = enemy->tag;
+            slot.sighting.unit_type = enemy->unit_type;
+            slot.sighting.pos = enemy->pos;
+            slot.sighting.health = enemy->health;
+            slot.sighting.shield = enemy->shield;
+            slot.sighting.game_loop = game_loop;
+            slot.sighting.is_flying = enemy->is_flying;
+
+            uint32_t type_id = enemy->unit_type;
+            if (type_id < types.size()) {
+                const auto& attributes = types[type_id].attributes;
+                slot.sighting.is_structure =
+                    std::find(attributes.begin(), attributes.end(), Attribute::Structure) != attributes.end();
+            }
+
+            index_.emplace(enemy->tag, id);
+            Link(id, CellOf(enemy->pos));
+            AppendTrail(slot);
+            continue;
+        }
+
+        Slot& slot = slots_[it->second];
+        EnemySighting& sighting = slot.sighting;
+        sighting.game_loop = game_loop;
+        sighting.health = enemy->health;
+        sighting.shield = enemy->shield;
+        sighting.unit_type = enemy->unit_type;     // morphs, sieging, burrowing
+        sighting.is_flying = enemy->is_flying;
+
+        if (DistanceSquared2D(sighting.pos, enemy->pos) < MOVE_EPSILON * MOVE_EPSILON)
+            continue;
+
+        sighting.pos = enemy->pos;
+        uint32_t cell = CellOf(enemy->pos);
+        if (cell != slot.cell) {
+            Unlink(it->second);
+            Link(it->second, cell);
+        }
+        AppendTrail(slot);
+    }
+}
+
+void EnemyMemory::Forget(Tag tag) {
+    auto it = index_.find(tag);
+    if (it == index_.end())
+        return;
+
+    Unlink(it->second);
+    slots_[it->second].used = false;
+    free_slots_.push_back(it->second);
+    index_.erase(it);
+}
+
+void EnemyMemory::Query(const Point2D& center, float radius, uint32_t min_loop,
+                        std::vector<const EnemySighting*>* out) const {
+    if (cells_.empty())
+        return;
+
+    int x0 = std::max(static_cast<int>((center.x - radius) / CELL_SIZE), 0);
+    int y0 = std::max(static_cast<int>((center.y - radius) / CELL_SIZE), 0);
+    int x1 = std::min(static_cast<int>((center.x + radius) / CELL_SIZE), grid_width_ - 1);
+    int y1 = std::min(static_cast<int>((center.y + radius) / CELL_SIZE), grid_height_ - 1);
+    float radius_sq = radius * radius;
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            for (uint32_t id : cells_[static_cast<size_t>(y) * grid_width_ + x]) {
+                const EnemySighting& sighting = slots_[id].sighting;
+                if (sighting.game_loop >= min_loop && DistanceSquared2D(sighting.pos, center) <= radius_sq)
+                    out->push_back(&sighting);
+            }
+        }
+    }
+}
+
+const EnemySighting* EnemyMemory::NearestStructure(const Point2D& from) const {
+    const EnemySighting* nearest = nullptr;
+    float nearest_sq = std::numeric_limits<float>::max();
+
+    for (const auto& slot : slots_) {
+        if (!slot.used || !slot.sighting.is_structure)
+            continue;
+
+        float distance_sq = DistanceSquared2D(slot.sighting.pos, from);
+        if (distance_sq < nearest_sq) {
+            nearest_sq = distance_sq;
+            nearest = &slot.sighting;
+        }
+    }
+
+    return nearest;
+}
+
+const EnemySighting* EnemyMemory::Find(Tag tag) const {
+    auto it = index_.find(tag);
+    return it != index_.end() ? &slots_[it->second].sighting : nullptr;
+}
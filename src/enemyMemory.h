@@ -0,0 +1,134 @@
+#ifndef ENEMY_MEMORY_H
+#define ENEMY_MEMORY_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Last known state of an enemy unit.
+struct EnemySighting {
+    sc2::Tag tag = 0;
+    sc2::UnitTypeID unit_type;
+    sc2::Point2D pos;
+    float health = 0.0f;
+    float shield = 0.0f;
+    uint32_t game_loop = 0;     // last loop the unit was visible
+    bool is_flying = false;
+    bool is_structure = false;
+};
+
+// Remembers every enemy the bot has seen, including ones that left vision.
+// Sightings are indexed by a uniform spatial grid for "known enemies near X"
+// queries, and movements are appended to a fixed-size history ring so the
+// recent trail of a unit can be replayed.
+class EnemyMemory {
+public:
+    // One entry of the history ring.
+    struct Trail {
+        sc2::Tag tag;
+        float x;
+        float y;
+        uint32_t game_loop;
+        uint32_t previous;      // older entry of the same unit, or NO_ENTRY
+    };
+
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+    // Sizes the spatial grid to the map and forgets everything.
+    void Reset(const sc2::GameInfo& game_info);
+
+    // Folds this step's visible enemies in, touching only what changed.
+    void Observe(const sc2::Units& enemies, const sc2::ObservationInterface* observation);
+
+    // Drops a unit that has been destroyed.
+    void Forget(sc2::Tag tag);
+
+    // Drops remembered structures whose position is in vision now but that
+    // were not seen this step: they died or were cancelled out of our sight.
+    template <typename IsVisible>
+    size_t ForgetVanishedStructures(uint32_t game_loop, IsVisible is_visible);
+
+    // Known enemies within radius of center, last seen at or after min_loop.
+    void Query(const sc2::Point2D& center, float radius, uint32_t min_loop,
+               std::vector<const EnemySighting*>* out) const;
+
+    // Nearest remembered enemy structure, nullptr if none is known.
+    const EnemySighting* NearestStructure(const sc2::Point2D& from) const;
+
+    const EnemySighting* Find(sc2::Tag tag) const;
+
+    // Walks the recorded trail of a unit, newest first.
+    template <typename Visitor>
+    void ForEachTrail(sc2::Tag tag, Visitor visit) const;
+
+    size_t Size() const { return index_.size(); }
+
+private:
+    static constexpr float CELL_SIZE = 8.0f;
+    static constexpr uint32_t HISTORY_SIZE = 4096;
+
+    // Movement below this distance is not worth a history entry.
+    static constexpr float MOVE_EPSILON = 1.0f;
+
+    struct Slot {
+        EnemySighting sighting;
+        uint32_t cell = 0;
+        uint32_t last_trail = NO_ENTRY;
+        bool used = false;
+    };
+
+    uint32_t CellOf(const sc2::Point2D& pos) const;
+    void Link(uint32_t slot, uint32_t cell);
+    void Unlink(uint32_t slot);
+    void AppendTrail(Slot& slot);
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> free_slots_;
+    std::unordered_map<sc2::Tag, uint32_t> index_;
+
+    // Spatial grid: slot ids per cell
+    std::vector<std::vector<uint32_t>> cells_;
+    int grid_width_ = 0;
+    int grid_height_ = 0;
+
+    std::vector<Trail> history_;
+    uint32_t history_head_ = 0;
+};
+
+template <typename IsVisible>
+size_t EnemyMemory::ForgetVanishedStructures(uint32_t game_loop, IsVisible is_visible) {
+    size_t forgotten = 0;
+    for (const auto& slot : slots_) {
+        const EnemySighting& sighting = slot.sighting;
+        if (!slot.used || !sighting.is_structure || sighting.game_loop >= game_loop || !is_visible(sighting.pos))
+            continue;
+        Forget(sighting.tag);
+        ++forgotten;
+    }
+    return forgotten;
+}
+
+template <typename Visitor>
+void EnemyMemory::ForEachTrail(sc2::Tag tag, Visitor visit) const {
+    auto it = index_.find(tag);
+    if (it == index_.end())
+        return;
+
+    // Entries are overwritten once the ring wraps; stop at the first one that
+    // belongs to another unit or is not older than the previous one.
+    uint32_t entry = slots_[it->second].last_trail;
+    uint32_t newer_loop = UINT32_MAX;
+    for (uint32_t steps = 0; entry != NO_ENTRY && steps < history_.size(); ++steps) {
+        const Trail& trail = history_[entry];
+        if (trail.tag != tag || trail.game_loop > newer_loop)
+            return;
+
+        visit(trail);
+        newer_loop = trail.game_loop;
+        entry = trail.previous;
+    }
+}
+
+#endif // ENEMY_MEMORY_H
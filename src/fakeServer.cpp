@@ -0,0 +1,1090 @@
+// Local stand-in for the StarCraft II game server.
+//
+// Speaks enough of the s2client protocol over a localhost websocket for the
+// ladder build of the bot to connect, join, step, observe, act and query
+// against a small scripted game: a Protoss main and natural whose probes
+// walk between patches and Nexus, a base that builds what it is told, and
+// Zerg waves that walk into it. Every step round-trip is timed, and a latency
+// and throughput summary is printed when the game ends, followed by the
+// harvesters assigned to each Nexus.
+//
+// Usage: BlankBotFakeServer [port] [game-loops]
+//        BlankBot --GamePort <port> --StartPort <port + 1> --LadderServer 127.0.0.1
+
+#include <civetweb.h>
+#include <s2clientprotocol/sc2api.pb.h>
+#include <sc2api/sc2_typeenums.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+const int MAP_SIZE = 96;
+const int SELF = 1;
+const int ENEMY = 2;
+const float LOOPS_PER_SECOND = 22.4f;
+
+// Loops a probe spends at a patch or geyser, and what it carries back
+const int MINE_LOOPS = 64;
+const int MINERAL_CARGO = 5;
+const int GAS_CARGO = 4;
+
+uint32_t Id(sc2::UNIT_TYPEID type) {
+    return static_cast<uint32_t>(type);
+}
+
+uint32_t Id(sc2::ABILITY_ID ability) {
+    return static_cast<uint32_t>(ability);
+}
+
+uint32_t Id(sc2::BUFF_ID buff) {
+    return static_cast<uint32_t>(buff);
+}
+
+struct SimOrder {
+    uint32_t ability = 0;
+    uint64_t target_tag = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    float progress = 0.0f;
+};
+
+struct SimUnit {
+    uint64_t tag = 0;
+    uint32_t type = 0;
+    SC2APIProtocol::Alliance alliance = SC2APIProtocol::Alliance::Self;
+    int owner = SELF;
+    float x = 0.0f;
+    float y = 0.0f;
+    float radius = 0.5f;
+    float health = 0.0f;
+    float health_max = 0.0f;
+    float shield = 0.0f;
+    float shield_max = 0.0f;
+    float build_progress = 1.0f;
+    float speed = 0.0f;         // per loop
+    float dps = 0.0f;           // per loop
+    float range = 0.0f;
+    int minerals = 0;
+    int vespene = 0;
+    std::vector<SimOrder> orders;
+
+    // Probes: the patch or assimilator being mined and what is carried home
+    uint64_t harvest_target = 0;
+    int cargo = 0;
+    bool cargo_gas = false;
+};
+
+// Build time in loops and mineral cost of what the scripted game supports.
+struct Recipe {
+    uint32_t ability;
+    uint32_t produces;
+    int minerals;
+    int loops;
+};
+
+const Recipe RECIPES[] = {
+    {Id(sc2::ABILITY_ID::TRAIN_PROBE), Id(sc2::UNIT_TYPEID::PROTOSS_PROBE), 50, 272},
+    {Id(sc2::ABILITY_ID::TRAIN_ZEALOT), Id(sc2::UNIT_TYPEID::PROTOSS_ZEALOT), 100, 605},
+    {Id(sc2::ABILITY_ID::BUILD_PYLON), Id(sc2::UNIT_TYPEID::PROTOSS_PYLON), 100, 403},
+    {Id(sc2::ABILITY_ID::BUILD_GATEWAY), Id(sc2::UNIT_TYPEID::PROTOSS_GATEWAY), 150, 1030},
+    {Id(sc2::ABILITY_ID::BUILD_CYBERNETICSCORE), Id(sc2::UNIT_TYPEID::PROTOSS_CYBERNETICSCORE), 150, 806},
+    {Id(sc2::ABILITY_ID::BUILD_ASSIMILATOR), Id(sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR), 75, 470},
+};
+
+const Recipe* FindRecipe(uint32_t ability) {
+    for (const auto& recipe : RECIPES) {
+        if (recipe.ability == ability)
+            return &recipe;
+    }
+    return nullptr;
+}
+
+struct Stats {
+    std::vector<double> cycle_us;       // RequestStep to RequestStep
+    std::vector<double> think_us;       // observation sent to next step request
+    uint64_t requests = 0;
+    uint64_t actions = 0;
+    uint64_t queries = 0;
+    Clock::time_point first_step;
+    Clock::time_point last_step;
+};
+
+class FakeGame {
+public:
+    explicit FakeGame(uint32_t max_loops): max_loops_(max_loops) {
+        Reset();
+    }
+
+    // Handles one serialized Request and returns the serialized Response.
+    std::string Handle(const std::string& payload);
+
+    bool Ended() const { return ended_; }
+
+    void PrintReport() const;
+
+private:
+    void Reset();
+    SimUnit& Spawn(uint32_t type, SC2APIProtocol::Alliance alliance, float x, float y);
+    void SpawnBase(float x, float y);
+    SimUnit* Find(uint64_t tag);
+
+    void Advance(uint32_t loops);
+    void Tick();
+    void SpawnWave();
+    void MoveTowards(SimUnit& unit, float x, float y);
+    SimUnit* NearestHostile(const SimUnit& unit, float max_distance);
+    const SimUnit* NearestNexus(float x, float y) const;
+    void Harvest(SimUnit& unit);
+
+    // Probes mining a Nexus's patches or an assimilator, and how many it takes
+    int AssignedHarvesters(const SimUnit& building) const;
+    int IdealHarvesters(const SimUnit& building) const;
+
+    void FillGameInfo(SC2APIProtocol::ResponseGameInfo* info) const;
+    void FillData(SC2APIProtocol::ResponseData* data) const;
+    void FillObservation(SC2APIProtocol::ResponseObservation* observation);
+    void ApplyActions(const SC2APIProtocol::RequestAction& request, SC2APIProtocol::ResponseAction* response);
+    void AnswerQuery(const SC2APIProtocol::RequestQuery& request, SC2APIProtocol::ResponseQuery* response) const;
+    SC2APIProtocol::ActionResult Command(const SC2APIProtocol::ActionRawUnitCommand& command);
+
+    uint32_t max_loops_;
+    uint32_t game_loop_ = 0;
+    uint64_t next_tag_ = 1;
+    float minerals_ = 50.0f;
+    float vespene_ = 0.0f;
+    int next_wave_ = 1;
+    bool ended_ = false;
+    SC2APIProtocol::Result result_ = SC2APIProtocol::Result::Undecided;
+
+    std::vector<SimUnit> units_;
+    std::vector<uint64_t> dead_;
+
+    Stats stats_;
+    bool has_last_step_ = false;
+    Clock::time_point last_step_request_;
+    Clock::time_point last_observation_sent_;
+};
+
+void FakeGame::Reset() {
+    units_.clear();
+    dead_.clear();
+
+    SpawnBase(24.5f, 24.5f);
+    SimUnit& geyser = Spawn(Id(sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER), SC2APIProtocol::Alliance::Neutral,
+        31.5f, 17.5f);
+    geyser.vespene = 2250;
+
+    // Every probe starts on the main, and new ones join it, so the bot has
+    // to spread them over to the natural itself
+    for (int i = 0; i < 12; ++i) {
+        SimUnit& probe = Spawn(Id(sc2::UNIT_TYPEID::PROTOSS_PROBE), SC2APIProtocol::Alliance::Self,
+            20.0f + i % 4, 21.0f + i / 4);
+        SimOrder gather;
+        gather.ability = Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE);
+        gather.target_tag = units_[1 + i % 8].tag;
+        probe.orders.push_back(gather);
+    }
+
+    SpawnBase(24.5f, 56.5f);
+
+    Spawn(Id(sc2::UNIT_TYPEID::ZERG_HATCHERY), SC2APIProtocol::Alliance::Enemy, 71.5f, 71.5f);
+}
+
+void FakeGame::SpawnBase(float x, float y) {
+    // Patches in an L to the left of and below the Nexus, where a town hall
+    // search over the resources puts it
+    Spawn(Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS), SC2APIProtocol::Alliance::Self, x, y);
+    for (int i = 0; i < 8; ++i) {
+        float px = i < 4 ? x - 6.5f : x - 2.5f + 2.0f * (i - 4);
+        float py = i < 4 ? y - 0.5f + i : y - 6.0f;
+        Spawn(Id(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD), SC2APIProtocol::Alliance::Neutral, px, py).minerals = 1800;
+    }
+}
+
+SimUnit& FakeGame::Spawn(uint32_t type, SC2APIProtocol::Alliance alliance, float x, float y) {
+    SimUnit unit;
+    unit.tag = next_tag_++;
+    unit.type = type;
+    unit.alliance = alliance;
+    unit.owner = alliance == SC2APIProtocol::Alliance::Self ? SELF :
+        alliance == SC2APIProtocol::Alliance::Enemy ? ENEMY : 16;
+    unit.x = x;
+    unit.y = y;
+
+    switch (static_cast<sc2::UNIT_TYPEID>(type)) {
+        case sc2::UNIT_TYPEID::PROTOSS_NEXUS:
+            unit.radius = 2.75f; unit.health_max = 1000; unit.shield_max = 1000;
+            break;
+        case sc2::UNIT_TYPEID::PROTOSS_PROBE:
+            unit.radius = 0.375f; unit.health_max = 20; unit.shield_max = 20;
+            unit.speed = 3.94f / LOOPS_PER_SECOND; unit.dps = 4.67f / LOOPS_PER_SECOND; unit.range = 0.1f;
+            break;
+        case sc2::UNIT_TYPEID::PROTOSS_ZEALOT:
+            unit.radius = 0.5f; unit.health_max = 100; unit.shield_max = 50;
+            unit.speed = 3.15f / LOOPS_PER_SECOND; unit.dps = 18.6f / LOOPS_PER_SECOND; unit.range = 0.1f;
+            break;
+        case sc2::UNIT_TYPEID::PROTOSS_PYLON:
+            unit.radius = 1.0f; unit.health_max = 200; unit.shield_max = 200;
+            break;
+        case sc2::UNIT_TYPEID::ZERG_ZERGLING:
+            unit.radius = 0.375f; unit.health_max = 35;
+            unit.speed = 4.13f / LOOPS_PER_SECOND; unit.dps = 10.0f / LOOPS_PER_SECOND; unit.range = 0.1f;
+            break;
+        case sc2::UNIT_TYPEID::ZERG_HATCHERY:
+            unit.radius = 2.75f; unit.health_max = 1500;
+            break;
+        case sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD:
+            unit.radius = 1.0f;
+            break;
+        case sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER:
+            unit.radius = 1.75f;
+            break;
+        default:
+            unit.radius = 1.5f; unit.health_max = 500; unit.shield_max = 500;
+            break;
+    }
+
+    unit.health = unit.health_max;
+    unit.shield = unit.shield_max;
+    units_.push_back(unit);
+    return units_.back();
+}
+
+SimUnit* FakeGame::Find(uint64_t tag) {
+    for (auto& unit : units_) {
+        if (unit.tag == tag)
+            return &unit;
+    }
+    return nullptr;
+}
+
+void FakeGame::MoveTowards(SimUnit& unit, float x, float y) {
+    float dx = x - unit.x;
+    float dy = y - unit.y;
+    float distance = std::sqrt(dx * dx + dy * dy);
+    if (distance <= unit.speed || distance == 0.0f) {
+        unit.x = x;
+        unit.y = y;
+        return;
+    }
+    unit.x += dx / distance * unit.speed;
+    unit.y += dy / distance * unit.speed;
+}
+
+SimUnit* FakeGame::NearestHostile(const SimUnit& unit, float max_distance) {
+    SimUnit* best = nullptr;
+    float best_distance = max_distance;
+    for (auto& other : units_) {
+        bool hostile = (unit.alliance == SC2APIProtocol::Alliance::Self && other.alliance == SC2APIProtocol::Alliance::Enemy) ||
+            (unit.alliance == SC2APIProtocol::Alliance::Enemy && other.alliance == SC2APIProtocol::Alliance::Self);
+        if (!hostile || other.health <= 0.0f)
+            continue;
+
+        float distance = std::hypot(other.x - unit.x, other.y - unit.y);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = &other;
+        }
+    }
+    return best;
+}
+
+const SimUnit* FakeGame::NearestNexus(float x, float y) const {
+    const SimUnit* best = nullptr;
+    float best_distance = 0.0f;
+    for (const auto& unit : units_) {
+        if (unit.type != Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS) || unit.build_progress < 1.0f)
+            continue;
+        float distance = std::hypot(unit.x - x, unit.y - y);
+        if (!best || distance < best_distance) {
+            best_distance = distance;
+            best = &unit;
+        }
+    }
+    return best;
+}
+
+void FakeGame::Harvest(SimUnit& unit) {
+    SimOrder& order = unit.orders.front();
+
+    if (order.ability == Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE)) {
+        SimUnit* resource = Find(order.target_tag);
+        if (!resource || resource->build_progress < 1.0f) {
+            unit.orders.erase(unit.orders.begin());
+            return;
+        }
+        if (std::hypot(resource->x - unit.x, resource->y - unit.y) > unit.radius + resource->radius + 0.2f) {
+            MoveTowards(unit, resource->x, resource->y);
+            return;
+        }
+
+        order.progress += 1.0f / MINE_LOOPS;
+        if (order.progress < 1.0f)
+            return;
+
+        unit.harvest_target = resource->tag;
+        unit.cargo_gas = resource->type == Id(sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR);
+        unit.cargo = unit.cargo_gas ? GAS_CARGO : MINERAL_CARGO;
+        const SimUnit* nexus = NearestNexus(unit.x, unit.y);
+        order = SimOrder();
+        order.ability = Id(sc2::ABILITY_ID::HARVEST_RETURN_PROBE);
+        order.target_tag = nexus ? nexus->tag : 0;
+        return;
+    }
+
+    // Returning cargo
+    const SimUnit* nexus = Find(order.target_tag);
+    if (!nexus)
+        nexus = NearestNexus(unit.x, unit.y);
+    if (!nexus) {
+        unit.orders.erase(unit.orders.begin());
+        return;
+    }
+    if (std::hypot(nexus->x - unit.x, nexus->y - unit.y) > unit.radius + nexus->radius + 0.2f) {
+        MoveTowards(unit, nexus->x, nexus->y);
+        return;
+    }
+
+    if (unit.cargo_gas)
+        vespene_ += unit.cargo;
+    else
+        minerals_ += unit.cargo;
+    unit.cargo = 0;
+
+    if (unit.harvest_target == 0) {
+        unit.orders.erase(unit.orders.begin());
+        return;
+    }
+    order = SimOrder();
+    order.ability = Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE);
+    order.target_tag = unit.harvest_target;
+}
+
+int FakeGame::AssignedHarvesters(const SimUnit& building) const {
+    bool is_nexus = building.type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS);
+    int assigned = 0;
+    for (const auto& unit : units_) {
+        if (unit.type != Id(sc2::UNIT_TYPEID::PROTOSS_PROBE) || unit.orders.empty())
+            continue;
+        const SimOrder& order = unit.orders.front();
+        uint64_t mined = order.ability == Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE) ? order.target_tag :
+            order.ability == Id(sc2::ABILITY_ID::HARVEST_RETURN_PROBE) ? unit.harvest_target : 0;
+        if (mined == 0)
+            continue;
+        if (!is_nexus) {
+            assigned += mined == building.tag;
+            continue;
+        }
+        for (const auto& field : units_) {
+            if (field.tag == mined && field.minerals > 0)
+                assigned += NearestNexus(field.x, field.y) == &building;
+        }
+    }
+    return assigned;
+}
+
+int FakeGame::IdealHarvesters(const SimUnit& building) const {
+    if (building.type != Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS))
+        return 3;
+    int ideal = 0;
+    for (const auto& field : units_) {
+        if (field.minerals > 0 && NearestNexus(field.x, field.y) == &building)
+            ideal += 2;
+    }
+    return ideal;
+}
+
+void FakeGame::SpawnWave() {
+    int count = 2 + 2 * next_wave_;
+    for (int i = 0; i < count; ++i) {
+        SimUnit& ling = Spawn(Id(sc2::UNIT_TYPEID::ZERG_ZERGLING), SC2APIProtocol::Alliance::Enemy,
+            66.0f + i % 4, 66.0f + i / 4);
+        SimOrder attack;
+        attack.ability = Id(sc2::ABILITY_ID::ATTACK_ATTACK);
+        attack.x = 24.5f;
+        attack.y = 24.5f;
+        ling.orders.push_back(attack);
+    }
+    ++next_wave_;
+}
+
+void FakeGame::Tick() {
+    ++game_loop_;
+    if (game_loop_ % 2700 == 0)
+        SpawnWave();
+
+    int food_cap = 0;
+    int food_used = 0;
+    for (const auto& unit : units_) {
+        if (unit.alliance != SC2APIProtocol::Alliance::Self || unit.build_progress < 1.0f)
+            continue;
+        if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS))
+            food_cap += 15;
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_PYLON))
+            food_cap += 8;
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_PROBE))
+            food_used += 1;
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_ZEALOT))
+            food_used += 2;
+    }
+
+    std::vector<SimUnit> spawned;
+    for (auto& unit : units_) {
+        if (unit.build_progress < 1.0f) {
+            const Recipe* recipe = nullptr;
+            for (const auto& candidate : RECIPES) {
+                if (candidate.produces == unit.type)
+                    recipe = &candidate;
+            }
+            unit.build_progress = std::min(1.0f, unit.build_progress + 1.0f / (recipe ? recipe->loops : 400));
+            continue;
+        }
+
+        if (unit.orders.empty()) {
+            // Idle combat units defend themselves
+            if (unit.dps > 0.0f && unit.type != Id(sc2::UNIT_TYPEID::PROTOSS_PROBE)) {
+                SimUnit* target = NearestHostile(unit, 6.0f);
+                if (target && std::hypot(target->x - unit.x, target->y - unit.y) <= unit.radius + target->radius + unit.range)
+                    target->health -= unit.dps;
+            }
+            continue;
+        }
+
+        SimOrder& order = unit.orders.front();
+        const Recipe* recipe = FindRecipe(order.ability);
+
+        if (order.ability == Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE) ||
+            order.ability == Id(sc2::ABILITY_ID::HARVEST_RETURN_PROBE)) {
+            Harvest(unit);
+        }
+        else if (order.ability == Id(sc2::ABILITY_ID::TRAIN_PROBE) || order.ability == Id(sc2::ABILITY_ID::TRAIN_ZEALOT)) {
+            int food = order.ability == Id(sc2::ABILITY_ID::TRAIN_ZEALOT) ? 2 : 1;
+            if (food_used + food > food_cap)
+                continue;
+
+            order.progress += 1.0f / recipe->loops;
+            if (order.progress >= 1.0f) {
+                SimUnit produced;
+                produced.type = recipe->produces;
+                produced.x = unit.x + unit.radius + 1.0f;
+                produced.y = unit.y;
+                spawned.push_back(produced);
+                unit.orders.erase(unit.orders.begin());
+            }
+        }
+        else if (order.ability == Id(sc2::ABILITY_ID::MOVE_MOVE)) {
+            MoveTowards(unit, order.x, order.y);
+            if (unit.x == order.x && unit.y == order.y)
+                unit.orders.erase(unit.orders.begin());
+        }
+        else if (order.ability == Id(sc2::ABILITY_ID::ATTACK_ATTACK)) {
+            SimUnit* target = order.target_tag != 0 ? Find(order.target_tag) : NearestHostile(unit, 6.0f);
+            if (!target) {
+                if (order.target_tag != 0) {
+                    unit.orders.erase(unit.orders.begin());
+                    continue;
+                }
+                MoveTowards(unit, order.x, order.y);
+                continue;
+            }
+
+            float reach = unit.radius + target->radius + unit.range;
+            if (std::hypot(target->x - unit.x, target->y - unit.y) > reach)
+                MoveTowards(unit, target->x, target->y);
+            else if (target->shield > 0.0f)
+                target->shield -= unit.dps;
+            else
+                target->health -= unit.dps;
+        }
+    }
+
+    for (const auto& produced : spawned) {
+        SimUnit& unit = Spawn(produced.type, SC2APIProtocol::Alliance::Self, produced.x, produced.y);
+        if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_PROBE)) {
+            SimOrder gather;
+            gather.ability = Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE);
+            gather.target_tag = units_[1].tag;
+            unit.orders.push_back(gather);
+        }
+    }
+
+    // Remove the dead and decide the game
+    bool nexus_alive = false;
+    for (auto it = units_.begin(); it != units_.end();) {
+        if (it->health_max > 0.0f && it->health <= 0.0f) {
+            dead_.push_back(it->tag);
+            it = units_.erase(it);
+            continue;
+        }
+        if (it->type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS))
+            nexus_alive = true;
+        ++it;
+    }
+
+    if (!nexus_alive) {
+        ended_ = true;
+        result_ = SC2APIProtocol::Result::Defeat;
+    }
+    else if (game_loop_ >= max_loops_) {
+        ended_ = true;
+        result_ = SC2APIProtocol::Result::Tie;
+    }
+}
+
+void FakeGame::Advance(uint32_t loops) {
+    for (uint32_t i = 0; i < loops && !ended_; ++i)
+        Tick();
+}
+
+void FakeGame::FillGameInfo(SC2APIProtocol::ResponseGameInfo* info) const {
+    info->set_map_name("FakeServer");
+    info->set_local_map_path("FakeServer.SC2Map");
+
+    auto* self = info->add_player_info();
+    self->set_player_id(SELF);
+    self->set_type(SC2APIProtocol::PlayerType::Participant);
+    self->set_race_requested(SC2APIProtocol::Race::Protoss);
+    self->set_race_actual(SC2APIProtocol::Race::Protoss);
+
+    auto* enemy = info->add_player_info();
+    enemy->set_player_id(ENEMY);
+    enemy->set_type(SC2APIProtocol::PlayerType::Computer);
+    enemy->set_race_requested(SC2APIProtocol::Race::Zerg);
+
+    auto* raw = info->mutable_start_raw();
+    raw->mutable_map_size()->set_x(MAP_SIZE);
+    raw->mutable_map_size()->set_y(MAP_SIZE);
+
+    // Open ground everywhere: one bit per cell for pathing and placement,
+    // one byte per cell for height
+    std::string bits(MAP_SIZE * MAP_SIZE / 8, static_cast<char>(0xff));
+    for (auto* grid : {raw->mutable_pathing_grid(), raw->mutable_placement_grid()}) {
+        grid->set_bits_per_pixel(1);
+        grid->mutable_size()->set_x(MAP_SIZE);
+        grid->mutable_size()->set_y(MAP_SIZE);
+        grid->set_data(bits);
+    }
+    auto* height = raw->mutable_terrain_height();
+    height->set_bits_per_pixel(8);
+    height->mutable_size()->set_x(MAP_SIZE);
+    height->mutable_size()->set_y(MAP_SIZE);
+    height->set_data(std::string(MAP_SIZE * MAP_SIZE, static_cast<char>(127)));
+
+    raw->mutable_playable_area()->mutable_p0()->set_x(0);
+    raw->mutable_playable_area()->mutable_p0()->set_y(0);
+    raw->mutable_playable_area()->mutable_p1()->set_x(MAP_SIZE);
+    raw->mutable_playable_area()->mutable_p1()->set_y(MAP_SIZE);
+
+    auto* start = raw->add_start_locations();
+    start->set_x(71.5f);
+    start->set_y(71.5f);
+
+    info->mutable_options()->set_raw(true);
+    info->mutable_options()->set_score(true);
+}
+
+void FakeGame::FillData(SC2APIProtocol::ResponseData* data) const {
+    struct TypeInfo {
+        sc2::UNIT_TYPEID type;
+        const char* name;
+        int minerals;
+        float food;
+        float damage;
+        float range;
+        float cooldown;
+        bool structure;
+    };
+    const TypeInfo types[] = {
+        {sc2::UNIT_TYPEID::PROTOSS_PROBE, "Probe", 50, 1, 5, 0.1f, 1.07f, false},
+        {sc2::UNIT_TYPEID::PROTOSS_ZEALOT, "Zealot", 100, 2, 8, 0.1f, 0.86f, false},
+        {sc2::UNIT_TYPEID::ZERG_ZERGLING, "Zergling", 25, 0.5f, 5, 0.1f, 0.497f, false},
+        {sc2::UNIT_TYPEID::PROTOSS_NEXUS, "Nexus", 400, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::PROTOSS_PYLON, "Pylon", 100, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::PROTOSS_GATEWAY, "Gateway", 150, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::PROTOSS_CYBERNETICSCORE, "CyberneticsCore", 150, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR, "Assimilator", 75, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::ZERG_HATCHERY, "Hatchery", 300, 0, 0, 0, 0, true},
+        {sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD, "MineralField", 0, 0, 0, 0, 0, false},
+        {sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER, "VespeneGeyser", 0, 0, 0, 0, 0, false},
+    };
+
+    // The client looks data up by id, so every id up to the largest one in
+    // play gets an entry, known or not
+    uint32_t max_type = 0;
+    for (const auto& type : types)
+        max_type = std::max(max_type, Id(type.type));
+    for (uint32_t id = 0; id <= max_type; ++id)
+        data->add_units()->set_unit_id(id);
+
+    for (const auto& type : types) {
+        auto* unit = data->mutable_units(static_cast<int>(Id(type.type)));
+        unit->set_name(type.name);
+        unit->set_available(true);
+        unit->set_mineral_cost(type.minerals);
+        unit->set_food_required(type.food);
+        if (type.damage > 0.0f) {
+            auto* weapon = unit->add_weapons();
+            weapon->set_type(SC2APIProtocol::Weapon::Ground);
+            weapon->set_damage(type.damage);
+            weapon->set_attacks(type.type == sc2::UNIT_TYPEID::PROTOSS_ZEALOT ? 2 : 1);
+            weapon->set_range(type.range);
+            weapon->set_speed(type.cooldown);
+        }
+        if (type.structure)
+            unit->add_attributes(SC2APIProtocol::Attribute::Structure);
+    }
+    data->mutable_units(static_cast<int>(Id(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD)))->set_has_minerals(true);
+    data->mutable_units(static_cast<int>(Id(sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER)))->set_has_vespene(true);
+    for (const auto& recipe : RECIPES) {
+        auto* unit = data->mutable_units(static_cast<int>(recipe.produces));
+        unit->set_ability_id(recipe.ability);
+        unit->set_build_time(static_cast<float>(recipe.loops));
+    }
+
+    // Units report the race-specific ability in their orders; it remaps to
+    // the generic one bots issue
+    const std::pair<sc2::ABILITY_ID, sc2::ABILITY_ID> remaps[] = {
+        {sc2::ABILITY_ID::HARVEST_GATHER_PROBE, sc2::ABILITY_ID::HARVEST_GATHER},
+        {sc2::ABILITY_ID::HARVEST_RETURN_PROBE, sc2::ABILITY_ID::HARVEST_RETURN},
+        {sc2::ABILITY_ID::ATTACK_ATTACK, sc2::ABILITY_ID::ATTACK},
+    };
+    uint32_t max_ability = 0;
+    for (const auto& remap : remaps)
+        max_ability = std::max({max_ability, Id(remap.first), Id(remap.second)});
+    for (const auto& recipe : RECIPES)
+        max_ability = std::max(max_ability, recipe.ability);
+    for (uint32_t id = 0; id <= max_ability; ++id)
+        data->add_abilities()->set_ability_id(id);
+    for (const auto& remap : remaps)
+        data->mutable_abilities(static_cast<int>(Id(remap.first)))->set_remaps_to_ability_id(Id(remap.second));
+}
+
+void FakeGame::FillObservation(SC2APIProtocol::ResponseObservation* response) {
+    auto* observation = response->mutable_observation();
+    observation->set_game_loop(game_loop_);
+
+    int food_cap = 0;
+    int food_used = 0;
+    int workers = 0;
+    for (const auto& unit : units_) {
+        if (unit.alliance != SC2APIProtocol::Alliance::Self || unit.build_progress < 1.0f)
+            continue;
+        if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS))
+            food_cap += 15;
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_PYLON))
+            food_cap += 8;
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_PROBE)) {
+            food_used += 1;
+            ++workers;
+        }
+        else if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_ZEALOT))
+            food_used += 2;
+    }
+
+    auto* common = observation->mutable_player_common();
+    common->set_player_id(SELF);
+    common->set_minerals(static_cast<uint32_t>(minerals_));
+    common->set_vespene(static_cast<uint32_t>(vespene_));
+    common->set_food_cap(std::min(food_cap, 200));
+    common->set_food_used(food_used);
+    common->set_food_workers(workers);
+    common->set_food_army(food_used - workers);
+
+    auto* raw = observation->mutable_raw_data();
+    auto* camera = raw->mutable_player()->mutable_camera();
+    camera->set_x(24.5f);
+    camera->set_y(24.5f);
+
+    for (const auto& sim : units_) {
+        auto* unit = raw->add_units();
+        unit->set_display_type(SC2APIProtocol::DisplayType::Visible);
+        unit->set_alliance(sim.alliance);
+        unit->set_tag(sim.tag);
+        unit->set_unit_type(sim.type);
+        unit->set_owner(sim.owner);
+        unit->mutable_pos()->set_x(sim.x);
+        unit->mutable_pos()->set_y(sim.y);
+        unit->mutable_pos()->set_z(10.0f);
+        unit->set_facing(0.0f);
+        unit->set_radius(sim.radius);
+        unit->set_build_progress(sim.build_progress);
+        unit->set_health(std::max(sim.health, 0.0f));
+        unit->set_health_max(sim.health_max);
+        unit->set_shield(std::max(sim.shield, 0.0f));
+        unit->set_shield_max(sim.shield_max);
+        unit->set_is_powered(true);
+        if (sim.minerals > 0)
+            unit->set_mineral_contents(sim.minerals);
+        if (sim.vespene > 0)
+            unit->set_vespene_contents(sim.vespene);
+        if (sim.type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS) ||
+            (sim.type == Id(sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR) && sim.build_progress >= 1.0f)) {
+            unit->set_assigned_harvesters(AssignedHarvesters(sim));
+            unit->set_ideal_harvesters(IdealHarvesters(sim));
+        }
+        if (sim.cargo > 0) {
+            unit->add_buff_ids(sim.cargo_gas ? Id(sc2::BUFF_ID::CARRYHARVESTABLEVESPENEGEYSERGASPROTOSS) :
+                Id(sc2::BUFF_ID::CARRYMINERALFIELDMINERALS));
+        }
+
+        for (const auto& order : sim.orders) {
+            auto* out = unit->add_orders();
+            out->set_ability_id(order.ability);
+            if (order.target_tag != 0) {
+                out->set_target_unit_tag(order.target_tag);
+            }
+            else {
+                out->mutable_target_world_space_pos()->set_x(order.x);
+                out->mutable_target_world_space_pos()->set_y(order.y);
+            }
+            out->set_progress(order.progress);
+        }
+    }
+
+    for (uint64_t tag : dead_)
+        raw->mutable_event()->add_dead_units(tag);
+    dead_.clear();
+
+    auto* visibility = raw->mutable_map_state()->mutable_visibility();
+    visibility->set_bits_per_pixel(8);
+    visibility->mutable_size()->set_x(MAP_SIZE);
+    visibility->mutable_size()->set_y(MAP_SIZE);
+    visibility->set_data(std::string(MAP_SIZE * MAP_SIZE, static_cast<char>(2)));
+
+    auto* score = observation->mutable_score();
+    score->set_score_type(SC2APIProtocol::Score::Melee);
+    score->set_score(0);
+    score->mutable_score_details()->set_collection_rate_minerals(workers * 55.0f);
+
+    if (ended_) {
+        auto* result = response->add_player_result();
+        result->set_player_id(SELF);
+        result->set_result(result_);
+    }
+}
+
+SC2APIProtocol::ActionResult FakeGame::Command(const SC2APIProtocol::ActionRawUnitCommand& command) {
+    // Generic abilities show up on units as their specific variant
+    uint32_t ability = command.ability_id();
+    if (ability == Id(sc2::ABILITY_ID::HARVEST_GATHER))
+        ability = Id(sc2::ABILITY_ID::HARVEST_GATHER_PROBE);
+    else if (ability == Id(sc2::ABILITY_ID::HARVEST_RETURN))
+        ability = Id(sc2::ABILITY_ID::HARVEST_RETURN_PROBE);
+    else if (ability == Id(sc2::ABILITY_ID::ATTACK))
+        ability = Id(sc2::ABILITY_ID::ATTACK_ATTACK);
+
+    const Recipe* recipe = FindRecipe(ability);
+    bool builds_structure = recipe && recipe->ability != Id(sc2::ABILITY_ID::TRAIN_PROBE) &&
+        recipe->ability != Id(sc2::ABILITY_ID::TRAIN_ZEALOT);
+
+    for (uint64_t tag : command.unit_tags()) {
+        SimUnit* unit = Find(tag);
+        if (!unit || unit->alliance != SC2APIProtocol::Alliance::Self)
+            return SC2APIProtocol::ActionResult::CantFindSelectedUnit;
+
+        if (recipe) {
+            if (minerals_ < recipe->minerals)
+                return SC2APIProtocol::ActionResult::NotEnoughMinerals;
+            minerals_ -= recipe->minerals;
+        }
+
+        if (builds_structure) {
+            // Structures appear straight away and the probe goes back to mining
+            float x = command.target_world_space_pos().x();
+            float y = command.target_world_space_pos().y();
+            if (command.has_target_unit_tag()) {
+                SimUnit* geyser = Find(command.target_unit_tag());
+                if (!geyser)
+                    return SC2APIProtocol::ActionResult::CantTargetThatUnit;
+                x = geyser->x;
+                y = geyser->y;
+            }
+            Spawn(recipe->produces, SC2APIProtocol::Alliance::Self, x, y).build_progress = 0.0f;
+            continue;
+        }
+
+        SimOrder order;
+        order.ability = ability;
+        if (command.has_target_unit_tag()) {
+            order.target_tag = command.target_unit_tag();
+        }
+        else if (command.has_target_world_space_pos()) {
+            order.x = command.target_world_space_pos().x();
+            order.y = command.target_world_space_pos().y();
+        }
+
+        if (!command.queue_command() && !recipe)
+            unit->orders.clear();
+        unit->orders.push_back(order);
+    }
+
+    return SC2APIProtocol::ActionResult::Success;
+}
+
+void FakeGame::ApplyActions(const SC2APIProtocol::RequestAction& request, SC2APIProtocol::ResponseAction* response) {
+    for (const auto& action : request.actions()) {
+        ++stats_.actions;
+        SC2APIProtocol::ActionResult result = SC2APIProtocol::ActionResult::Success;
+        if (action.has_action_raw() && action.action_raw().has_unit_command())
+            result = Command(action.action_raw().unit_command());
+        response->add_result(result);
+    }
+}
+
+void FakeGame::AnswerQuery(const SC2APIProtocol::RequestQuery& request, SC2APIProtocol::ResponseQuery* response) const {
+    for (const auto& pathing : request.pathing()) {
+        float sx = pathing.start_pos().x();
+        float sy = pathing.start_pos().y();
+        for (const auto& unit : units_) {
+            if (pathing.has_unit_tag() && unit.tag == pathing.unit_tag()) {
+                sx = unit.x;
+                sy = unit.y;
+            }
+        }
+        response->add_pathing()->set_distance(std::hypot(pathing.end_pos().x() - sx, pathing.end_pos().y() - sy));
+    }
+
+    for (const auto& placement : request.placements()) {
+        float x = placement.target_pos().x();
+        float y = placement.target_pos().y();
+        bool free = x >= 2 && y >= 2 && x < MAP_SIZE - 2 && y < MAP_SIZE - 2;
+        for (const auto& unit : units_) {
+            if (unit.speed == 0.0f && std::fabs(unit.x - x) < unit.radius + 1.0f && std::fabs(unit.y - y) < unit.radius + 1.0f)
+                free = false;
+        }
+        response->add_placements()->set_result(free ? SC2APIProtocol::ActionResult::Success :
+            SC2APIProtocol::ActionResult::CantBuildLocationInvalid);
+    }
+
+    for (int i = 0; i < request.abilities_size(); ++i)
+        response->add_abilities();
+}
+
+std::string FakeGame::Handle(const std::string& payload) {
+    SC2APIProtocol::Request request;
+    SC2APIProtocol::Response response;
+    if (!request.ParseFromString(payload)) {
+        response.add_error("Malformed request");
+        return response.SerializeAsString();
+    }
+
+    ++stats_.requests;
+    if (request.has_id())
+        response.set_id(request.id());
+
+    auto now = Clock::now();
+    switch (request.request_case()) {
+        case SC2APIProtocol::Request::kPing:
+            response.mutable_ping()->set_game_version("fake");
+            response.mutable_ping()->set_base_build(0);
+            break;
+
+        case SC2APIProtocol::Request::kJoinGame:
+            response.mutable_join_game()->set_player_id(SELF);
+            break;
+
+        case SC2APIProtocol::Request::kGameInfo:
+            FillGameInfo(response.mutable_game_info());
+            break;
+
+        case SC2APIProtocol::Request::kData:
+            FillData(response.mutable_data());
+            break;
+
+        case SC2APIProtocol::Request::kObservation:
+            FillObservation(response.mutable_observation());
+            last_observation_sent_ = Clock::now();
+            break;
+
+        case SC2APIProtocol::Request::kAction:
+            ApplyActions(request.action(), response.mutable_action());
+            break;
+
+        case SC2APIProtocol::Request::kQuery:
+            ++stats_.queries;
+            AnswerQuery(request.query(), response.mutable_query());
+            break;
+
+        case SC2APIProtocol::Request::kStep: {
+            if (has_last_step_) {
+                stats_.cycle_us.push_back(std::chrono::duration<double, std::micro>(now - last_step_request_).count());
+                stats_.think_us.push_back(std::chrono::duration<double, std::micro>(now - last_observation_sent_).count());
+            }
+            else {
+                stats_.first_step = now;
+            }
+            has_last_step_ = true;
+            last_step_request_ = now;
+            stats_.last_step = now;
+
+            Advance(std::max(1u, request.step().count()));
+            response.mutable_step()->set_simulation_loop(game_loop_);
+            break;
+        }
+
+        case SC2APIProtocol::Request::kLeaveGame:
+            ended_ = true;
+            response.mutable_leave_game();
+            break;
+
+        case SC2APIProtocol::Request::kQuit:
+            ended_ = true;
+            response.mutable_quit();
+            break;
+
+        case SC2APIProtocol::Request::kDebug:
+            response.mutable_debug();
+            break;
+
+        default:
+            response.add_error("Request not supported by the fake server");
+            break;
+    }
+
+    response.set_status(ended_ ? SC2APIProtocol::Status::ended : SC2APIProtocol::Status::in_game);
+    return response.SerializeAsString();
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1));
+    return values[index];
+}
+
+void PrintSeries(const char* name, const std::vector<double>& values) {
+    double sum = 0.0;
+    double max = 0.0;
+    for (double v : values) {
+        sum += v;
+        max = std::max(max, v);
+    }
+    double mean = values.empty() ? 0.0 : sum / values.size();
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+        << " mean " << std::setw(9) << mean
+        << "  p50 " << std::setw(9) << Percentile(values, 0.50)
+        << "  p95 " << std::setw(9) << Percentile(values, 0.95)
+        << "  p99 " << std::setw(9) << Percentile(values, 0.99)
+        << "  max " << std::setw(9) << max << " us" << std::endl;
+}
+
+void FakeGame::PrintReport() const {
+    double seconds = std::chrono::duration<double>(stats_.last_step - stats_.first_step).count();
+    std::cout << "Game loop " << game_loop_ << ", result " << SC2APIProtocol::Result_Name(result_) << std::endl;
+    std::cout << "Requests " << stats_.requests << ", actions " << stats_.actions
+        << ", queries " << stats_.queries << std::endl;
+    for (const auto& unit : units_) {
+        if (unit.type == Id(sc2::UNIT_TYPEID::PROTOSS_NEXUS)) {
+            std::cout << "Harvesters at Nexus " << unit.x << "," << unit.y << ": " << AssignedHarvesters(unit)
+                << "/" << IdealHarvesters(unit) << std::endl;
+        }
+    }
+    PrintSeries("step round-trip", stats_.cycle_us);
+    PrintSeries("bot turnaround", stats_.think_us);
+    if (seconds > 0.0) {
+        std::cout << std::setprecision(1) << "Throughput " << stats_.cycle_us.size() / seconds << " steps/s, "
+            << game_loop_ / seconds << " game loops/s" << std::endl;
+    }
+}
+
+struct Server {
+    FakeGame* game;
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+};
+
+int OnConnect(const mg_connection*, void*) {
+    return 0;
+}
+
+void OnReady(mg_connection*, void*) {
+    std::cout << "Bot connected" << std::endl;
+}
+
+int OnData(mg_connection* conn, int flags, char* data, size_t data_len, void* user_data) {
+    auto* server = static_cast<Server*>(user_data);
+    int opcode = flags & 0x0f;
+    if (opcode == MG_WEBSOCKET_OPCODE_CONNECTION_CLOSE)
+        return 0;
+    if (opcode != MG_WEBSOCKET_OPCODE_BINARY)
+        return 1;
+
+    std::string reply;
+    bool ended;
+    {
+        std::lock_guard<std::mutex> lock(server->mutex);
+        reply = server->game->Handle(std::string(data, data_len));
+        ended = server->game->Ended();
+    }
+    mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_BINARY, reply.data(), reply.size());
+
+    if (ended) {
+        std::lock_guard<std::mutex> lock(server->mutex);
+        server->finished = true;
+        server->done.notify_all();
+    }
+    return 1;
+}
+
+void OnClose(const mg_connection*, void* user_data) {
+    auto* server = static_cast<Server*>(user_data);
+    std::lock_guard<std::mutex> lock(server->mutex);
+    server->finished = true;
+    server->done.notify_all();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string port = argc > 1 ? argv[1] : "5677";
+    uint32_t max_loops = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 22400;
+
+    FakeGame game(max_loops);
+    Server server;
+    server.game = &game;
+
+    mg_init_library(0);
+    // Loopback only: the bot connects locally and nothing else should reach it
+    std::string listen = "127.0.0.1:" + port;
+    const char* options[] = {"listening_ports", listen.c_str(), "num_threads", "2", nullptr};
+    mg_callbacks callbacks;
+    std::memset(&callbacks, 0, sizeof(callbacks));
+    mg_context* context = mg_start(&callbacks, nullptr, options);
+    if (!context) {
+        std::cerr << "Failed to listen on port " << port << std::endl;
+        return 1;
+    }
+    mg_set_websocket_handler(context, "/sc2api", OnConnect, OnReady, OnData, OnClose, &server);
+    std::cout << "Fake SC2 server listening on 127.0.0.1:" << port << "/sc2api" << std::endl;
+
+    {
+        std::unique_lock<std::mutex> lock(server.mutex);
+        server.done.wait(lock, [&server] { return server.finished; });
+    }
+
+    mg_stop(context);
+    mg_exit_library();
+
+    game.PrintReport();
+    return 0;
+}
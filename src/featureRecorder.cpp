@@ -0,0 +1,214 @@
+#include "featureRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// In FeatureRow field order.
+const char* COLUMN_NAMES[] = {
+    "game_loop", "bot_state",
+    "workers", "army", "production_buildings", "tech_buildings", "base_buildings", "defensive_buildings",
+    "minerals", "vespene", "food_used", "food_cap",
+    "enemy_visible", "enemy_near_base",
+    "commanded_workers", "commanded_army", "commanded_structures"
+};
+
+static_assert(sizeof(COLUMN_NAMES) / sizeof(COLUMN_NAMES[0]) == FeatureRecorder::COLUMN_COUNT,
+    "Every FeatureRow field needs a column name");
+
+// The writer naps this long when the queue is empty.
+const auto IDLE_WAIT = std::chrono::milliseconds(2);
+
+}  // namespace
+
+FeatureRecorder::~FeatureRecorder() {
+    Finish(0, 0);
+}
+
+bool FeatureRecorder::Start(const std::string& path) {
+    if (IsRecording())
+        return false;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+        return false;
+
+    offset_ = 0;
+    failed_ = false;
+    rows_ = 0;
+    total_rows_ = 0;
+    index_.clear();
+    columns_.assign(static_cast<size_t>(COLUMN_COUNT) * ROWS_PER_CHUNK, 0);
+    dropped_.store(0);
+    finishing_.store(false);
+
+    FileHeader header = {FILE_MAGIC, VERSION, COLUMN_COUNT, ROWS_PER_CHUNK};
+    Write(&header, sizeof(header));
+    for (const char* name : COLUMN_NAMES) {
+        char padded[COLUMN_NAME_SIZE] = {};
+        std::strncpy(padded, name, COLUMN_NAME_SIZE - 1);
+        Write(padded, sizeof(padded));
+    }
+
+    thread_ = std::thread(&FeatureRecorder::Run, this);
+    return true;
+}
+
+void FeatureRecorder::Record(const FeatureRow& row) {
+    if (!IsRecording())
+        return;
+    if (!queue_.Push(row))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FeatureRecorder::Finish(uint32_t result, uint32_t game_loops) {
+    if (!IsRecording())
+        return true;
+
+    result_ = result;
+    game_loops_ = game_loops;
+    finishing_.store(true, std::memory_order_release);
+    thread_.join();
+
+    bool written = !failed_ && std::fflush(file_) == 0;
+    if (std::fclose(file_) != 0)
+        written = false;
+    file_ = nullptr;
+    return written;
+}
+
+void FeatureRecorder::Run() {
+    FeatureRow row;
+    for (;;) {
+        if (!queue_.Pop(&row)) {
+            // Finish is only called after the last Record, so an empty
+            // queue here means everything has been seen
+            if (finishing_.load(std::memory_order_acquire) && queue_.Empty())
+                break;
+            std::this_thread::sleep_for(IDLE_WAIT);
+            continue;
+        }
+
+        const uint32_t* fields = reinterpret_cast<const uint32_t*>(&row);
+        for (uint32_t c = 0; c < COLUMN_COUNT; ++c)
+            columns_[static_cast<size_t>(c) * ROWS_PER_CHUNK + rows_] = fields[c];
+
+        if (++rows_ == ROWS_PER_CHUNK)
+            WriteChunk();
+    }
+
+    if (rows_ > 0)
+        WriteChunk();
+
+    // The index holds 64-bit offsets; keep it 8-byte aligned
+    static const uint8_t zeros[8] = {};
+    Write(zeros, static_cast<size_t>((8 - offset_ % 8) % 8));
+
+    uint64_t index_offset = offset_;
+    Write(index_.data(), index_.size() * sizeof(ChunkIndex));
+
+    FileFooter footer = {FOOTER_MAGIC, static_cast<uint32_t>(index_.size()), result_, game_loops_,
+        index_offset, total_rows_};
+    Write(&footer, sizeof(footer));
+}
+
+void FeatureRecorder::WriteChunk() {
+    ChunkIndex entry = {offset_, rows_, columns_[0]};
+    ChunkHeader header = {CHUNK_MAGIC, rows_, columns_[0],
+        COLUMN_COUNT * rows_ * static_cast<uint32_t>(sizeof(uint32_t))};
+    Write(&header, sizeof(header));
+    for (uint32_t c = 0; c < COLUMN_COUNT; ++c)
+        Write(&columns_[static_cast<size_t>(c) * ROWS_PER_CHUNK], rows_ * sizeof(uint32_t));
+
+    index_.push_back(entry);
+    total_rows_ += rows_;
+    rows_ = 0;
+}
+
+void FeatureRecorder::Write(const void* data, size_t size) {
+    // A short write leaves the file unreadable past it, so stop there
+    if (size == 0 || failed_)
+        return;
+    if (std::fwrite(data, 1, size, file_) != size) {
+        failed_ = true;
+        return;
+    }
+    offset_ += size;
+}
+
+bool FeatureFile::Open(const std::string& path) {
+    Close();
+    if (!file_.OpenRead(path))
+        return false;
+
+    using Recorder = FeatureRecorder;
+    const uint8_t* data = file_.Data();
+    size_t size = file_.Size();
+    if (size < sizeof(Recorder::FileHeader) + sizeof(Recorder::FileFooter)) {
+        Close();
+        return false;
+    }
+
+    Recorder::FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    std::memcpy(&footer_, data + size - sizeof(footer_), sizeof(footer_));
+    size_t names_end = sizeof(header) + static_cast<size_t>(header.column_count) * Recorder::COLUMN_NAME_SIZE;
+    size_t index_end = size - sizeof(footer_);
+    if (header.magic != Recorder::FILE_MAGIC || header.version != Recorder::VERSION ||
+        footer_.magic != Recorder::FOOTER_MAGIC || header.column_count == 0 || names_end > index_end ||
+        footer_.index_offset % 8 != 0 || footer_.index_offset < names_end ||
+        (index_end - footer_.index_offset) / sizeof(Recorder::ChunkIndex) != footer_.chunk_count) {
+        Close();
+        return false;
+    }
+    column_count_ = header.column_count;
+    index_ = reinterpret_cast<const Recorder::ChunkIndex*>(data + footer_.index_offset);
+
+    // Every chunk has to lie between the names and the index
+    for (uint32_t i = 0; i < footer_.chunk_count; ++i) {
+        const Recorder::ChunkIndex& entry = index_[i];
+        uint64_t columns = static_cast<uint64_t>(column_count_) * entry.row_count * sizeof(uint32_t);
+        if (entry.offset < names_end || entry.offset % 4 != 0 ||
+            entry.offset + sizeof(Recorder::ChunkHeader) + columns > footer_.index_offset) {
+            Close();
+            return false;
+        }
+        Recorder::ChunkHeader chunk;
+        std::memcpy(&chunk, data + entry.offset, sizeof(chunk));
+        if (chunk.magic != Recorder::CHUNK_MAGIC || chunk.row_count != entry.row_count || chunk.byte_size != columns) {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FeatureFile::Close() {
+    file_.Close();
+    column_count_ = 0;
+    footer_ = {};
+    index_ = nullptr;
+}
+
+std::string FeatureFile::ColumnName(uint32_t column) const {
+    if (column >= column_count_)
+        return std::string();
+    const char* name = reinterpret_cast<const char*>(file_.Data() + sizeof(FeatureRecorder::FileHeader) +
+        static_cast<size_t>(column) * FeatureRecorder::COLUMN_NAME_SIZE);
+    return std::string(name, std::find(name, name + FeatureRecorder::COLUMN_NAME_SIZE, '\0'));
+}
+
+uint32_t FeatureFile::ChunkRows(uint32_t chunk) const {
+    return chunk < footer_.chunk_count ? index_[chunk].row_count : 0;
+}
+
+const uint32_t* FeatureFile::Column(uint32_t chunk, uint32_t column) const {
+    if (chunk >= footer_.chunk_count || column >= column_count_)
+        return nullptr;
+    const FeatureRecorder::ChunkIndex& entry = index_[chunk];
+    size_t offset = entry.offset + sizeof(FeatureRecorder::ChunkHeader) +
+        static_cast<size_t>(column) * entry.row_count * sizeof(uint32_t);
+    return reinterpret_cast<const uint32_t*>(file_.Data() + offset);
+}
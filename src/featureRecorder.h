@@ -0,0 +1,169 @@
+#ifndef FEATURE_RECORDER_H
+#define FEATURE_RECORDER_H
+
+#include "mappedFile.h"
+#include "spscQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One step of training data: what the bot saw and what it did.
+// Every field becomes one column of the recording.
+struct FeatureRow {
+    uint32_t game_loop = 0;
+    uint32_t bot_state = 0;
+
+    // Our units per category
+    uint32_t workers = 0;
+    uint32_t army = 0;
+    uint32_t production_buildings = 0;
+    uint32_t tech_buildings = 0;
+    uint32_t base_buildings = 0;
+    uint32_t defensive_buildings = 0;
+
+    // Resources and supply
+    uint32_t minerals = 0;
+    uint32_t vespene = 0;
+    uint32_t food_used = 0;
+    uint32_t food_cap = 0;
+
+    // Enemies visible now, and remembered near our main base recently
+    uint32_t enemy_visible = 0;
+    uint32_t enemy_near_base = 0;
+
+    // Units commanded this step, by what they are
+    uint32_t commanded_workers = 0;
+    uint32_t commanded_army = 0;
+    uint32_t commanded_structures = 0;
+};
+
+// Streams FeatureRows to an append-only columnar file from a background
+// thread. The step only pushes the row into a lock-free queue; the writer
+// gathers rows into chunks and appends each chunk column by column. A footer
+// with the chunk index and the game result is added when the game ends, so
+// a finished file can be mapped and its chunks located without scanning;
+// FeatureFile below does that.
+//
+// File layout, little-endian, all blocks 4-byte aligned:
+//   FileHeader, then column names (COLUMN_NAME_SIZE bytes each)
+//   per chunk: ChunkHeader, then per column row_count uint32 values
+//   ChunkIndex[chunk_count] (8-byte aligned), then FileFooter
+//
+// Columns are fixed-width so they can be viewed in place from a mapping.
+class FeatureRecorder {
+public:
+    static constexpr uint32_t FILE_MAGIC = 0x52464242;      // "BBFR"
+    static constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843;     // "CHNK"
+    static constexpr uint32_t FOOTER_MAGIC = 0x45464242;    // "BBFE"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t ROWS_PER_CHUNK = 512;
+    static constexpr uint32_t COLUMN_COUNT = sizeof(FeatureRow) / sizeof(uint32_t);
+    static constexpr size_t COLUMN_NAME_SIZE = 24;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t column_count;
+        uint32_t rows_per_chunk;
+    };
+
+    struct ChunkHeader {
+        uint32_t magic;
+        uint32_t row_count;
+        uint32_t first_loop;
+        uint32_t byte_size;         // columns only, excluding this header
+    };
+
+    struct ChunkIndex {
+        uint64_t offset;            // of the ChunkHeader
+        uint32_t row_count;
+        uint32_t first_loop;
+    };
+
+    struct FileFooter {
+        uint32_t magic;
+        uint32_t chunk_count;
+        uint32_t result;            // GameResult of the recording player
+        uint32_t game_loops;
+        uint64_t index_offset;
+        uint64_t total_rows;
+    };
+
+    FeatureRecorder() = default;
+    FeatureRecorder(const FeatureRecorder&) = delete;
+    FeatureRecorder& operator=(const FeatureRecorder&) = delete;
+    ~FeatureRecorder();
+
+    // Creates the file and starts the writer thread.
+    bool Start(const std::string& path);
+
+    // Step thread: queue a row. Never blocks; rows are dropped and counted
+    // if the writer falls a whole queue behind.
+    void Record(const FeatureRow& row);
+
+    // Flushes everything, writes the footer and stops the writer.
+    // Returns false if any part of the file failed to write.
+    bool Finish(uint32_t result, uint32_t game_loops);
+
+    bool IsRecording() const { return thread_.joinable(); }
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+    void WriteChunk();
+    void Write(const void* data, size_t size);
+
+    std::FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    bool failed_ = false;               // a write failed; nothing more is written
+
+    SpscQueue<FeatureRow, 1024> queue_;
+    std::atomic<bool> finishing_{false};
+    std::atomic<uint64_t> dropped_{0};
+    uint32_t result_ = 0;
+    uint32_t game_loops_ = 0;
+
+    // Writer thread only
+    std::vector<uint32_t> columns_;     // [column][row] for the open chunk
+    uint32_t rows_ = 0;
+    std::vector<ChunkIndex> index_;
+    uint64_t total_rows_ = 0;
+
+    std::thread thread_;
+};
+
+// Read-only view of a finished recording. The file is mapped and checked
+// once on open; columns are then handed out as pointers into the mapping.
+class FeatureFile {
+public:
+    // Maps the file and checks its header, footer and chunk index.
+    bool Open(const std::string& path);
+
+    void Close();
+
+    uint32_t ColumnCount() const { return column_count_; }
+    uint32_t ChunkCount() const { return footer_.chunk_count; }
+    uint64_t TotalRows() const { return footer_.total_rows; }
+    uint32_t Result() const { return footer_.result; }
+    uint32_t GameLoops() const { return footer_.game_loops; }
+
+    // Name of a column, in FeatureRow field order.
+    std::string ColumnName(uint32_t column) const;
+
+    uint32_t ChunkRows(uint32_t chunk) const;
+
+    // ChunkRows(chunk) values of one column, valid while the file is open.
+    const uint32_t* Column(uint32_t chunk, uint32_t column) const;
+
+private:
+    MappedFile file_;
+    uint32_t column_count_ = 0;
+    FeatureRecorder::FileFooter footer_ = {};
+    const FeatureRecorder::ChunkIndex* index_ = nullptr;
+};
+
+#endif // FEATURE_RECORDER_H
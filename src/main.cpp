@@ -17,11 +17,12 @@ namespace
 
 struct Options
 {
-    Options(): GamePort(0), StartPort(0)
+    Options(): GamePort(0), StartPort(0), DecisionThread(false)
     {}
 
     int32_t GamePort;
     int32_t StartPort;
+    bool DecisionThread;
     std::string ServerAddress;
     std::string OpponentId;
 };
@@ -35,6 +36,7 @@ void ParseArguments(int argc, char* argv[], Options* options_)
             {"-o", "--StartPort", "Starting server port", false},
             {"-l", "--LadderServer", "Ladder server address", false},
             {"-x", "--OpponentId", "PlayerId of opponent", false},
+            {"-d", "--DecisionThread", "Score targets on a separate thread (on/off)", false},
         });
 
     arg_parser.Parse(argc, argv);
@@ -51,6 +53,10 @@ void ParseArguments(int argc, char* argv[], Options* options_)
     if (arg_parser.Get("OpponentId", OpponentId))
         options_->OpponentId = OpponentId;
 
+    std::string DecisionThread;
+    if (arg_parser.Get("DecisionThread", DecisionThread))
+        options_->DecisionThread = DecisionThread == "on" || DecisionThread == "1";
+
     arg_parser.Get("LadderServer", options_->ServerAddress);
 }
 
@@ -62,10 +68,12 @@ int main(int argc, char* argv[])
     ParseArguments(argc, argv, &options);
 
     sc2::Coordinator coordinator;
-    Bot bot;
+    DecisionTreeBot bot;
+    bot.opponent_id = options.OpponentId;
+    bot.pipelined_decisions = options.DecisionThread;
 
     size_t num_agents = 2;
-    coordinator.SetParticipants({ CreateParticipant(sc2::Race::Random, &bot, "BlankBot") });
+    coordinator.SetParticipants({ CreateParticipant(sc2::Race::Protoss, &bot, "BlankBot") });
 
     std::cout << "Connecting to port " << options.GamePort << std::endl;
     coordinator.Connect(options.GamePort);
@@ -80,8 +88,12 @@ int main(int argc, char* argv[])
     coordinator.SetTimeoutMS(10000);
     std::cout << "Successfully joined game" << std::endl;
 
-    while (coordinator.Update())
-    {}
+    // Step as far as the bot allows: single loops in fights, coarser when quiet
+    do
+    {
+        coordinator.SetStepSize(bot.step_size);
+    }
+    while (coordinator.Update());
 
     return 0;
 }
@@ -107,6 +119,9 @@ int main(int argc, char* argv[])
 
     //Bot bot;
     DecisionTreeBot bot;
+
+    // NOTE: Uncomment to score targets on a separate decision thread.
+    // bot.pipelined_decisions = true;
     coordinator.SetParticipants(
         {
             CreateParticipant(sc2::Race::Protoss, &bot, "My Bot"),
@@ -122,8 +137,12 @@ int main(int argc, char* argv[])
     coordinator.LaunchStarcraft();
     coordinator.StartGame(argv[1]);
 
-    while (coordinator.Update())
-    {}
+    // Step as far as the bot allows: single loops in fights, coarser when quiet
+    do
+    {
+        coordinator.SetStepSize(bot.step_size);
+    }
+    while (coordinator.Update());
 
     return 0;
 }
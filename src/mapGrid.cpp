@@ -0,0 +1,399 @@
+#include "mapGrid.h"
+
+#include <bitset>
+#include <cstring>
+
+#ifdef BLANKBOT_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace sc2;
+
+namespace {
+
+const uint64_t LOW_SEVEN = 0x7F7F7F7F7F7F7F7Full;
+const uint64_t BYTE_ONES = 0x0101010101010101ull;
+
+// Moves the high bit of byte i to bit i
+const uint64_t GATHER = 0x0102040810204080ull;
+
+// Row padding: 4 words, one AVX2 register
+const int STRIDE_WORDS = 4;
+
+uint64_t LowMask(int count) {
+    return count >= 64 ? ~0ull : (1ull << count) - 1;
+}
+
+uint8_t Reverse(uint8_t byte) {
+    byte = static_cast<uint8_t>((byte & 0xF0) >> 4 | (byte & 0x0F) << 4);
+    byte = static_cast<uint8_t>((byte & 0xCC) >> 2 | (byte & 0x33) << 2);
+    return static_cast<uint8_t>((byte & 0xAA) >> 1 | (byte & 0x55) << 1);
+}
+
+// One bit per byte of eight little-endian cells, set where the cell equals value
+uint8_t EqualMask8(const uint8_t* cells, uint8_t value) {
+    uint64_t bytes;
+    std::memcpy(&bytes, cells, sizeof(bytes));
+    uint64_t other = bytes ^ (BYTE_ONES * value);
+    uint64_t zero = ~(((other & LOW_SEVEN) + LOW_SEVEN) | other | LOW_SEVEN);
+    return static_cast<uint8_t>(((zero >> 7) * GATHER) >> 56);
+}
+
+struct AndOp {
+    static uint64_t Apply(uint64_t a, uint64_t b) { return a & b; }
+#ifdef BLANKBOT_AVX2
+    static __m256i Apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct OrOp {
+    static uint64_t Apply(uint64_t a, uint64_t b) { return a | b; }
+#ifdef BLANKBOT_AVX2
+    static __m256i Apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct AndNotOp {
+    static uint64_t Apply(uint64_t a, uint64_t b) { return a & ~b; }
+#ifdef BLANKBOT_AVX2
+    static __m256i Apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+// a = a op b over count words, count a multiple of STRIDE_WORDS
+template <typename Op>
+void Combine(uint64_t* a, const uint64_t* b, size_t count) {
+#ifdef BLANKBOT_AVX2
+    for (size_t i = 0; i < count; i += STRIDE_WORDS) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), Op::Apply(x, y));
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+        a[i] = Op::Apply(a[i], b[i]);
+#endif
+}
+
+size_t PopCount(uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+}  // namespace
+
+ImageView::ImageView(const ImageData& image)
+    : ImageView(image.data.data(), image.data.size(), image.width, image.height, image.bits_per_pixel) {
+}
+
+ImageView::ImageView(const void* data, size_t size, int width, int height, int bits_per_pixel)
+    : data_(static_cast<const uint8_t*>(data)), size_(size), width_(width), height_(height),
+      bits_per_pixel_(bits_per_pixel) {
+}
+
+bool ImageView::Get(int x, int y) const {
+    return Value(x, y) != 0;
+}
+
+uint8_t ImageView::Value(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_)
+        return 0;
+
+    size_t index = static_cast<size_t>(y) * width_ + x;
+    if (bits_per_pixel_ == 1) {
+        size_t byte = index >> 3;
+        return byte < size_ ? (data_[byte] >> (7 - (index & 7))) & 1 : 0;
+    }
+
+    size_t byte = index * (bits_per_pixel_ / 8);
+    return byte < size_ ? data_[byte] : 0;
+}
+
+void BitGrid::Resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    stride_ = ((width + 63) / 64 + STRIDE_WORDS - 1) / STRIDE_WORDS * STRIDE_WORDS;
+    words_.assign(static_cast<size_t>(stride_) * height, 0);
+}
+
+uint64_t BitGrid::Span(int x, int y, int count) const {
+    size_t index = static_cast<size_t>(y) * stride_ + (x >> 6);
+    int offset = x & 63;
+    uint64_t bits = words_[index] >> offset;
+    if (offset + count > 64 && (x >> 6) + 1 < stride_)
+        bits |= words_[index + 1] << (64 - offset);
+    return bits & LowMask(count);
+}
+
+void BitGrid::ClearPadding() {
+    int full = width_ >> 6;
+    int tail = width_ & 63;
+    for (int y = 0; y < height_; ++y) {
+        uint64_t* row = Row(y);
+        int first = full;
+        if (tail) {
+            row[full] &= LowMask(tail);
+            ++first;
+        }
+        std::fill(row + first, row + stride_, 0);
+    }
+}
+
+void BitGrid::Clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+void BitGrid::Fill() {
+    std::fill(words_.begin(), words_.end(), ~0ull);
+    ClearPadding();
+}
+
+void BitGrid::StampRect(int x0, int y0, int width, int height, bool value) {
+    int x1 = std::min(x0 + width, width_);
+    x0 = std::max(x0, 0);
+    if (x0 >= x1)
+        return;
+
+    for (int y = std::max(y0, 0); y < std::min(y0 + height, height_); ++y) {
+        uint64_t* row = Row(y);
+        for (int x = x0; x < x1;) {
+            int count = std::min(64 - (x & 63), x1 - x);
+            uint64_t mask = LowMask(count) << (x & 63);
+            row[x >> 6] = value ? row[x >> 6] | mask : row[x >> 6] & ~mask;
+            x += count;
+        }
+    }
+}
+
+BitGrid& BitGrid::And(const BitGrid& other) {
+    Combine<AndOp>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+BitGrid& BitGrid::Or(const BitGrid& other) {
+    Combine<OrOp>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+BitGrid& BitGrid::AndNot(const BitGrid& other) {
+    Combine<AndNotOp>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+BitGrid& BitGrid::Not() {
+    for (auto& word : words_)
+        word = ~word;
+    ClearPadding();
+    return *this;
+}
+
+size_t BitGrid::Count() const {
+    size_t count = 0;
+    for (uint64_t word : words_)
+        count += PopCount(word);
+    return count;
+}
+
+size_t BitGrid::CountAnd(const BitGrid& other) const {
+    size_t count = 0;
+    for (size_t i = 0; i < words_.size(); ++i)
+        count += PopCount(words_[i] & other.words_[i]);
+    return count;
+}
+
+void BitGrid::Dilate(int steps) {
+    std::vector<uint64_t> horizontal(words_.size());
+    for (int step = 0; step < steps; ++step) {
+        for (int y = 0; y < height_; ++y) {
+            const uint64_t* row = Row(y);
+            uint64_t* out = &horizontal[static_cast<size_t>(y) * stride_];
+            for (int i = 0; i < stride_; ++i) {
+                uint64_t left = row[i] << 1 | (i > 0 ? row[i - 1] >> 63 : 0);
+                uint64_t right = row[i] >> 1 | (i + 1 < stride_ ? row[i + 1] << 63 : 0);
+                out[i] = row[i] | left | right;
+            }
+        }
+
+        words_ = horizontal;
+        for (int y = 0; y < height_; ++y) {
+            if (y > 0)
+                Combine<OrOp>(Row(y), &horizontal[static_cast<size_t>(y - 1) * stride_], stride_);
+            if (y + 1 < height_)
+                Combine<OrOp>(Row(y), &horizontal[static_cast<size_t>(y + 1) * stride_], stride_);
+        }
+        ClearPadding();
+    }
+}
+
+void BitGrid::Erode(int steps) {
+    std::vector<uint64_t> horizontal(words_.size());
+    for (int step = 0; step < steps; ++step) {
+        // Padding bits are clear, so cells past either edge count as unset
+        for (int y = 0; y < height_; ++y) {
+            const uint64_t* row = Row(y);
+            uint64_t* out = &horizontal[static_cast<size_t>(y) * stride_];
+            for (int i = 0; i < stride_; ++i) {
+                uint64_t left = row[i] << 1 | (i > 0 ? row[i - 1] >> 63 : 0);
+                uint64_t right = row[i] >> 1 | (i + 1 < stride_ ? row[i + 1] << 63 : 0);
+                out[i] = row[i] & left & right;
+            }
+        }
+
+        words_ = horizontal;
+        for (int y = 0; y < height_; ++y) {
+            if (y == 0 || y + 1 == height_) {
+                std::fill(Row(y), Row(y) + stride_, 0);
+                continue;
+            }
+            Combine<AndOp>(Row(y), &horizontal[static_cast<size_t>(y - 1) * stride_], stride_);
+            Combine<AndOp>(Row(y), &horizontal[static_cast<size_t>(y + 1) * stride_], stride_);
+        }
+    }
+}
+
+void BitGrid::FloodFill(int x, int y, BitGrid* out) const {
+    out->Resize(width_, height_);
+    if (!Contains(x, y) || !Get(x, y))
+        return;
+
+    static const int DX[4] = {1, -1, 0, 0};
+    static const int DY[4] = {0, 0, 1, -1};
+
+    std::vector<std::pair<int, int>> stack;
+    out->Set(x, y, true);
+    stack.push_back({x, y});
+    while (!stack.empty()) {
+        auto cell = stack.back();
+        stack.pop_back();
+        for (int d = 0; d < 4; ++d) {
+            int nx = cell.first + DX[d];
+            int ny = cell.second + DY[d];
+            if (Contains(nx, ny) && Get(nx, ny) && !out->Get(nx, ny)) {
+                out->Set(nx, ny, true);
+                stack.push_back({nx, ny});
+            }
+        }
+    }
+}
+
+BitGrid BitGrid::FromImage(const ImageView& image) {
+    BitGrid grid(image.Width(), image.Height());
+    if (image.BitsPerPixel() == 8) {
+        FromImageEqual(image, 0, &grid);
+        grid.Not();
+        return grid;
+    }
+
+    // Packed 1-bit rows start on a byte when the width is a multiple of
+    // eight; the image keeps the leftmost cell in the high bit
+    size_t row_bytes = static_cast<size_t>(image.Width()) / 8;
+    if (image.BitsPerPixel() == 1 && image.Width() % 8 == 0 &&
+        image.Size() >= row_bytes * image.Height()) {
+        for (int y = 0; y < image.Height(); ++y) {
+            const uint8_t* bytes = image.Data() + row_bytes * y;
+            uint64_t* row = grid.Row(y);
+            for (size_t i = 0; i < row_bytes; ++i)
+                row[i >> 3] |= static_cast<uint64_t>(Reverse(bytes[i])) << ((i & 7) * 8);
+        }
+        return grid;
+    }
+
+    for (int y = 0; y < image.Height(); ++y) {
+        for (int x = 0; x < image.Width(); ++x) {
+            if (image.Get(x, y))
+                grid.Set(x, y, true);
+        }
+    }
+    return grid;
+}
+
+void BitGrid::FromImageEqual(const ImageView& image, uint8_t value, BitGrid* out) {
+    out->Resize(image.Width(), image.Height());
+    int width = image.Width();
+    int height = image.Height();
+
+    if (image.BitsPerPixel() != 8 || image.Size() < static_cast<size_t>(width) * height) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (image.Value(x, y) == value)
+                    out->Set(x, y, true);
+            }
+        }
+        return;
+    }
+
+#ifdef BLANKBOT_AVX2
+    __m256i wanted = _mm256_set1_epi8(static_cast<char>(value));
+#endif
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* cells = image.Data() + static_cast<size_t>(y) * width;
+        uint64_t* row = out->Row(y);
+        int x = 0;
+#ifdef BLANKBOT_AVX2
+        for (; x + 32 <= width; x += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + x));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, wanted)));
+            row[x >> 6] |= static_cast<uint64_t>(mask) << (x & 63);
+        }
+#endif
+        for (; x + 8 <= width; x += 8)
+            row[x >> 6] |= static_cast<uint64_t>(EqualMask8(cells + x, value)) << (x & 63);
+        for (; x < width; ++x) {
+            if (cells[x] == value)
+                row[x >> 6] |= 1ull << (x & 63);
+        }
+    }
+}
+
+BitGrid PlayableMask(const GameInfo& game_info) {
+    BitGrid mask(game_info.width, game_info.height);
+    int x0 = static_cast<int>(game_info.playable_min.x);
+    int y0 = static_cast<int>(game_info.playable_min.y);
+    int x1 = static_cast<int>(game_info.playable_max.x);
+    int y1 = static_cast<int>(game_info.playable_max.y);
+    mask.StampRect(x0, y0, x1 - x0, y1 - y0, true);
+    return mask;
+}
+
+int LabelComponents(const BitGrid& cells, ValueGrid<int32_t>* labels) {
+    int width = cells.Width();
+    int height = cells.Height();
+    labels->Resize(width, height, -1);
+
+    static const int DX[4] = {1, -1, 0, 0};
+    static const int DY[4] = {0, 0, 1, -1};
+
+    std::vector<int> stack;
+    int label = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint64_t* row = cells.Row(y);
+        for (int x = 0; x < width; ++x) {
+            // Skip empty words outright
+            if ((x & 63) == 0 && row[x >> 6] == 0) {
+                x += 63;
+                continue;
+            }
+            if (!cells.Get(x, y) || labels->Get(x, y) >= 0)
+                continue;
+
+            labels->Set(x, y, label);
+            stack.push_back(y * width + x);
+            while (!stack.empty()) {
+                int cell = stack.back();
+                stack.pop_back();
+                int cx = cell % width;
+                int cy = cell / width;
+                for (int d = 0; d < 4; ++d) {
+                    int nx = cx + DX[d];
+                    int ny = cy + DY[d];
+                    if (cells.Contains(nx, ny) && cells.Get(nx, ny) && labels->Get(nx, ny) < 0) {
+                        labels->Set(nx, ny, label);
+                        stack.push_back(ny * width + nx);
+                    }
+                }
+            }
+            ++label;
+        }
+    }
+    return label;
+}
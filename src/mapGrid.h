@@ -0,0 +1,191 @@
+#ifndef MAP_GRID_H
+#define MAP_GRID_H
+
+#include <sc2api/sc2_api.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Map layers shared by the placement, pathing and visibility code.
+//
+// Grids cover the whole map in the same cell coordinates as the ImageData
+// layers in GameInfo and the raw observation, so a layer decodes without
+// any remapping; PlayableMask marks the playable area inside it.
+//
+// BitGrid keeps one bit per cell in rows padded to 256 bits, so whole-grid
+// boolean operations run on full words (four at a time with
+// BLANKBOT_AVX2) and need no tail handling. ValueGrid keeps one 8, 16 or
+// 32-bit value per cell with rows exactly width cells apart, so y * width
+// + x indexes it directly.
+
+// Read-only view of an image layer; nothing is copied.
+class ImageView {
+public:
+    explicit ImageView(const sc2::ImageData& image);
+    ImageView(const void* data, size_t size, int width, int height, int bits_per_pixel);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int BitsPerPixel() const { return bits_per_pixel_; }
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+    // False outside the image or past the end of its data.
+    bool Get(int x, int y) const;
+
+    // Value of an 8-bit cell, or 0/1 for a 1-bit image.
+    uint8_t Value(int x, int y) const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    int width_;
+    int height_;
+    int bits_per_pixel_;
+};
+
+class BitGrid {
+public:
+    BitGrid() = default;
+    BitGrid(int width, int height) { Resize(width, height); }
+
+    // Resizes and clears every cell.
+    void Resize(int width, int height);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int Stride() const { return stride_; }      // 64-bit words per row
+    bool Empty() const { return width_ == 0; }
+    bool Contains(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
+
+    bool Get(int x, int y) const {
+        return (words_[static_cast<size_t>(y) * stride_ + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void Set(int x, int y, bool value) {
+        uint64_t& word = words_[static_cast<size_t>(y) * stride_ + (x >> 6)];
+        uint64_t bit = 1ull << (x & 63);
+        word = value ? word | bit : word & ~bit;
+    }
+
+    // Bits x..x+count-1 of row y, count <= 64, shifted down to bit 0.
+    uint64_t Span(int x, int y, int count) const;
+
+    const uint64_t* Row(int y) const { return &words_[static_cast<size_t>(y) * stride_]; }
+    uint64_t* Row(int y) { return &words_[static_cast<size_t>(y) * stride_]; }
+
+    void Clear();
+    void Fill();
+
+    // Sets or clears a rectangle, clipped to the grid.
+    void StampRect(int x0, int y0, int width, int height, bool value);
+
+    // Cell-wise operations with a grid of the same size.
+    BitGrid& And(const BitGrid& other);
+    BitGrid& Or(const BitGrid& other);
+    BitGrid& AndNot(const BitGrid& other);     // this & ~other
+    BitGrid& Not();
+
+    size_t Count() const;
+    size_t CountAnd(const BitGrid& other) const;
+
+    // Grows or shrinks the set cells by steps cells in all eight
+    // directions. Cells outside the grid count as unset.
+    void Dilate(int steps = 1);
+    void Erode(int steps = 1);
+
+    // Set cells reachable from (x, y) through set cells, 4-connected.
+    void FloodFill(int x, int y, BitGrid* out) const;
+
+    // Nonzero cells of an image.
+    static BitGrid FromImage(const ImageView& image);
+
+    // Cells of an 8-bit image equal to value, written into out (resized).
+    static void FromImageEqual(const ImageView& image, uint8_t value, BitGrid* out);
+
+private:
+    void ClearPadding();
+
+    int width_ = 0;
+    int height_ = 0;
+    int stride_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+template <typename T>
+class ValueGrid {
+public:
+    ValueGrid() = default;
+    ValueGrid(int width, int height, T value = T()) { Resize(width, height, value); }
+
+    void Resize(int width, int height, T value = T()) {
+        width_ = width;
+        height_ = height;
+        cells_.assign(static_cast<size_t>(width) * height, value);
+    }
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    bool Empty() const { return width_ == 0; }
+    bool Contains(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
+    size_t Index(int x, int y) const { return static_cast<size_t>(y) * width_ + x; }
+
+    T Get(int x, int y) const { return cells_[Index(x, y)]; }
+    void Set(int x, int y, T value) { cells_[Index(x, y)] = value; }
+    T& At(int x, int y) { return cells_[Index(x, y)]; }
+
+    const T& operator[](size_t index) const { return cells_[index]; }
+    T& operator[](size_t index) { return cells_[index]; }
+
+    size_t Size() const { return cells_.size(); }
+    const T* Data() const { return cells_.data(); }
+    T* Data() { return cells_.data(); }
+
+    void Fill(T value) { std::fill(cells_.begin(), cells_.end(), value); }
+
+    // Adds delta to a rectangle, clipped to the grid.
+    void AddRect(int x0, int y0, int width, int height, T delta) {
+        for (int y = std::max(y0, 0); y < std::min(y0 + height, height_); ++y) {
+            for (int x = std::max(x0, 0); x < std::min(x0 + width, width_); ++x)
+                cells_[Index(x, y)] += delta;
+        }
+    }
+
+    // Nonzero cells, written into out (resized).
+    void NonZero(BitGrid* out) const {
+        out->Resize(width_, height_);
+        for (int y = 0; y < height_; ++y) {
+            const T* row = &cells_[Index(0, y)];
+            uint64_t* bits = out->Row(y);
+            for (int x = 0; x < width_; ++x) {
+                if (row[x] != T())
+                    bits[x >> 6] |= 1ull << (x & 63);
+            }
+        }
+    }
+
+    // 8-bit image values, or 0/1 for a 1-bit image.
+    static ValueGrid FromImage(const ImageView& image) {
+        ValueGrid grid(image.Width(), image.Height());
+        for (int y = 0; y < image.Height(); ++y) {
+            for (int x = 0; x < image.Width(); ++x)
+                grid.cells_[grid.Index(x, y)] = static_cast<T>(image.Value(x, y));
+        }
+        return grid;
+    }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<T> cells_;
+};
+
+// Set cells of the playable rectangle.
+BitGrid PlayableMask(const sc2::GameInfo& game_info);
+
+// 4-connected regions of set cells, numbered from 0; unset cells get -1.
+// Returns the number of regions.
+int LabelComponents(const BitGrid& cells, ValueGrid<int32_t>* labels);
+
+#endif // MAP_GRID_H
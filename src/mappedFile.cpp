@@ -0,0 +1,150 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::OpenRead(const std::string& path) {
+    return Map(path, 0, false);
+}
+
+bool MappedFile::OpenWrite(const std::string& path, size_t min_size) {
+    return Map(path, min_size, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Map(const std::string& path, size_t min_size, bool writable) {
+    Close();
+
+    HANDLE file = CreateFileA(path.c_str(),
+        writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        FILE_SHARE_READ, nullptr,
+        writable ? OPEN_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(file_size.QuadPart);
+    if (writable && size < min_size)
+        size = min_size;
+    if (size == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    ULARGE_INTEGER mapping_size;
+    mapping_size.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+        mapping_size.HighPart, mapping_size.LowPart, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    data_ = data;
+    size_ = size;
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::Flush() {
+    if (data_ && writable_) {
+        FlushViewOfFile(data_, size_);
+        FlushFileBuffers(file_);
+    }
+}
+
+void MappedFile::Close() {
+    if (!data_)
+        return;
+
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+bool MappedFile::Map(const std::string& path, size_t min_size, bool writable) {
+    Close();
+
+    int fd = writable ? open(path.c_str(), O_RDWR | O_CREAT, 0644) : open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (writable && size < min_size) {
+        if (ftruncate(fd, static_cast<off_t>(min_size)) != 0) {
+            close(fd);
+            return false;
+        }
+        size = min_size;
+    }
+    if (size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    data_ = data;
+    size_ = size;
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::Flush() {
+    if (data_ && writable_)
+        msync(data_, size_, MS_SYNC);
+}
+
+void MappedFile::Close() {
+    if (!data_)
+        return;
+
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
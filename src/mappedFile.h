@@ -0,0 +1,49 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Memory-mapped view of a whole file.
+// Writable mappings create the file if needed and grow it to the requested
+// size; the contents are shared with the file, so there is nothing to parse
+// or serialize.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps an existing file read-only.
+    bool OpenRead(const std::string& path);
+
+    // Maps a file read-write, creating it or growing it to at least min_size.
+    bool OpenWrite(const std::string& path, size_t min_size);
+
+    // Writes dirty pages back to disk.
+    void Flush();
+
+    void Close();
+
+    bool IsOpen() const { return data_ != nullptr; }
+    uint8_t* Data() { return static_cast<uint8_t*>(data_); }
+    const uint8_t* Data() const { return static_cast<const uint8_t*>(data_); }
+    size_t Size() const { return size_; }
+
+private:
+    bool Map(const std::string& path, size_t min_size, bool writable);
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,158 @@
+#include "opponentHistory.h"
+
+#include <cstring>
+
+namespace {
+
+// Laplace-smoothed win rate, so untried strategies start at 50%.
+float WinRate(uint16_t wins, uint16_t plays) {
+    return (wins + 1.0f) / (plays + 2.0f);
+}
+
+}  // namespace
+
+bool OpponentHistory::Open(const std::string& path) {
+    Close();
+
+    size_t size = sizeof(Header) + CAPACITY * sizeof(OpponentRecord);
+    if (!file_.OpenWrite(path, size))
+        return false;
+
+    header_ = reinterpret_cast<Header*>(file_.Data());
+    if (header_->magic != MAGIC || header_->version != VERSION || header_->capacity != CAPACITY) {
+        // New or incompatible file, start from scratch
+        std::memset(file_.Data(), 0, file_.Size());
+        header_->magic = MAGIC;
+        header_->version = VERSION;
+        header_->capacity = CAPACITY;
+        header_->count = 0;
+        file_.Flush();
+    }
+
+    return true;
+}
+
+void OpponentHistory::Close() {
+    file_.Close();
+    header_ = nullptr;
+}
+
+const OpponentRecord* OpponentHistory::Records() const {
+    return reinterpret_cast<const OpponentRecord*>(file_.Data() + sizeof(Header));
+}
+
+OpponentRecord* OpponentHistory::Records() {
+    return reinterpret_cast<OpponentRecord*>(file_.Data() + sizeof(Header));
+}
+
+uint32_t OpponentHistory::Hash(const std::string& opponent_id) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (char c : opponent_id) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash % CAPACITY;
+}
+
+const OpponentRecord* OpponentHistory::Find(const std::string& opponent_id) const {
+    if (!header_ || opponent_id.empty() || opponent_id.size() >= OpponentRecord::ID_LENGTH)
+        return nullptr;
+
+    const OpponentRecord* records = Records();
+    uint32_t slot = Hash(opponent_id);
+    for (uint32_t probe = 0; probe < CAPACITY; ++probe) {
+        const OpponentRecord& record = records[(slot + probe) % CAPACITY];
+        if (record.opponent_id[0] == '\0')
+            return nullptr;
+        if (opponent_id == record.opponent_id)
+            return &record;
+    }
+
+    return nullptr;
+}
+
+OpponentRecord* OpponentHistory::Insert(const std::string& opponent_id) {
+    if (!header_ || opponent_id.empty() || opponent_id.size() >= OpponentRecord::ID_LENGTH)
+        return nullptr;
+
+    OpponentRecord* records = Records();
+    uint32_t slot = Hash(opponent_id);
+    for (uint32_t probe = 0; probe < CAPACITY; ++probe) {
+        OpponentRecord& record = records[(slot + probe) % CAPACITY];
+        if (record.opponent_id[0] == '\0') {
+            std::memcpy(record.opponent_id, opponent_id.c_str(), opponent_id.size() + 1);
+            ++header_->count;
+            return &record;
+        }
+        if (opponent_id == record.opponent_id)
+            return &record;
+    }
+
+    return nullptr;
+}
+
+OpeningStrategy OpponentHistory::ChooseStrategy(const std::string& opponent_id) const {
+    const OpponentRecord* record = Find(opponent_id);
+    if (!record || record->games == 0)
+        return OpeningStrategy::STANDARD;
+
+    uint32_t recent = record->games < OpponentRecord::RECENT_GAMES ? record->games : OpponentRecord::RECENT_GAMES;
+    uint32_t rushes = 0;
+    uint32_t macro = 0;
+    for (uint32_t i = 0; i < recent; ++i) {
+        if (record->recent[i].enemy_build == EnemyBuild::RUSH ||
+            record->recent[i].enemy_build == EnemyBuild::EARLY_AGGRESSION)
+            ++rushes;
+        else if (record->recent[i].enemy_build == EnemyBuild::MACRO)
+            ++macro;
+    }
+
+    // Prefer what has won before, nudged by what the opponent tends to do
+    OpeningStrategy best = OpeningStrategy::STANDARD;
+    float best_score = -1.0f;
+    for (int i = 0; i < static_cast<int>(OpeningStrategy::COUNT); ++i) {
+        OpeningStrategy strategy = static_cast<OpeningStrategy>(i);
+        float score = WinRate(record->wins[i], record->plays[i]);
+        if (strategy == OpeningStrategy::DEFENSIVE && rushes * 2 > recent)
+            score += 0.25f;
+        if (strategy == OpeningStrategy::AGGRESSIVE && macro * 2 > recent)
+            score += 0.1f;
+
+        if (score > best_score) {
+            best_score = score;
+            best = strategy;
+        }
+    }
+
+    return best;
+}
+
+void OpponentHistory::Record(const std::string& opponent_id, const OpponentGame& game) {
+    OpponentRecord* record = Insert(opponent_id);
+    if (!record)
+        return;
+
+    record->recent[record->next] = game;
+    record->next = (record->next + 1) % OpponentRecord::RECENT_GAMES;
+    ++record->games;
+
+    int strategy = static_cast<int>(game.strategy);
+    if (strategy < static_cast<int>(OpeningStrategy::COUNT)) {
+        ++record->plays[strategy];
+        if (game.result == HistoryResult::WIN)
+            ++record->wins[strategy];
+    }
+
+    file_.Flush();
+}
+
+EnemyBuild OpponentHistory::ClassifyBuild(uint32_t first_attack_loop) {
+    if (first_attack_loop == 0)
+        return EnemyBuild::MACRO;
+    if (first_attack_loop < RUSH_LOOPS)
+        return EnemyBuild::RUSH;
+    if (first_attack_loop < AGGRESSION_LOOPS)
+        return EnemyBuild::EARLY_AGGRESSION;
+    return EnemyBuild::MACRO;
+}
@@ -0,0 +1,106 @@
+#ifndef OPPONENT_HISTORY_H
+#define OPPONENT_HISTORY_H
+
+#include "mappedFile.h"
+
+#include <cstdint>
+#include <string>
+
+// Opening plans the bot can commit to at game start.
+enum class OpeningStrategy : uint8_t {
+    STANDARD,
+    DEFENSIVE,      // more army before expanding, late attack
+    AGGRESSIVE,     // small early army, early attack
+    COUNT
+};
+
+// What we observed the opponent doing in a game.
+enum class EnemyBuild : uint8_t {
+    UNKNOWN,
+    RUSH,               // army at our base before RUSH_LOOPS
+    EARLY_AGGRESSION,   // army at our base before AGGRESSION_LOOPS
+    MACRO               // no early pressure
+};
+
+// Outcome of a finished game, mirrors sc2::GameResult.
+enum class HistoryResult : uint8_t {
+    WIN,
+    LOSS,
+    TIE,
+    UNDECIDED
+};
+
+// One finished game against an opponent. Fixed 16 bytes.
+struct OpponentGame {
+    uint32_t first_army_loop;   // first enemy army unit seen, 0 if never
+    uint32_t first_attack_loop; // first enemy army near our base, 0 if never
+    uint32_t game_loops;        // length of the game
+    EnemyBuild enemy_build;
+    uint8_t enemy_race;         // sc2::Race
+    OpeningStrategy strategy;
+    HistoryResult result;
+};
+
+// Per-opponent slot in the database file.
+struct OpponentRecord {
+    static constexpr uint32_t ID_LENGTH = 48;
+    static constexpr uint32_t RECENT_GAMES = 16;
+
+    char opponent_id[ID_LENGTH];    // NUL padded, empty slot if first byte is 0
+    uint32_t games;
+    uint32_t next;                  // ring position in recent
+    uint16_t wins[static_cast<int>(OpeningStrategy::COUNT)];
+    uint16_t plays[static_cast<int>(OpeningStrategy::COUNT)];
+    OpponentGame recent[RECENT_GAMES];
+};
+
+// Persistent per-opponent history stored in a memory-mapped file.
+// Records live in a fixed open-addressing table, so a lookup is a hash and a
+// few string compares on mapped memory with nothing to parse.
+class OpponentHistory {
+public:
+    // Enemy army reaching our base before these loops counts as a rush
+    // (4 minutes) or early aggression (6 minutes) respectively.
+    static constexpr uint32_t RUSH_LOOPS = 5376;
+    static constexpr uint32_t AGGRESSION_LOOPS = 8064;
+
+    // Maps the database, creating it in the data directory if missing.
+    bool Open(const std::string& path);
+
+    void Close();
+
+    // Record of an opponent, nullptr if they have never been played.
+    const OpponentRecord* Find(const std::string& opponent_id) const;
+
+    // Picks the opening for the next game against this opponent.
+    OpeningStrategy ChooseStrategy(const std::string& opponent_id) const;
+
+    // Appends a finished game and flushes the file.
+    void Record(const std::string& opponent_id, const OpponentGame& game);
+
+    static EnemyBuild ClassifyBuild(uint32_t first_attack_loop);
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t count;
+    };
+
+    static constexpr uint32_t MAGIC = 0x48505042;   // "BPPH"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t CAPACITY = 512;
+
+    const OpponentRecord* Records() const;
+    OpponentRecord* Records();
+    OpponentRecord* Insert(const std::string& opponent_id);
+
+    // Probe start for an opponent id in the open-addressing table.
+    static uint32_t Hash(const std::string& opponent_id);
+
+    MappedFile file_;
+    Header* header_ = nullptr;
+};
+
+#endif // OPPONENT_HISTORY_H
@@ -0,0 +1,586 @@
+#include "pathfinder.h"
+
+#include "powerGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+using namespace sc2;
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+const float DIAGONAL = 1.41421356f;
+
+// How far off a blocked point we look for a walkable cell.
+const int SNAP_RADIUS = 4;
+
+const int DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+const int DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+using OpenEntry = std::pair<float, int>;
+using OpenList = std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>>;
+
+bool IsMineralField(UNIT_TYPEID type) {
+    switch (type) {
+        case UNIT_TYPEID::NEUTRAL_MINERALFIELD:
+        case UNIT_TYPEID::NEUTRAL_MINERALFIELD750:
+        case UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD:
+        case UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsGeyser(UNIT_TYPEID type) {
+    switch (type) {
+        case UNIT_TYPEID::NEUTRAL_VESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_RICHVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_PURIFIERVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_SHAKURASVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_SPACEPLATFORMGEYSER:
+        case UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+void Pathfinder::Initialize(const GameInfo& game_info, const Units& neutral_units) {
+    width_ = game_info.width;
+    height_ = game_info.height;
+    clusters_x_ = (width_ + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    clusters_y_ = (height_ + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    size_t cells = static_cast<size_t>(width_) * height_;
+    static_ = BitGrid::FromImage(ImageView(game_info.pathing_grid));
+    blocked_.Resize(width_, height_, 0);
+    walkable_ = static_;
+
+    cost_.assign(cells, 0.0f);
+    parent_.assign(cells, -1);
+    seen_.assign(cells, 0);
+    generation_ = 0;
+
+    clusters_.assign(static_cast<size_t>(clusters_x_) * clusters_y_, Cluster());
+    cache_.clear();
+    cache_index_.clear();
+    unreachable_ = {0, false, -1.0f, {}, {}};
+    stats_ = {};
+
+    for (const auto& unit : neutral_units)
+        Stamp(unit, true);
+    stale_ = true;
+}
+
+void Pathfinder::Prepare() {
+    if (IsInitialized() && stale_)
+        RebuildAbstraction();
+}
+
+int Pathfinder::ClusterOf(int cell) const {
+    int x = cell % width_;
+    int y = cell / width_;
+    return (y / CLUSTER_SIZE) * clusters_x_ + x / CLUSTER_SIZE;
+}
+
+Pathfinder::Rect Pathfinder::ClusterRect(int cluster) const {
+    int x0 = (cluster % clusters_x_) * CLUSTER_SIZE;
+    int y0 = (cluster / clusters_x_) * CLUSTER_SIZE;
+    return {x0, y0, std::min(x0 + CLUSTER_SIZE, width_) - 1, std::min(y0 + CLUSTER_SIZE, height_) - 1};
+}
+
+int Pathfinder::NearestWalkable(const Point2D& pos) const {
+    int cx = static_cast<int>(std::floor(pos.x));
+    int cy = static_cast<int>(std::floor(pos.y));
+
+    for (int ring = 0; ring <= SNAP_RADIUS; ++ring) {
+        for (int dy = -ring; dy <= ring; ++dy) {
+            int step = (dy == -ring || dy == ring) ? 1 : 2 * ring;
+            for (int dx = -ring; dx <= ring; dx += std::max(step, 1)) {
+                if (Walkable(cx + dx, cy + dy))
+                    return (cy + dy) * width_ + cx + dx;
+            }
+        }
+    }
+    return -1;
+}
+
+bool Pathfinder::IsPathable(const Point2D& pos) const {
+    return Walkable(static_cast<int>(std::floor(pos.x)), static_cast<int>(std::floor(pos.y)));
+}
+
+void Pathfinder::Footprint(const Unit* unit, int* x0, int* y0, int* w, int* h) const {
+    if (IsMineralField(unit->unit_type)) {
+        *x0 = static_cast<int>(std::floor(unit->pos.x)) - 1;
+        *y0 = static_cast<int>(std::floor(unit->pos.y));
+        *w = 2;
+        *h = 1;
+        return;
+    }
+
+    int size = IsGeyser(unit->unit_type) ? 3 : PowerGrid::FootprintSize(unit->unit_type);
+    *x0 = static_cast<int>(std::floor(unit->pos.x - size / 2.0f + 0.5f));
+    *y0 = static_cast<int>(std::floor(unit->pos.y - size / 2.0f + 0.5f));
+    *w = size;
+    *h = size;
+}
+
+void Pathfinder::Stamp(const Unit* unit, bool blocked) {
+    int x0;
+    int y0;
+    int w;
+    int h;
+    Footprint(unit, &x0, &y0, &w, &h);
+
+    std::vector<int> changed;
+    for (int y = std::max(y0, 0); y < std::min(y0 + h, height_); ++y) {
+        for (int x = std::max(x0, 0); x < std::min(x0 + w, width_); ++x) {
+            uint8_t& count = blocked_.At(x, y);
+            count = static_cast<uint8_t>(std::max(0, count + (blocked ? 1 : -1)));
+
+            bool walkable = static_.Get(x, y) && count == 0;
+            if (walkable == walkable_.Get(x, y))
+                continue;
+            walkable_.Set(x, y, walkable);
+
+            int cluster = ClusterOf(y * width_ + x);
+            clusters_[cluster].dirty = true;
+            changed.push_back(cluster);
+        }
+    }
+    if (changed.empty())
+        return;
+
+    stale_ = true;
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    // A new obstacle only breaks routes through it; an opening can shorten
+    // any route, so drop them all
+    if (blocked)
+        Evict(changed);
+    else {
+        cache_.clear();
+        cache_index_.clear();
+    }
+}
+
+void Pathfinder::OnStructureCreated(const Unit* unit) {
+    if (!IsInitialized() || PowerGrid::FootprintSize(unit->unit_type) == 0)
+        return;
+    Stamp(unit, true);
+}
+
+void Pathfinder::OnStructureDestroyed(const Unit* unit) {
+    if (!IsInitialized())
+        return;
+    if (PowerGrid::FootprintSize(unit->unit_type) == 0 && !IsMineralField(unit->unit_type))
+        return;
+    Stamp(unit, false);
+}
+
+void Pathfinder::AddEntrance(int a_start, int b_start, int step, int length, std::vector<std::vector<int>>* cells) {
+    int offsets[2] = {length / 2, length / 2};
+    if (length >= WIDE_ENTRANCE) {
+        offsets[0] = 0;
+        offsets[1] = length - 1;
+    }
+
+    for (int i = 0; i < (length >= WIDE_ENTRANCE ? 2 : 1); ++i) {
+        int a = a_start + offsets[i] * step;
+        int b = b_start + offsets[i] * step;
+        (*cells)[ClusterOf(a)].push_back(a);
+        (*cells)[ClusterOf(b)].push_back(b);
+        transitions_.push_back({a, b});
+    }
+}
+
+void Pathfinder::RebuildAbstraction() {
+    ++stats_.rebuilds;
+    // Diagonal steps need both orthogonal neighbors, so 4-connectivity
+    // gives the same regions
+    LabelComponents(walkable_, &component_);
+    transitions_.clear();
+    std::vector<std::vector<int>> cells(clusters_.size());
+
+    // Entrances: maximal walkable runs on both sides of each border
+    for (int c = 0; c < static_cast<int>(clusters_.size()); ++c) {
+        Rect r = ClusterRect(c);
+
+        if (r.x1 + 1 < width_) {
+            int run = 0;
+            for (int y = r.y0; y <= r.y1 + 1; ++y) {
+                if (y <= r.y1 && Walkable(r.x1, y) && Walkable(r.x1 + 1, y)) {
+                    ++run;
+                    continue;
+                }
+                if (run > 0)
+                    AddEntrance((y - run) * width_ + r.x1, (y - run) * width_ + r.x1 + 1, width_, run, &cells);
+                run = 0;
+            }
+        }
+
+        if (r.y1 + 1 < height_) {
+            int run = 0;
+            for (int x = r.x0; x <= r.x1 + 1; ++x) {
+                if (x <= r.x1 && Walkable(x, r.y1) && Walkable(x, r.y1 + 1)) {
+                    ++run;
+                    continue;
+                }
+                if (run > 0)
+                    AddEntrance(r.y1 * width_ + x - run, (r.y1 + 1) * width_ + x - run, 1, run, &cells);
+                run = 0;
+            }
+        }
+    }
+
+    // Intra-cluster costs, only where the cluster or its entrances changed
+    for (size_t c = 0; c < clusters_.size(); ++c) {
+        std::vector<int>& entrances = cells[c];
+        std::sort(entrances.begin(), entrances.end());
+        entrances.erase(std::unique(entrances.begin(), entrances.end()), entrances.end());
+
+        Cluster& cluster = clusters_[c];
+        if (!cluster.dirty && cluster.cells == entrances)
+            continue;
+
+        cluster.cells = std::move(entrances);
+        size_t n = cluster.cells.size();
+        cluster.costs.assign(n * n, INF);
+        for (size_t i = 0; i < n; ++i)
+            CostsFrom(cluster.cells[i], ClusterRect(static_cast<int>(c)), cluster.cells, &cluster.costs[i * n]);
+        cluster.dirty = false;
+    }
+
+    node_cell_.clear();
+    node_of_cell_.clear();
+    for (const auto& cluster : clusters_) {
+        for (int cell : cluster.cells) {
+            node_of_cell_[cell] = static_cast<int>(node_cell_.size());
+            node_cell_.push_back(cell);
+        }
+    }
+
+    edges_.assign(node_cell_.size(), {});
+    for (const auto& cluster : clusters_) {
+        size_t n = cluster.cells.size();
+        for (size_t i = 0; i < n; ++i) {
+            int from = node_of_cell_[cluster.cells[i]];
+            for (size_t j = 0; j < n; ++j) {
+                float cost = cluster.costs[i * n + j];
+                if (i != j && cost < INF)
+                    edges_[from].push_back({node_of_cell_[cluster.cells[j]], cost});
+            }
+        }
+    }
+    for (const auto& transition : transitions_) {
+        int a = node_of_cell_[transition.first];
+        int b = node_of_cell_[transition.second];
+        edges_[a].push_back({b, 1.0f});
+        edges_[b].push_back({a, 1.0f});
+    }
+
+    stale_ = false;
+}
+
+float Pathfinder::SearchLocal(int start, int goal, const Rect& bounds, std::vector<int>* path) {
+    int gx = goal % width_;
+    int gy = goal / width_;
+    auto heuristic = [this, gx, gy](int cell) {
+        float dx = static_cast<float>(std::abs(cell % width_ - gx));
+        float dy = static_cast<float>(std::abs(cell / width_ - gy));
+        return dx + dy + (DIAGONAL - 2.0f) * std::min(dx, dy);
+    };
+
+    ++generation_;
+    cost_[start] = 0.0f;
+    parent_[start] = -1;
+    seen_[start] = generation_;
+
+    OpenList open;
+    open.push({heuristic(start), start});
+    while (!open.empty()) {
+        OpenEntry top = open.top();
+        open.pop();
+        int cell = top.second;
+        if (top.first > cost_[cell] + heuristic(cell) + 1e-4f)
+            continue;
+
+        if (cell == goal) {
+            if (path) {
+                path->clear();
+                for (int at = goal; at >= 0; at = parent_[at])
+                    path->push_back(at);
+                std::reverse(path->begin(), path->end());
+            }
+            return cost_[goal];
+        }
+
+        int x = cell % width_;
+        int y = cell / width_;
+        for (int d = 0; d < 8; ++d) {
+            int nx = x + DX[d];
+            int ny = y + DY[d];
+            if (nx < bounds.x0 || ny < bounds.y0 || nx > bounds.x1 || ny > bounds.y1 || !Walkable(nx, ny))
+                continue;
+            // No cutting corners past a blocked cell
+            if (d >= 4 && (!Walkable(nx, y) || !Walkable(x, ny)))
+                continue;
+
+            int next = ny * width_ + nx;
+            float cost = cost_[cell] + (d >= 4 ? DIAGONAL : 1.0f);
+            if (seen_[next] == generation_ && cost >= cost_[next])
+                continue;
+
+            seen_[next] = generation_;
+            cost_[next] = cost;
+            parent_[next] = cell;
+            open.push({cost + heuristic(next), next});
+        }
+    }
+    return -1.0f;
+}
+
+void Pathfinder::CostsFrom(int start, const Rect& bounds, const std::vector<int>& targets, float* out) {
+    ++generation_;
+    cost_[start] = 0.0f;
+    seen_[start] = generation_;
+
+    OpenList open;
+    open.push({0.0f, start});
+    while (!open.empty()) {
+        OpenEntry top = open.top();
+        open.pop();
+        int cell = top.second;
+        if (top.first > cost_[cell])
+            continue;
+
+        int x = cell % width_;
+        int y = cell / width_;
+        for (int d = 0; d < 8; ++d) {
+            int nx = x + DX[d];
+            int ny = y + DY[d];
+            if (nx < bounds.x0 || ny < bounds.y0 || nx > bounds.x1 || ny > bounds.y1 || !Walkable(nx, ny))
+                continue;
+            if (d >= 4 && (!Walkable(nx, y) || !Walkable(x, ny)))
+                continue;
+
+            int next = ny * width_ + nx;
+            float cost = cost_[cell] + (d >= 4 ? DIAGONAL : 1.0f);
+            if (seen_[next] == generation_ && cost >= cost_[next])
+                continue;
+
+            seen_[next] = generation_;
+            cost_[next] = cost;
+            open.push({cost, next});
+        }
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i)
+        out[i] = seen_[targets[i]] == generation_ ? cost_[targets[i]] : INF;
+}
+
+bool Pathfinder::Search(int start, int goal, std::vector<int>* cells, float* length) {
+    if (stale_)
+        RebuildAbstraction();
+
+    // Different regions: no need to search at all
+    if (component_[start] != component_[goal])
+        return false;
+
+    int start_cluster = ClusterOf(start);
+    int goal_cluster = ClusterOf(goal);
+
+    // Nearby: one search over both clusters is cheaper than the graph
+    Rect near = ClusterRect(start_cluster);
+    Rect goal_rect = ClusterRect(goal_cluster);
+    if (std::abs(near.x0 - goal_rect.x0) <= CLUSTER_SIZE && std::abs(near.y0 - goal_rect.y0) <= CLUSTER_SIZE) {
+        near = {std::min(near.x0, goal_rect.x0), std::min(near.y0, goal_rect.y0),
+            std::max(near.x1, goal_rect.x1), std::max(near.y1, goal_rect.y1)};
+        *length = SearchLocal(start, goal, near, cells);
+        if (*length >= 0.0f)
+            return true;
+    }
+
+    // Hook the start and goal into the graph through their clusters' entrances
+    const std::vector<int>& start_cells = clusters_[start_cluster].cells;
+    const std::vector<int>& goal_cells = clusters_[goal_cluster].cells;
+    std::vector<float> start_costs(start_cells.size());
+    std::vector<float> goal_costs(goal_cells.size());
+    CostsFrom(start, ClusterRect(start_cluster), start_cells, start_costs.data());
+    CostsFrom(goal, goal_rect, goal_cells, goal_costs.data());
+
+    int nodes = static_cast<int>(node_cell_.size());
+    int start_node = nodes;
+    int goal_node = nodes + 1;
+    node_cost_.assign(nodes + 2, INF);
+    node_parent_.assign(nodes + 2, -1);
+    node_goal_cost_.assign(nodes, INF);
+    for (size_t i = 0; i < goal_cells.size(); ++i)
+        node_goal_cost_[node_of_cell_[goal_cells[i]]] = goal_costs[i];
+
+    int gx = goal % width_;
+    int gy = goal / width_;
+    auto heuristic = [this, gx, gy, nodes, start](int node) {
+        if (node == nodes + 1)
+            return 0.0f;
+        int cell = node == nodes ? start : node_cell_[node];
+        float dx = static_cast<float>(std::abs(cell % width_ - gx));
+        float dy = static_cast<float>(std::abs(cell / width_ - gy));
+        return dx + dy + (DIAGONAL - 2.0f) * std::min(dx, dy);
+    };
+
+    OpenList open;
+    node_cost_[start_node] = 0.0f;
+    open.push({heuristic(start_node), start_node});
+    auto relax = [&](int from, int to, float cost) {
+        float total = node_cost_[from] + cost;
+        if (total < node_cost_[to]) {
+            node_cost_[to] = total;
+            node_parent_[to] = from;
+            open.push({total + heuristic(to), to});
+        }
+    };
+
+    while (!open.empty()) {
+        OpenEntry top = open.top();
+        open.pop();
+        int node = top.second;
+        if (node == goal_node)
+            break;
+        if (top.first > node_cost_[node] + heuristic(node) + 1e-4f)
+            continue;
+
+        if (node == start_node) {
+            for (size_t i = 0; i < start_cells.size(); ++i) {
+                if (start_costs[i] < INF)
+                    relax(node, node_of_cell_[start_cells[i]], start_costs[i]);
+            }
+            continue;
+        }
+
+        for (const auto& edge : edges_[node])
+            relax(node, edge.to, edge.cost);
+        if (node_goal_cost_[node] < INF)
+            relax(node, goal_node, node_goal_cost_[node]);
+    }
+
+    if (node_cost_[goal_node] == INF)
+        return false;
+
+    std::vector<int> route;
+    for (int node = goal_node; node >= 0; node = node_parent_[node])
+        route.push_back(node == goal_node ? goal : node == start_node ? start : node_cell_[node]);
+    std::reverse(route.begin(), route.end());
+
+    // Refine each hop; hops across a border are a single step
+    cells->assign(1, start);
+    std::vector<int> segment;
+    for (size_t i = 1; i < route.size(); ++i) {
+        int from = route[i - 1];
+        int to = route[i];
+        if (from == to)
+            continue;
+        if (ClusterOf(from) != ClusterOf(to)) {
+            cells->push_back(to);
+            continue;
+        }
+        if (SearchLocal(from, to, ClusterRect(ClusterOf(from)), &segment) < 0.0f)
+            return false;
+        cells->insert(cells->end(), segment.begin() + 1, segment.end());
+    }
+
+    *length = node_cost_[goal_node];
+    return true;
+}
+
+const Pathfinder::CachedPath& Pathfinder::Lookup(const Point2D& from, const Point2D& to) {
+    ++stats_.queries;
+    int start = NearestWalkable(from);
+    int goal = NearestWalkable(to);
+    if (start < 0 || goal < 0)
+        return unreachable_;
+
+    uint64_t key = (static_cast<uint64_t>(start) << 32) | static_cast<uint32_t>(goal);
+    auto found = cache_index_.find(key);
+    if (found != cache_index_.end()) {
+        ++stats_.cache_hits;
+        cache_.splice(cache_.begin(), cache_, found->second);
+        return cache_.front();
+    }
+
+    CachedPath entry = {key, false, -1.0f, {}, {}};
+    std::vector<int> cells;
+    float length = 0.0f;
+    if (Search(start, goal, &cells, &length)) {
+        entry.reachable = true;
+        entry.length = length;
+
+        // Keep only the cells where the direction changes
+        for (size_t i = 1; i < cells.size(); ++i) {
+            bool last = i + 1 == cells.size();
+            if (!last && cells[i] - cells[i - 1] == cells[i + 1] - cells[i])
+                continue;
+            entry.waypoints.push_back(Point2D(cells[i] % width_ + 0.5f, cells[i] / width_ + 0.5f));
+        }
+
+        for (int cell : cells)
+            entry.clusters.push_back(ClusterOf(cell));
+        std::sort(entry.clusters.begin(), entry.clusters.end());
+        entry.clusters.erase(std::unique(entry.clusters.begin(), entry.clusters.end()), entry.clusters.end());
+    }
+
+    cache_.push_front(std::move(entry));
+    cache_index_[key] = cache_.begin();
+    if (cache_.size() > CACHE_CAPACITY) {
+        cache_index_.erase(cache_.back().key);
+        cache_.pop_back();
+    }
+    return cache_.front();
+}
+
+void Pathfinder::Evict(const std::vector<int>& clusters) {
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        bool touched = false;
+        for (int cluster : clusters) {
+            if (std::binary_search(it->clusters.begin(), it->clusters.end(), cluster)) {
+                touched = true;
+                break;
+            }
+        }
+
+        if (touched) {
+            cache_index_.erase(it->key);
+            it = cache_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool Pathfinder::FindPath(const Point2D& from, const Point2D& to, std::vector<Point2D>* out) {
+    if (!IsInitialized())
+        return false;
+
+    const CachedPath& path = Lookup(from, to);
+    if (!path.reachable)
+        return false;
+    *out = path.waypoints;
+    return true;
+}
+
+float Pathfinder::PathLength(const Point2D& from, const Point2D& to) {
+    if (!IsInitialized())
+        return -1.0f;
+
+    const CachedPath& path = Lookup(from, to);
+    return path.reachable ? path.length : -1.0f;
+}
@@ -0,0 +1,143 @@
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include "mapGrid.h"
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Ground routes between arbitrary points, computed locally from the pathing
+// grid so a query never waits on the game.
+//
+// The map is cut into square clusters. Walkable runs along each cluster
+// border become entrances, and the cost between every pair of entrances of
+// a cluster is precomputed. A route is searched on that small graph and
+// then refined cell by cell inside one cluster at a time. Structures change
+// pathing only in the clusters they touch, so only those are recomputed,
+// lazily on the next query. Points in different connected regions are
+// rejected without searching.
+//
+// Recent routes are kept in an LRU cache keyed by start and goal cell.
+class Pathfinder {
+public:
+    struct Stats {
+        uint64_t queries = 0;
+        uint64_t cache_hits = 0;
+        uint64_t rebuilds = 0;
+    };
+
+    // Decodes the pathing grid and blocks the resources already on the map.
+    void Initialize(const sc2::GameInfo& game_info, const sc2::Units& neutral_units);
+
+    // A structure was placed: its footprint is no longer walkable.
+    void OnStructureCreated(const sc2::Unit* unit);
+
+    // A structure died or a resource ran out: its footprint opens up.
+    void OnStructureDestroyed(const sc2::Unit* unit);
+
+    // Waypoints from one point to another, excluding the start and ending
+    // at the goal cell. False if there is no ground route.
+    bool FindPath(const sc2::Point2D& from, const sc2::Point2D& to, std::vector<sc2::Point2D>* out);
+
+    // Ground distance between two points, negative if unreachable.
+    float PathLength(const sc2::Point2D& from, const sc2::Point2D& to);
+
+    // Builds the abstract graph now rather than on the next query.
+    void Prepare();
+
+    bool IsPathable(const sc2::Point2D& pos) const;
+    bool IsInitialized() const { return width_ > 0; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr int CLUSTER_SIZE = 16;
+
+    // Entrances at least this long get one transition per end.
+    static constexpr int WIDE_ENTRANCE = 6;
+
+    static constexpr size_t CACHE_CAPACITY = 512;
+
+    struct Rect {
+        int x0, y0, x1, y1;     // inclusive
+    };
+
+    struct Cluster {
+        std::vector<int> cells;     // entrance cells, sorted
+        std::vector<float> costs;   // cells x cells, infinite if not connected inside
+        bool dirty = true;
+    };
+
+    struct Edge {
+        int to;
+        float cost;
+    };
+
+    struct CachedPath {
+        uint64_t key;
+        bool reachable;
+        float length;
+        std::vector<sc2::Point2D> waypoints;
+        std::vector<int> clusters;  // sorted, for invalidation
+    };
+
+    bool Walkable(int x, int y) const {
+        return walkable_.Contains(x, y) && walkable_.Get(x, y);
+    }
+    int ClusterOf(int cell) const;
+    Rect ClusterRect(int cluster) const;
+    int NearestWalkable(const sc2::Point2D& pos) const;
+
+    void Footprint(const sc2::Unit* unit, int* x0, int* y0, int* w, int* h) const;
+    void Stamp(const sc2::Unit* unit, bool blocked);
+
+    void RebuildAbstraction();
+    void AddEntrance(int a_start, int b_start, int step, int length, std::vector<std::vector<int>>* cells);
+
+    // Cell-level search inside bounds; costs are octile, no corner cutting.
+    float SearchLocal(int start, int goal, const Rect& bounds, std::vector<int>* path);
+    void CostsFrom(int start, const Rect& bounds, const std::vector<int>& targets, float* out);
+
+    bool Search(int start, int goal, std::vector<int>* cells, float* length);
+    const CachedPath& Lookup(const sc2::Point2D& from, const sc2::Point2D& to);
+    void Evict(const std::vector<int>& clusters);
+
+    int width_ = 0;
+    int height_ = 0;
+    int clusters_x_ = 0;
+    int clusters_y_ = 0;
+
+    BitGrid static_;                    // from the pathing grid
+    ValueGrid<uint8_t> blocked_;        // structures and resources covering the cell
+    BitGrid walkable_;                  // static & ~blocked
+    ValueGrid<int32_t> component_;      // connected region per cell, -1 if blocked
+
+    std::vector<Cluster> clusters_;
+    std::vector<std::pair<int, int>> transitions_;
+    bool stale_ = true;
+
+    // Abstract graph over all entrance cells
+    std::vector<int> node_cell_;
+    std::unordered_map<int, int> node_of_cell_;
+    std::vector<std::vector<Edge>> edges_;
+
+    // Search scratch, stamped by generation instead of cleared
+    std::vector<float> cost_;
+    std::vector<int> parent_;
+    std::vector<uint32_t> seen_;
+    uint32_t generation_ = 0;
+    std::vector<float> node_cost_;
+    std::vector<int> node_parent_;
+    std::vector<float> node_goal_cost_;
+
+    std::list<CachedPath> cache_;
+    std::unordered_map<uint64_t, std::list<CachedPath>::iterator> cache_index_;
+    CachedPath unreachable_;
+
+    Stats stats_;
+};
+
+#endif // PATHFINDER_H
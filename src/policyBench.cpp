@@ -0,0 +1,98 @@
+// Benchmark for the embedded policy network.
+//
+// Evaluates a network at several batch sizes and prints latency
+// percentiles. Without a path a random MLP and a random conv1d network are
+// generated next to the binary.
+//
+// Usage: BlankBotPolicyBench [policy-file] [iterations]
+
+#include "policyNet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+PolicyNet::NetLayer Dense(uint32_t in, uint32_t out, PolicyNet::Activation activation) {
+    return {PolicyNet::LayerType::DENSE, activation, in, out, 1, 1, 0, 0};
+}
+
+PolicyNet::NetLayer Conv1d(uint32_t in, uint32_t out, uint32_t length, uint32_t kernel) {
+    return {PolicyNet::LayerType::CONV1D, PolicyNet::Activation::RELU, in, out, length, kernel, 0, 0};
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(fraction * (values.size() - 1))];
+}
+
+void Run(const std::string& path, int iterations) {
+    PolicyNet net;
+    if (!net.Load(path)) {
+        std::cerr << "Cannot load " << path << std::endl;
+        return;
+    }
+    net.SetBudget(std::chrono::seconds(1));
+
+    std::cout << path << ": " << net.InputSize() << " -> " << net.OutputSize() << std::endl;
+    std::cout << std::setw(8) << "batch" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+        << std::setw(14) << "rows/ms" << std::endl;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> feature(-1.0f, 1.0f);
+
+    for (size_t batch : {1, 8, 32, 128, 512}) {
+        std::vector<float> inputs(batch * net.InputSize());
+        std::vector<float> outputs(batch * net.OutputSize());
+        for (auto& value : inputs)
+            value = feature(rng);
+
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            net.Evaluate(inputs.data(), batch, outputs.data());
+            samples.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+
+        double p50 = Percentile(samples, 0.50);
+        std::cout << std::setw(8) << batch << std::fixed << std::setprecision(2)
+            << std::setw(12) << p50 << std::setw(12) << Percentile(samples, 0.99)
+            << std::setprecision(0) << std::setw(14) << (p50 > 0.0 ? batch * 1000.0 / p50 : 0.0) << std::endl;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (iterations <= 0)
+        iterations = 2000;
+
+    if (argc > 1) {
+        Run(argv[1], iterations);
+        return 0;
+    }
+
+    PolicyNet::WriteRandom("bench_mlp.bin", {
+        Dense(64, 128, PolicyNet::Activation::RELU),
+        Dense(128, 128, PolicyNet::Activation::RELU),
+        Dense(128, 8, PolicyNet::Activation::NONE)}, 64, 1);
+    Run("bench_mlp.bin", iterations);
+
+    PolicyNet::WriteRandom("bench_conv.bin", {
+        Conv1d(8, 16, 32, 3),
+        Conv1d(16, 16, 30, 3),
+        Dense(16 * 28, 64, PolicyNet::Activation::RELU),
+        Dense(64, 8, PolicyNet::Activation::TANH)}, 8 * 32, 2);
+    Run("bench_conv.bin", iterations);
+    return 0;
+}
@@ -0,0 +1,330 @@
+#include "policyNet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifdef BLANKBOT_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const size_t WEIGHT_ALIGNMENT = 32;
+
+size_t AlignUp(size_t value) {
+    return (value + WEIGHT_ALIGNMENT - 1) & ~(WEIGHT_ALIGNMENT - 1);
+}
+
+size_t LayerInputSize(const PolicyNet::NetLayer& layer) {
+    if (layer.type == PolicyNet::LayerType::CONV1D)
+        return static_cast<size_t>(layer.in_channels) * layer.length;
+    return layer.in_channels;
+}
+
+size_t LayerOutputSize(const PolicyNet::NetLayer& layer) {
+    if (layer.type == PolicyNet::LayerType::CONV1D)
+        return static_cast<size_t>(layer.out_channels) * (layer.length - layer.kernel + 1);
+    return layer.out_channels;
+}
+
+// Weight matrix is [out_channels][in_channels * kernel] for both layer types.
+size_t LayerWeightCount(const PolicyNet::NetLayer& layer) {
+    size_t kernel = layer.type == PolicyNet::LayerType::CONV1D ? layer.kernel : 1;
+    return static_cast<size_t>(layer.out_channels) * layer.in_channels * kernel;
+}
+
+// y[r][o] = b[o] + dot(x[r], w[o]) for rows x of width n.
+// Four rows share each weight load, which is where batching pays off.
+#ifdef BLANKBOT_AVX2
+
+float HorizontalSum(__m256 v) {
+    __m128 low = _mm256_castps256_ps128(v);
+    __m128 high = _mm256_extractf128_ps(v, 1);
+    low = _mm_add_ps(low, high);
+    low = _mm_hadd_ps(low, low);
+    low = _mm_hadd_ps(low, low);
+    return _mm_cvtss_f32(low);
+}
+
+void MatMulBias(const float* x, size_t rows, size_t n, const float* w, const float* b, size_t outputs, float* y) {
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const float* x0 = x + (r + 0) * n;
+        const float* x1 = x + (r + 1) * n;
+        const float* x2 = x + (r + 2) * n;
+        const float* x3 = x + (r + 3) * n;
+        for (size_t o = 0; o < outputs; ++o) {
+            const float* wo = w + o * n;
+            __m256 a0 = _mm256_setzero_ps();
+            __m256 a1 = _mm256_setzero_ps();
+            __m256 a2 = _mm256_setzero_ps();
+            __m256 a3 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256 wv = _mm256_loadu_ps(wo + i);
+                a0 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x0 + i), a0);
+                a1 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x1 + i), a1);
+                a2 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x2 + i), a2);
+                a3 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x3 + i), a3);
+            }
+            float s0 = HorizontalSum(a0);
+            float s1 = HorizontalSum(a1);
+            float s2 = HorizontalSum(a2);
+            float s3 = HorizontalSum(a3);
+            for (; i < n; ++i) {
+                s0 += wo[i] * x0[i];
+                s1 += wo[i] * x1[i];
+                s2 += wo[i] * x2[i];
+                s3 += wo[i] * x3[i];
+            }
+            y[(r + 0) * outputs + o] = s0 + b[o];
+            y[(r + 1) * outputs + o] = s1 + b[o];
+            y[(r + 2) * outputs + o] = s2 + b[o];
+            y[(r + 3) * outputs + o] = s3 + b[o];
+        }
+    }
+
+    for (; r < rows; ++r) {
+        const float* xr = x + r * n;
+        for (size_t o = 0; o < outputs; ++o) {
+            const float* wo = w + o * n;
+            __m256 acc = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(wo + i), _mm256_loadu_ps(xr + i), acc);
+            float sum = HorizontalSum(acc);
+            for (; i < n; ++i)
+                sum += wo[i] * xr[i];
+            y[r * outputs + o] = sum + b[o];
+        }
+    }
+}
+
+#else
+
+// Portable kernel; independent accumulators let the compiler vectorise it.
+void MatMulBias(const float* x, size_t rows, size_t n, const float* w, const float* b, size_t outputs, float* y) {
+    for (size_t r = 0; r < rows; ++r) {
+        const float* xr = x + r * n;
+        for (size_t o = 0; o < outputs; ++o) {
+            const float* wo = w + o * n;
+            float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                a0 += wo[i + 0] * xr[i + 0];
+                a1 += wo[i + 1] * xr[i + 1];
+                a2 += wo[i + 2] * xr[i + 2];
+                a3 += wo[i + 3] * xr[i + 3];
+            }
+            float sum = (a0 + a1) + (a2 + a3);
+            for (; i < n; ++i)
+                sum += wo[i] * xr[i];
+            y[r * outputs + o] = sum + b[o];
+        }
+    }
+}
+
+#endif
+
+void Activate(PolicyNet::Activation activation, float* values, size_t count) {
+    switch (activation) {
+        case PolicyNet::Activation::RELU:
+            for (size_t i = 0; i < count; ++i)
+                values[i] = std::max(values[i], 0.0f);
+            break;
+        case PolicyNet::Activation::TANH:
+            for (size_t i = 0; i < count; ++i)
+                values[i] = std::tanh(values[i]);
+            break;
+        default:
+            break;
+    }
+}
+
+}  // namespace
+
+bool PolicyNet::Load(const std::string& path) {
+    Close();
+
+    if (!file_.OpenRead(path))
+        return false;
+
+    const uint8_t* data = file_.Data();
+    size_t size = file_.Size();
+
+    NetHeader header;
+    if (size < sizeof(header)) {
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION || header.layer_count == 0 ||
+        size < sizeof(header) + static_cast<size_t>(header.layer_count) * sizeof(NetLayer)) {
+        std::cerr << "Policy " << path << ": bad header" << std::endl;
+        Close();
+        return false;
+    }
+
+    // Validate the whole chain before keeping any of it
+    std::vector<Layer> layers;
+    size_t width = header.input_size;
+    size_t max_width = width;
+    size_t max_unfolded = 0;
+    for (uint32_t i = 0; i < header.layer_count; ++i) {
+        NetLayer desc;
+        std::memcpy(&desc, data + sizeof(header) + i * sizeof(NetLayer), sizeof(desc));
+
+        bool conv = desc.type == LayerType::CONV1D;
+        bool valid = (desc.type == LayerType::DENSE || conv) &&
+            desc.in_channels > 0 && desc.out_channels > 0 &&
+            (!conv || (desc.kernel > 0 && desc.length >= desc.kernel)) &&
+            LayerInputSize(desc) == width;
+
+        size_t weight_bytes = LayerWeightCount(desc) * sizeof(float);
+        size_t bias_bytes = static_cast<size_t>(desc.out_channels) * sizeof(float);
+        valid = valid &&
+            desc.weights_offset % sizeof(float) == 0 && desc.bias_offset % sizeof(float) == 0 &&
+            desc.weights_offset <= size && weight_bytes <= size - desc.weights_offset &&
+            desc.bias_offset <= size && bias_bytes <= size - desc.bias_offset;
+        if (!valid) {
+            std::cerr << "Policy " << path << ": layer " << i << " does not fit" << std::endl;
+            Close();
+            return false;
+        }
+
+        Layer layer;
+        layer.desc = desc;
+        layer.weights = reinterpret_cast<const float*>(data + desc.weights_offset);
+        layer.bias = reinterpret_cast<const float*>(data + desc.bias_offset);
+        layer.in_size = width;
+        layer.out_size = LayerOutputSize(desc);
+        layers.push_back(layer);
+
+        if (conv) {
+            size_t positions = desc.length - desc.kernel + 1;
+            max_unfolded = std::max(max_unfolded, positions * desc.in_channels * desc.kernel);
+            // The kernel writes [position][channel] before transposing
+            max_width = std::max(max_width, layer.out_size);
+        }
+        width = layer.out_size;
+        max_width = std::max(max_width, width);
+    }
+
+    layers_.swap(layers);
+    input_size_ = header.input_size;
+    output_size_ = width;
+    max_width_ = max_width;
+
+    for (auto& buffer : activations_)
+        buffer.assign(CHUNK_ROWS * max_width_, 0.0f);
+    unfolded_.assign(max_unfolded + max_width_, 0.0f);
+    return true;
+}
+
+void PolicyNet::Close() {
+    layers_.clear();
+    file_.Close();
+    input_size_ = 0;
+    output_size_ = 0;
+}
+
+void PolicyNet::RunLayer(const Layer& layer, const float* in, size_t rows, float* out) {
+    const NetLayer& desc = layer.desc;
+
+    if (desc.type == LayerType::DENSE) {
+        MatMulBias(in, rows, desc.in_channels, layer.weights, layer.bias, desc.out_channels, out);
+        Activate(desc.activation, out, rows * layer.out_size);
+        return;
+    }
+
+    // Conv1d: unfold each window into a row, multiply, then transpose the
+    // [position][channel] result back to [channel][position]
+    size_t positions = desc.length - desc.kernel + 1;
+    size_t window = static_cast<size_t>(desc.in_channels) * desc.kernel;
+    float* unfolded = unfolded_.data();
+    float* product = unfolded_.data() + positions * window;
+
+    for (size_t r = 0; r < rows; ++r) {
+        const float* x = in + r * layer.in_size;
+        for (size_t t = 0; t < positions; ++t) {
+            float* row = unfolded + t * window;
+            for (size_t c = 0; c < desc.in_channels; ++c)
+                std::memcpy(row + c * desc.kernel, x + c * desc.length + t, desc.kernel * sizeof(float));
+        }
+
+        MatMulBias(unfolded, positions, window, layer.weights, layer.bias, desc.out_channels, product);
+
+        float* y = out + r * layer.out_size;
+        for (size_t t = 0; t < positions; ++t) {
+            for (size_t c = 0; c < desc.out_channels; ++c)
+                y[c * positions + t] = product[t * desc.out_channels + c];
+        }
+    }
+    Activate(desc.activation, out, rows * layer.out_size);
+}
+
+void PolicyNet::RunChunk(const float* inputs, size_t rows, float* outputs) {
+    const float* in = inputs;
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        bool last = i + 1 == layers_.size();
+        float* out = last ? outputs : activations_[i % 2].data();
+        RunLayer(layers_[i], in, rows, out);
+        in = out;
+    }
+}
+
+size_t PolicyNet::Evaluate(const float* inputs, size_t rows, float* outputs) {
+    if (!IsLoaded())
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + budget_;
+
+    size_t done = 0;
+    while (done < rows) {
+        size_t count = std::min(CHUNK_ROWS, rows - done);
+        RunChunk(inputs + done * input_size_, count, outputs + done * output_size_);
+        done += count;
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+
+    last_latency_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    max_latency_ = std::max(max_latency_, last_latency_);
+    return done;
+}
+
+bool PolicyNet::WriteRandom(const std::string& path, const std::vector<NetLayer>& layers,
+                            uint32_t input_size, uint32_t seed) {
+    NetHeader header = {MAGIC, VERSION, static_cast<uint32_t>(layers.size()), input_size};
+
+    std::vector<NetLayer> descs = layers;
+    size_t offset = AlignUp(sizeof(header) + descs.size() * sizeof(NetLayer));
+    for (auto& desc : descs) {
+        desc.weights_offset = offset;
+        offset = AlignUp(offset + LayerWeightCount(desc) * sizeof(float));
+        desc.bias_offset = offset;
+        offset = AlignUp(offset + desc.out_channels * sizeof(float));
+    }
+
+    std::vector<uint8_t> image(offset, 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(header), descs.data(), descs.size() * sizeof(NetLayer));
+
+    std::mt19937 rng(seed);
+    for (const auto& desc : descs) {
+        size_t fan_in = LayerWeightCount(desc) / desc.out_channels;
+        std::normal_distribution<float> weight(0.0f, 1.0f / std::sqrt(static_cast<float>(fan_in)));
+        float* w = reinterpret_cast<float*>(image.data() + desc.weights_offset);
+        for (size_t i = 0; i < LayerWeightCount(desc); ++i)
+            w[i] = weight(rng);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,111 @@
+#ifndef POLICY_NET_H
+#define POLICY_NET_H
+
+#include "mappedFile.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small feed-forward policy network evaluated on the CPU.
+// Weights are used in place from a memory-mapped file, activations live in
+// buffers sized once at load time, and dense layers run through a SIMD
+// matmul kernel (AVX2 when built with ENABLE_AVX2). Every evaluation has a
+// hard time budget: rows that do not fit are left for the caller to decide
+// some other way.
+//
+// File layout, little-endian:
+//   NetHeader
+//   NetLayer[layer_count]
+//   float32 weights and biases, each array starting on a 32-byte boundary
+class PolicyNet {
+public:
+    static constexpr uint32_t MAGIC = 0x4e504242;   // "BBPN"
+    static constexpr uint32_t VERSION = 1;
+
+    enum class LayerType : uint32_t {
+        DENSE = 1,      // out = W[out][in] * x + b
+        CONV1D = 2      // valid, stride 1; x is [channels][length]
+    };
+
+    enum class Activation : uint32_t {
+        NONE = 0,
+        RELU = 1,
+        TANH = 2
+    };
+
+    struct NetHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t layer_count;
+        uint32_t input_size;
+    };
+
+    struct NetLayer {
+        LayerType type;
+        Activation activation;
+        uint32_t in_channels;       // dense: inputs
+        uint32_t out_channels;      // dense: outputs
+        uint32_t length;            // conv1d: input length, dense: 1
+        uint32_t kernel;            // conv1d: kernel width, dense: 1
+        uint64_t weights_offset;    // bytes from the start of the file
+        uint64_t bias_offset;
+    };
+
+    // Maps the file, checks the layer chain and sizes the buffers.
+    bool Load(const std::string& path);
+    void Close();
+
+    bool IsLoaded() const { return !layers_.empty(); }
+    size_t InputSize() const { return input_size_; }
+    size_t OutputSize() const { return output_size_; }
+
+    // Per-evaluation time budget.
+    void SetBudget(std::chrono::microseconds budget) { budget_ = budget; }
+
+    // Runs rows of input_size floats through the network, writing rows of
+    // output_size floats. Returns how many leading rows were evaluated before
+    // the budget ran out; the first chunk of rows always runs.
+    size_t Evaluate(const float* inputs, size_t rows, float* outputs);
+
+    // Timing of the last call and the worst call so far.
+    std::chrono::microseconds LastLatency() const { return last_latency_; }
+    std::chrono::microseconds MaxLatency() const { return max_latency_; }
+
+    // Writes a randomly initialised network, for tests and benchmarks.
+    static bool WriteRandom(const std::string& path, const std::vector<NetLayer>& layers,
+                            uint32_t input_size, uint32_t seed);
+
+private:
+    // Rows are processed in chunks of this size between budget checks.
+    static constexpr size_t CHUNK_ROWS = 16;
+
+    struct Layer {
+        NetLayer desc;
+        const float* weights;
+        const float* bias;
+        size_t in_size;     // floats per input row
+        size_t out_size;    // floats per output row
+    };
+
+    void RunChunk(const float* inputs, size_t rows, float* outputs);
+    void RunLayer(const Layer& layer, const float* in, size_t rows, float* out);
+
+    MappedFile file_;
+    std::vector<Layer> layers_;
+    size_t input_size_ = 0;
+    size_t output_size_ = 0;
+    size_t max_width_ = 0;
+
+    // Ping-pong activations and conv1d unfolding, CHUNK_ROWS rows each
+    std::vector<float> activations_[2];
+    std::vector<float> unfolded_;
+
+    std::chrono::microseconds budget_{500};
+    std::chrono::microseconds last_latency_{0};
+    std::chrono::microseconds max_latency_{0};
+};
+
+#endif // POLICY_NET_H
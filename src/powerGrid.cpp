@@ -0,0 +1,338 @@
+#include "powerGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sc2;
+
+namespace {
+
+bool IsMineralField(UNIT_TYPEID type) {
+    switch (type) {
+        case UNIT_TYPEID::NEUTRAL_MINERALFIELD:
+        case UNIT_TYPEID::NEUTRAL_MINERALFIELD750:
+        case UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD:
+        case UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsGeyser(UNIT_TYPEID type) {
+    switch (type) {
+        case UNIT_TYPEID::NEUTRAL_VESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_RICHVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_PURIFIERVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_SHAKURASVESPENEGEYSER:
+        case UNIT_TYPEID::NEUTRAL_SPACEPLATFORMGEYSER:
+        case UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+void PowerGrid::Initialize(const GameInfo& game_info, const Units& neutral_units) {
+    width_ = game_info.width;
+    height_ = game_info.height;
+
+    placeable_ = BitGrid::FromImage(ImageView(game_info.placement_grid));
+    pathable_ = BitGrid::FromImage(ImageView(game_info.pathing_grid));
+    placeable_.And(PlayableMask(game_info));
+    occupied_.Resize(width_, height_);
+    powered_.Resize(width_, height_);
+    free_.Resize(width_, height_);
+    ready_.Resize(width_, height_);
+    coverage_.Resize(width_, height_, 0);
+    powering_pylons_.clear();
+    foreign_.clear();
+
+    // Cells covered by a power field, nearest to the pylon center first
+    field_.clear();
+    int reach = static_cast<int>(std::ceil(POWER_RADIUS));
+    for (int dy = -reach; dy < reach; ++dy) {
+        for (int dx = -reach; dx < reach; ++dx) {
+            float cx = dx + 0.5f;
+            float cy = dy + 0.5f;
+            if (cx * cx + cy * cy <= POWER_RADIUS * POWER_RADIUS)
+                field_.push_back({dx, dy});
+        }
+    }
+    std::sort(field_.begin(), field_.end(), [](const FieldCell& a, const FieldCell& b) {
+        float da = (a.dx + 0.5f) * (a.dx + 0.5f) + (a.dy + 0.5f) * (a.dy + 0.5f);
+        float db = (b.dx + 0.5f) * (b.dx + 0.5f) + (b.dy + 0.5f) * (b.dy + 0.5f);
+        return da < db;
+    });
+
+    // Resources block placement but are not part of the placement grid
+    for (const auto& unit : neutral_units) {
+        if (IsMineralField(unit->unit_type)) {
+            int x = static_cast<int>(std::floor(unit->pos.x)) - 1;
+            int y = static_cast<int>(std::floor(unit->pos.y));
+            occupied_.StampRect(x, y, 2, 1, true);
+        }
+        else if (IsGeyser(unit->unit_type)) {
+            int x0;
+            int y0;
+            FootprintOrigin(unit->pos, 3, &x0, &y0);
+            occupied_.StampRect(x0, y0, 3, 3, true);
+        }
+    }
+    RefreshReady(0, height_);
+}
+
+void PowerGrid::FootprintOrigin(const Point2D& center, int size, int* x, int* y) const {
+    *x = static_cast<int>(std::floor(center.x - size / 2.0f + 0.5f));
+    *y = static_cast<int>(std::floor(center.y - size / 2.0f + 0.5f));
+}
+
+void PowerGrid::RefreshReady(int y_begin, int y_end) {
+    // Unit events touch a footprint or a power field, a few rows at most
+    y_begin = std::max(y_begin, 0);
+    y_end = std::min(y_end, height_);
+    int stride = free_.Stride();
+
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint64_t* placeable = placeable_.Row(y);
+        const uint64_t* occupied = occupied_.Row(y);
+        const uint64_t* powered = powered_.Row(y);
+        uint64_t* free = free_.Row(y);
+        uint64_t* ready = ready_.Row(y);
+        for (int i = 0; i < stride; ++i) {
+            free[i] = placeable[i] & ~occupied[i];
+            ready[i] = free[i] & powered[i];
+        }
+    }
+}
+
+void PowerGrid::Stamp(const Point2D& center, int size, bool occupied) {
+    int x0;
+    int y0;
+    FootprintOrigin(center, size, &x0, &y0);
+    occupied_.StampRect(x0, y0, size, size, occupied);
+    RefreshReady(y0, y0 + size);
+}
+
+void PowerGrid::AddPower(const Point2D& pylon_pos, int delta) {
+    int px = static_cast<int>(std::floor(pylon_pos.x + 0.5f));
+    int py = static_cast<int>(std::floor(pylon_pos.y + 0.5f));
+
+    for (const auto& cell : field_) {
+        int x = px + cell.dx;
+        int y = py + cell.dy;
+        if (!Contains(x, y))
+            continue;
+
+        uint8_t& count = coverage_.At(x, y);
+        count = static_cast<uint8_t>(std::max(0, count + delta));
+        powered_.Set(x, y, count > 0);
+    }
+
+    int reach = static_cast<int>(std::ceil(POWER_RADIUS));
+    RefreshReady(py - reach, py + reach);
+}
+
+void PowerGrid::OnStructureCreated(const Unit* unit) {
+    int size = FootprintSize(unit->unit_type);
+    if (size == 0 || !IsInitialized())
+        return;
+
+    Stamp(unit->pos, size, true);
+}
+
+void PowerGrid::OnStructureCompleted(const Unit* unit) {
+    if (unit->unit_type != UNIT_TYPEID::PROTOSS_PYLON || !IsInitialized())
+        return;
+
+    if (powering_pylons_.insert(unit->tag).second)
+        AddPower(unit->pos, 1);
+}
+
+void PowerGrid::OnStructureDestroyed(const Unit* unit) {
+    int size = FootprintSize(unit->unit_type);
+    if (size == 0 || !IsInitialized())
+        return;
+
+    Stamp(unit->pos, size, false);
+    if (powering_pylons_.erase(unit->tag) > 0)
+        AddPower(unit->pos, -1);
+}
+
+void PowerGrid::ObserveForeignStructures(const Units& units, const UnitTypes& types) {
+    if (!IsInitialized())
+        return;
+
+    for (const auto& unit : units) {
+        if (IsMineralField(unit->unit_type) || IsGeyser(unit->unit_type))
+            continue;
+
+        auto found = foreign_.find(unit->tag);
+        if (found != foreign_.end()) {
+            // Lifted Terran buildings fly off and may land elsewhere
+            Footprint& footprint = found->second;
+            if (!unit->is_flying && footprint.center.x == unit->pos.x && footprint.center.y == unit->pos.y)
+                continue;
+            Stamp(footprint.center, footprint.size, false);
+            if (unit->is_flying) {
+                foreign_.erase(found);
+                continue;
+            }
+            footprint.center = unit->pos;
+            Stamp(footprint.center, footprint.size, true);
+            continue;
+        }
+
+        uint32_t type_id = unit->unit_type;
+        if (unit->is_flying || type_id >= types.size())
+            continue;
+        const auto& attributes = types[type_id].attributes;
+        if (std::find(attributes.begin(), attributes.end(), Attribute::Structure) == attributes.end())
+            continue;
+
+        // Structure radii sit just below half their footprint: 1.125 for
+        // 2x2, 1.8125 for 3x3, 2.75 for 5x5
+        int size = std::max(1, static_cast<int>(unit->radius * 2.0f));
+        foreign_.emplace(unit->tag, Footprint{unit->pos, size});
+        Stamp(unit->pos, size, true);
+    }
+}
+
+void PowerGrid::OnForeignStructureDestroyed(Tag tag) {
+    auto found = foreign_.find(tag);
+    if (found == foreign_.end())
+        return;
+
+    Stamp(found->second.center, found->second.size, false);
+    foreign_.erase(found);
+}
+
+bool PowerGrid::CanPlace(const Point2D& pos, int size, bool needs_power) const {
+    int x0;
+    int y0;
+    FootprintOrigin(pos, size, &x0, &y0);
+    if (!Contains(x0, y0) || !Contains(x0 + size - 1, y0 + size - 1))
+        return false;
+
+    const BitGrid& grid = needs_power ? ready_ : free_;
+    uint64_t full = (1ull << size) - 1;
+    for (int y = y0; y < y0 + size; ++y) {
+        if (grid.Span(x0, y, size) != full)
+            return false;
+    }
+    return true;
+}
+
+void PowerGrid::CandidatesNear(const Point2D& pylon_pos, int size, size_t max_count,
+                               std::vector<Point2D>* out) const {
+    int px = static_cast<int>(std::floor(pylon_pos.x + 0.5f));
+    int py = static_cast<int>(std::floor(pylon_pos.y + 0.5f));
+
+    for (const auto& cell : field_) {
+        if (out->size() >= max_count)
+            return;
+
+        // Treat the field cell as the footprint's central cell
+        int x0 = px + cell.dx - size / 2;
+        int y0 = py + cell.dy - size / 2;
+        Point2D center(x0 + size / 2.0f, y0 + size / 2.0f);
+        if (CanPlace(center, size, true))
+            out->push_back(center);
+    }
+}
+
+bool PowerGrid::FindPlacement(const Point2D& near, int size, bool needs_power, float max_distance,
+                              Point2D* out) const {
+    int cx = static_cast<int>(std::floor(near.x));
+    int cy = static_cast<int>(std::floor(near.y));
+    int max_ring = static_cast<int>(max_distance);
+
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        for (int dy = -ring; dy <= ring; ++dy) {
+            // Walk only the border of the ring
+            int step = (dy == -ring || dy == ring) ? 1 : 2 * ring;
+            for (int dx = -ring; dx <= ring; dx += std::max(step, 1)) {
+                int x0 = cx + dx - size / 2;
+                int y0 = cy + dy - size / 2;
+                Point2D center(x0 + size / 2.0f, y0 + size / 2.0f);
+                if (CanPlace(center, size, needs_power)) {
+                    *out = center;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void PowerGrid::WarpInCandidates(const Point2D& pylon_pos, size_t max_count, std::vector<Point2D>* out) const {
+    int px = static_cast<int>(std::floor(pylon_pos.x + 0.5f));
+    int py = static_cast<int>(std::floor(pylon_pos.y + 0.5f));
+
+    for (const auto& cell : field_) {
+        if (out->size() >= max_count)
+            return;
+
+        int x = px + cell.dx;
+        int y = py + cell.dy;
+        if (Contains(x, y) && powered_.Get(x, y) && pathable_.Get(x, y) && !occupied_.Get(x, y))
+            out->push_back(Point2D(x + 0.5f, y + 0.5f));
+    }
+}
+
+bool PowerGrid::IsPowered(const Point2D& pos) const {
+    int x = static_cast<int>(std::floor(pos.x));
+    int y = static_cast<int>(std::floor(pos.y));
+    return Contains(x, y) && powered_.Get(x, y);
+}
+
+int PowerGrid::FootprintSize(UnitTypeID type) {
+    switch (type.ToType()) {
+        case UNIT_TYPEID::PROTOSS_NEXUS:
+            return 5;
+        case UNIT_TYPEID::PROTOSS_GATEWAY:
+        case UNIT_TYPEID::PROTOSS_WARPGATE:
+        case UNIT_TYPEID::PROTOSS_FORGE:
+        case UNIT_TYPEID::PROTOSS_CYBERNETICSCORE:
+        case UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY:
+        case UNIT_TYPEID::PROTOSS_STARGATE:
+        case UNIT_TYPEID::PROTOSS_TWILIGHTCOUNCIL:
+        case UNIT_TYPEID::PROTOSS_ROBOTICSBAY:
+        case UNIT_TYPEID::PROTOSS_TEMPLARARCHIVE:
+        case UNIT_TYPEID::PROTOSS_DARKSHRINE:
+        case UNIT_TYPEID::PROTOSS_FLEETBEACON:
+        case UNIT_TYPEID::PROTOSS_ASSIMILATOR:
+        case UNIT_TYPEID::PROTOSS_ASSIMILATORRICH:
+            return 3;
+        case UNIT_TYPEID::PROTOSS_PYLON:
+        case UNIT_TYPEID::PROTOSS_PHOTONCANNON:
+        case UNIT_TYPEID::PROTOSS_SHIELDBATTERY:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+int PowerGrid::FootprintSize(AbilityID ability) {
+    switch (ability.ToType()) {
+        case ABILITY_ID::BUILD_NEXUS:
+            return 5;
+        case ABILITY_ID::BUILD_GATEWAY:
+        case ABILITY_ID::BUILD_FORGE:
+        case ABILITY_ID::BUILD_CYBERNETICSCORE:
+        case ABILITY_ID::BUILD_ROBOTICSFACILITY:
+        case ABILITY_ID::BUILD_STARGATE:
+        case ABILITY_ID::BUILD_TWILIGHTCOUNCIL:
+        case ABILITY_ID::BUILD_ASSIMILATOR:
+            return 3;
+        case ABILITY_ID::BUILD_PYLON:
+        case ABILITY_ID::BUILD_PHOTONCANNON:
+        case ABILITY_ID::BUILD_SHIELDBATTERY:
+            return 2;
+        default:
+            return 0;
+    }
+}
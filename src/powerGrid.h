@@ -0,0 +1,107 @@
+#ifndef POWER_GRID_H
+#define POWER_GRID_H
+
+#include "mapGrid.h"
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Bit-packed map of where Protoss structures can go.
+// Placement and pathing are decoded once from GameInfo; structure footprints
+// and pylon power fields are then stamped incrementally from unit events and,
+// for enemy and neutral structures, from the observation, so "is this
+// footprint powered and free" is a handful of word operations and never a
+// round-trip to the game.
+class PowerGrid {
+public:
+    // Pylon power field radius
+    static constexpr float POWER_RADIUS = 6.5f;
+
+    // Decodes the static grids and stamps resources already on the map.
+    void Initialize(const sc2::GameInfo& game_info, const sc2::Units& neutral_units);
+
+    // A structure was placed: its footprint is no longer buildable.
+    void OnStructureCreated(const sc2::Unit* unit);
+
+    // A structure finished: completed pylons start powering their field.
+    void OnStructureCompleted(const sc2::Unit* unit);
+
+    // A structure died: free its footprint and drop any power it provided.
+    void OnStructureDestroyed(const sc2::Unit* unit);
+
+    // Stamps enemy or neutral structures not seen before, moves the ones
+    // that landed elsewhere and frees the ones that lifted off. Footprints
+    // come from the unit radius. Resources are left to Initialize.
+    void ObserveForeignStructures(const sc2::Units& units, const sc2::UnitTypes& types);
+
+    // An enemy or neutral structure died: free its footprint.
+    void OnForeignStructureDestroyed(sc2::Tag tag);
+
+    // True if every cell of a size x size footprint centered at pos is
+    // placeable, unoccupied and, if required, powered.
+    bool CanPlace(const sc2::Point2D& pos, int size, bool needs_power) const;
+
+    // Footprint centers inside a pylon's field that can take a structure,
+    // nearest to the pylon first.
+    void CandidatesNear(const sc2::Point2D& pylon_pos, int size, size_t max_count,
+                        std::vector<sc2::Point2D>* out) const;
+
+    // Spiral search for the closest free footprint around a point.
+    bool FindPlacement(const sc2::Point2D& near, int size, bool needs_power, float max_distance,
+                       sc2::Point2D* out) const;
+
+    // Powered, pathable cells where units can be warped in, nearest first.
+    void WarpInCandidates(const sc2::Point2D& pylon_pos, size_t max_count,
+                          std::vector<sc2::Point2D>* out) const;
+
+    bool IsPowered(const sc2::Point2D& pos) const;
+
+    // Footprint edge length of a structure type or build ability, 0 if unknown.
+    static int FootprintSize(sc2::UnitTypeID type);
+    static int FootprintSize(sc2::AbilityID ability);
+
+    bool IsInitialized() const { return width_ > 0; }
+
+private:
+    // Relative cells of a power field, sorted by distance from the pylon.
+    struct FieldCell {
+        int dx;
+        int dy;
+    };
+
+    // Where an enemy or neutral structure was stamped.
+    struct Footprint {
+        sc2::Point2D center;
+        int size;
+    };
+
+    bool Contains(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
+    void FootprintOrigin(const sc2::Point2D& center, int size, int* x, int* y) const;
+    void Stamp(const sc2::Point2D& center, int size, bool occupied);
+    void AddPower(const sc2::Point2D& pylon_pos, int delta);
+    // Recomputes free_ and ready_ for rows [y_begin, y_end) only
+    void RefreshReady(int y_begin, int y_end);
+
+    int width_ = 0;
+    int height_ = 0;
+
+    BitGrid placeable_;
+    BitGrid pathable_;
+    BitGrid occupied_;
+    BitGrid powered_;
+    BitGrid free_;          // placeable & ~occupied
+    BitGrid ready_;         // free & powered
+
+    // Number of completed pylons covering each cell
+    ValueGrid<uint8_t> coverage_;
+
+    std::vector<FieldCell> field_;
+    std::unordered_set<sc2::Tag> powering_pylons_;
+    std::unordered_map<sc2::Tag, Footprint> foreign_;
+};
+
+#endif // POWER_GRID_H
@@ -0,0 +1,212 @@
+#include "productionDispatcher.h"
+
+#include "powerGrid.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+namespace {
+
+// Warp gate cooldowns in game loops (22.4 per second on faster)
+const uint32_t WARP_COOLDOWN_SHORT = 448;
+const uint32_t WARP_COOLDOWN_LONG = 515;
+
+}  // namespace
+
+const ProductionDispatcher::Recipe* ProductionDispatcher::RecipeFor(UNIT_TYPEID unit) {
+    static const Recipe recipes[] = {
+        {UNIT_TYPEID::PROTOSS_PROBE, UNIT_TYPEID::PROTOSS_NEXUS, ABILITY_ID::TRAIN_PROBE, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_ZEALOT, UNIT_TYPEID::PROTOSS_GATEWAY, ABILITY_ID::TRAIN_ZEALOT, ABILITY_ID::TRAINWARP_ZEALOT, WARP_COOLDOWN_SHORT},
+        {UNIT_TYPEID::PROTOSS_ADEPT, UNIT_TYPEID::PROTOSS_GATEWAY, ABILITY_ID::TRAIN_ADEPT, ABILITY_ID::TRAINWARP_ADEPT, WARP_COOLDOWN_SHORT},
+        {UNIT_TYPEID::PROTOSS_STALKER, UNIT_TYPEID::PROTOSS_GATEWAY, ABILITY_ID::TRAIN_STALKER, ABILITY_ID::TRAINWARP_STALKER, WARP_COOLDOWN_LONG},
+        {UNIT_TYPEID::PROTOSS_SENTRY, UNIT_TYPEID::PROTOSS_GATEWAY, ABILITY_ID::TRAIN_SENTRY, ABILITY_ID::TRAINWARP_SENTRY, WARP_COOLDOWN_LONG},
+        {UNIT_TYPEID::PROTOSS_IMMORTAL, UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, ABILITY_ID::TRAIN_IMMORTAL, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_OBSERVER, UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, ABILITY_ID::TRAIN_OBSERVER, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_COLOSSUS, UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, ABILITY_ID::TRAIN_COLOSSUS, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_DISRUPTOR, UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, ABILITY_ID::TRAIN_DISRUPTOR, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_ORACLE, UNIT_TYPEID::PROTOSS_STARGATE, ABILITY_ID::TRAIN_ORACLE, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_PHOENIX, UNIT_TYPEID::PROTOSS_STARGATE, ABILITY_ID::TRAIN_PHOENIX, ABILITY_ID::INVALID, 0},
+        {UNIT_TYPEID::PROTOSS_VOIDRAY, UNIT_TYPEID::PROTOSS_STARGATE, ABILITY_ID::TRAIN_VOIDRAY, ABILITY_ID::INVALID, 0},
+    };
+
+    for (const auto& recipe : recipes) {
+        if (recipe.unit == unit)
+            return &recipe;
+    }
+    return nullptr;
+}
+
+bool ProductionDispatcher::IsProducer(UNIT_TYPEID type) {
+    switch (type) {
+        case UNIT_TYPEID::PROTOSS_NEXUS:
+        case UNIT_TYPEID::PROTOSS_GATEWAY:
+        case UNIT_TYPEID::PROTOSS_WARPGATE:
+        case UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY:
+        case UNIT_TYPEID::PROTOSS_STARGATE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ProductionDispatcher::CanProduce(UNIT_TYPEID producer, const Recipe& recipe) {
+    if (producer == recipe.producer)
+        return true;
+    return producer == UNIT_TYPEID::PROTOSS_WARPGATE && recipe.warp != ABILITY_ID::INVALID;
+}
+
+void ProductionDispatcher::MakeReady(Tag tag) {
+    if (is_ready_.insert(tag).second)
+        ready_.push_back(tag);
+}
+
+void ProductionDispatcher::OnStructureCompleted(const Unit* unit) {
+    if (unit->unit_type == UNIT_TYPEID::PROTOSS_PYLON) {
+        pylons_.push_back(unit->tag);
+        return;
+    }
+    if (IsProducer(unit->unit_type))
+        MakeReady(unit->tag);
+}
+
+void ProductionDispatcher::OnStructureIdle(const Unit* unit) {
+    if (IsProducer(unit->unit_type) && unit->build_progress >= 1.0f)
+        MakeReady(unit->tag);
+}
+
+void ProductionDispatcher::OnStructureDestroyed(const Unit* unit) {
+    // The ready queue drops dead tags when it reaches them
+    is_ready_.erase(unit->tag);
+    warp_ready_loop_.erase(unit->tag);
+    pylons_.erase(std::remove(pylons_.begin(), pylons_.end(), unit->tag), pylons_.end());
+}
+
+void ProductionDispatcher::ClearDemand() {
+    demand_.clear();
+}
+
+void ProductionDispatcher::SetDemand(UNIT_TYPEID unit, int count) {
+    for (auto& entry : demand_) {
+        if (entry.first == unit) {
+            entry.second = count;
+            return;
+        }
+    }
+    demand_.push_back({unit, count});
+}
+
+bool ProductionDispatcher::WarpIn(const Unit* gate, const Recipe& recipe, const ObservationInterface* observation,
+                                  ActionInterface* actions, const PowerGrid& grid, const Point2D& rally) {
+    std::vector<const Unit*> pylons;
+    for (Tag tag : pylons_) {
+        const Unit* pylon = observation->GetUnit(tag);
+        if (pylon && pylon->is_alive)
+            pylons.push_back(pylon);
+    }
+    std::sort(pylons.begin(), pylons.end(), [&rally](const Unit* a, const Unit* b) {
+        return DistanceSquared2D(a->pos, rally) < DistanceSquared2D(b->pos, rally);
+    });
+
+    // Candidates accumulate across pylons; skip the cells already used
+    std::vector<Point2D> cells;
+    for (const auto* pylon : pylons) {
+        grid.WarpInCandidates(pylon->pos, warps_this_step_ + 1, &cells);
+        if (cells.size() > warps_this_step_)
+            break;
+    }
+    if (cells.size() <= warps_this_step_)
+        return false;
+
+    actions->UnitCommand(gate, recipe.warp, cells[warps_this_step_]);
+    ++warps_this_step_;
+    return true;
+}
+
+void ProductionDispatcher::Dispatch(const ObservationInterface* observation, ActionInterface* actions,
+                                    const PowerGrid& grid, const Point2D& rally) {
+    uint32_t loop = observation->GetGameLoop();
+    while (!cooldowns_.empty() && cooldowns_.top().first <= loop) {
+        if (warp_ready_loop_.count(cooldowns_.top().second))
+            MakeReady(cooldowns_.top().second);
+        cooldowns_.pop();
+    }
+
+    // A rejected order leaves the structure idle without a new idle event
+    for (Tag tag : issued_) {
+        const Unit* unit = observation->GetUnit(tag);
+        if (unit && unit->is_alive && unit->orders.empty() && unit->unit_type != UNIT_TYPEID::PROTOSS_WARPGATE)
+            MakeReady(tag);
+    }
+    issued_.clear();
+
+    if (ready_.empty())
+        return;
+
+    warps_this_step_ = 0;
+    int minerals = observation->GetMinerals();
+    int vespene = observation->GetVespene();
+    float supply = static_cast<float>(observation->GetFoodCap() - observation->GetFoodUsed());
+    const UnitTypes& types = observation->GetUnitTypeData();
+
+    size_t count = ready_.size();
+    for (size_t i = 0; i < count; ++i) {
+        Tag tag = ready_.front();
+        ready_.pop_front();
+
+        // Anything busy again will report idle on its own
+        const Unit* unit = observation->GetUnit(tag);
+        if (!unit || !unit->is_alive || unit->build_progress < 1.0f || !unit->orders.empty()) {
+            is_ready_.erase(tag);
+            continue;
+        }
+
+        bool is_warp_gate = unit->unit_type == UNIT_TYPEID::PROTOSS_WARPGATE;
+        if (is_warp_gate) {
+            auto cooling = warp_ready_loop_.find(tag);
+            if (cooling != warp_ready_loop_.end() && cooling->second > loop) {
+                is_ready_.erase(tag);
+                continue;
+            }
+        }
+
+        bool started = false;
+        for (auto& entry : demand_) {
+            const Recipe* recipe = RecipeFor(entry.first);
+            if (entry.second <= 0 || !recipe || !CanProduce(unit->unit_type, *recipe))
+                continue;
+
+            // Hold the structure for the first thing it should make rather
+            // than spend on something further down
+            uint32_t id = static_cast<uint32_t>(entry.first);
+            if (id >= types.size())
+                break;
+            const UnitTypeData& data = types[id];
+            if (data.mineral_cost > minerals || data.vespene_cost > vespene || data.food_required > supply)
+                break;
+
+            if (is_warp_gate) {
+                if (!WarpIn(unit, *recipe, observation, actions, grid, rally))
+                    break;
+                warp_ready_loop_[tag] = loop + recipe->warp_cooldown;
+                cooldowns_.push({loop + recipe->warp_cooldown, tag});
+            }
+            else {
+                actions->UnitCommand(unit, recipe->train);
+                issued_.push_back(tag);
+            }
+
+            minerals -= data.mineral_cost;
+            vespene -= data.vespene_cost;
+            supply -= data.food_required;
+            --entry.second;
+            started = true;
+            break;
+        }
+
+        if (started)
+            is_ready_.erase(tag);
+        else
+            ready_.push_back(tag);
+    }
+}
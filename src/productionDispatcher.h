@@ -0,0 +1,78 @@
+#ifndef PRODUCTION_DISPATCHER_H
+#define PRODUCTION_DISPATCHER_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class PowerGrid;
+
+// Hands queued units to production structures as they become free.
+// Nexuses, gateways, robotics facilities and stargates join a ready queue
+// when they finish or go idle; warp gates rejoin when their cooldown runs
+// out. Each step only the ready structures are looked at, so the cost does
+// not grow with the number of units we own.
+class ProductionDispatcher {
+public:
+    // One of our structures finished construction.
+    void OnStructureCompleted(const sc2::Unit* unit);
+
+    // One of our structures ran out of orders.
+    void OnStructureIdle(const sc2::Unit* unit);
+
+    void OnStructureDestroyed(const sc2::Unit* unit);
+
+    // Demand is what the current state wants started this step, in the
+    // order it was asked for.
+    void ClearDemand();
+    void SetDemand(sc2::UNIT_TYPEID unit, int count);
+
+    // Matches ready structures to demand within what we can afford. Warp
+    // gates warp in at the powered pylon closest to rally.
+    void Dispatch(const sc2::ObservationInterface* observation, sc2::ActionInterface* actions,
+                  const PowerGrid& grid, const sc2::Point2D& rally);
+
+    size_t ReadyCount() const { return ready_.size(); }
+
+private:
+    struct Recipe {
+        sc2::UNIT_TYPEID unit;
+        sc2::UNIT_TYPEID producer;
+        sc2::ABILITY_ID train;
+        sc2::ABILITY_ID warp;           // INVALID if it cannot be warped in
+        uint32_t warp_cooldown;         // game loops
+    };
+
+    static const Recipe* RecipeFor(sc2::UNIT_TYPEID unit);
+    static bool IsProducer(sc2::UNIT_TYPEID type);
+    static bool CanProduce(sc2::UNIT_TYPEID producer, const Recipe& recipe);
+
+    void MakeReady(sc2::Tag tag);
+    bool WarpIn(const sc2::Unit* gate, const Recipe& recipe, const sc2::ObservationInterface* observation,
+                sc2::ActionInterface* actions, const PowerGrid& grid, const sc2::Point2D& rally);
+
+    std::deque<sc2::Tag> ready_;
+    std::unordered_set<sc2::Tag> is_ready_;
+
+    // Warp gates on cooldown, soonest first
+    using Cooldown = std::pair<uint32_t, sc2::Tag>;
+    std::priority_queue<Cooldown, std::vector<Cooldown>, std::greater<Cooldown>> cooldowns_;
+    std::unordered_map<sc2::Tag, uint32_t> warp_ready_loop_;
+
+    // Trained from last step, checked once in case the order was rejected
+    std::vector<sc2::Tag> issued_;
+
+    std::vector<std::pair<sc2::UNIT_TYPEID, int>> demand_;
+    std::vector<sc2::Tag> pylons_;
+
+    // Warp-in cells handed out this step
+    size_t warps_this_step_ = 0;
+};
+
+#endif // PRODUCTION_DISPATCHER_H
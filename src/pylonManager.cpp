@@ -1,5 +1,8 @@
-#include "PylonManager.h"
-#include <sc2api/sc2_client.cc>
+#include "pylonManager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
 
 using namespace sc2;
 
@@ -7,150 +10,193 @@ bool PylonManager::IsPylonPowered(const sc2::Unit* pylon) {
     return pylon && pylon->is_powered;
 }
 
-sc2::Point2D PylonManager::FindBuildLocationNearPylon(const sc2::Unit* pylon, const sc2::ObservationInterface* observation) {
-    if (!pylon) return sc2::Point2D();
-    
-    float search_radius = 5.0f;
-    sc2::Point2D pylon_pos = pylon->pos;
-    
-    for (float dx = -search_radius; dx <= search_radius; dx += 1.0f) {
-        for (float dy = -search_radius; dy <= search_radius; dy += 1.0f) {
-            sc2::Point2D test_pos = pylon_pos + sc2::Point2D(dx, dy);
-            if (observation->IsPathable(test_pos)) {
-                return test_pos;
-            }
-        }
+sc2::Point2D PylonManager::FindBuildLocationNearPylon(const sc2::Unit* pylon, const PowerGrid& grid, int footprint_size) {
+    if (!pylon || footprint_size <= 0) return sc2::Point2D();
+
+    // First fully powered, free footprint in the pylon's field
+    std::vector<sc2::Point2D> candidates;
+    grid.CandidatesNear(pylon->pos, footprint_size, 1, &candidates);
+    if (candidates.empty()) {
+        return sc2::Point2D();
     }
-    return pylon_pos;
+    return candidates.front();
 }
 
-void PylonManager::ManageWorkerAssignments(sc2::ActionInterface* actions, const sc2::ObservationInterface* observation) {
+void PylonManager::ManageWorkerAssignments(sc2::ActionInterface* actions, const sc2::ObservationInterface* observation,
+                                           const BaseIndex& bases) {
 
     // Get all workers
-    Units units = observation->GetUnits();
-    
+    Units units = observation->GetUnits(Unit::Alliance::Self);
+
     std::vector<const Unit*> workers;
-    std::vector<const Unit*> mineral_fields;
     std::vector<const Unit*> assimilators;
-    
+
     for (const auto& unit : units) {
-        if (unit->unit_type == UNIT_TYPEID::PROTOSS_PROBE && unit->alliance == Unit::Alliance::Self) {
+        if (unit->unit_type == UNIT_TYPEID::PROTOSS_PROBE) {
             workers.push_back(unit);
         }
-        else if (IsMineralField(unit->unit_type) && unit->alliance == Unit::Alliance::Neutral) {
-            // TODO: check if within range of a nexus
-            mineral_fields.push_back(unit);
-        }
-        else if (unit->unit_type == UNIT_TYPEID::PROTOSS_ASSIMILATOR && 
-                unit->alliance == Unit::Alliance::Self && 
+        else if (unit->unit_type == UNIT_TYPEID::PROTOSS_ASSIMILATOR &&
                 unit->build_progress == 1.0f) {
             assimilators.push_back(unit);
         }
     }
-    
+
+    // One mineral pool per base we own
+    std::vector<const BaseSite*> owned;
+    bases.OwnedSites(&owned);
+
+    std::vector<MineralPool> pools;
+    for (const auto* site : owned) {
+        const Unit* nexus = observation->GetUnit(site->town_hall);
+        if (!nexus || nexus->build_progress < 1.0f || site->minerals.empty())
+            continue;
+        MineralPool pool;
+        pool.site = site;
+        pool.nexus = nexus;
+        pool.ideal = static_cast<int>(site->minerals.size()) * 2;
+        pools.push_back(pool);
+    }
+
     // Classify all workers by current assignment
     std::vector<const Unit*> idle_workers;
     std::vector<const Unit*> mineral_workers;
     std::vector<const Unit*> gas_workers;
     std::vector<const Unit*> other_workers; // Building, scouting, etc.
-    
+
     for (const auto& worker : workers) {
         if (worker->orders.empty()) {
             idle_workers.push_back(worker);
-        } 
+        }
         else {
             auto& order = worker->orders.front();
-            if (order.ability_id == ABILITY_ID::HARVEST_GATHER) {
-                // Find the target unit
-                const Unit* target = nullptr;
-                for (const auto& unit : units) {
-                    if (unit->tag == order.target_unit_tag) {
-                        target = unit;
-                        break;
+            AbilityID ability = GeneralAbility(order.ability_id, observation);
+            if (ability == ABILITY_ID::HARVEST_GATHER) {
+                const Unit* target = observation->GetUnit(order.target_unit_tag);
+                if (!target)
+                    continue;
+
+                if (target->unit_type == UNIT_TYPEID::PROTOSS_ASSIMILATOR) {
+                    gas_workers.push_back(worker);
+                    continue;
+                }
+
+                mineral_workers.push_back(worker);
+                const BaseSite* site = bases.SiteOf(target->tag);
+                for (auto& pool : pools) {
+                    if (pool.site == site) {
+                        pool.workers.push_back(worker);
+                        ++pool.per_patch[target->tag];
                     }
                 }
-                
-                if (target) {
-                    if (target->unit_type == UNIT_TYPEID::PROTOSS_ASSIMILATOR) {
-                        gas_workers.push_back(worker);
-                    } 
-                    else if (IsMineralField(target->unit_type)) {
-                        mineral_workers.push_back(worker);
+            }
+            else if (ability == ABILITY_ID::HARVEST_RETURN) {
+                // Half of all miners are carrying cargo home at any time
+                if (CarriesGas(worker)) {
+                    gas_workers.push_back(worker);
+                    continue;
+                }
+
+                // The return target is the Nexus; without one, the closest base
+                MineralPool* home = nullptr;
+                float home_dist = std::numeric_limits<float>::max();
+                for (auto& pool : pools) {
+                    if (pool.nexus->tag == order.target_unit_tag) {
+                        home = &pool;
+                        break;
+                    }
+                    float dist = DistanceSquared2D(worker->pos, pool.nexus->pos);
+                    if (order.target_unit_tag == 0 && dist < home_dist) {
+                        home_dist = dist;
+                        home = &pool;
                     }
                 }
-            } 
+                if (home)
+                    ++home->returning;
+            }
             else {
                 other_workers.push_back(worker);
             }
         }
     }
-    
-    // Calculate optimal distributions
-    int total_available_workers = idle_workers.size() + mineral_workers.size() + gas_workers.size();
-    int total_mineral_patches = mineral_fields.size();
-    int total_gas_geysers = assimilators.size();
-    
+
     // Calculate ideal distribution
     int ideal_workers_per_gas = 2;
-    int ideal_gas_workers = total_gas_geysers * ideal_workers_per_gas;
-    int ideal_mineral_workers = total_mineral_patches * 2;
-    
-    // Make sure we're not trying to assign negative workers to minerals
-    if (ideal_mineral_workers < 0) {
-        // We don't have enough workers for both tasks, prioritize some minimum mineral income
-        int min_mineral_workers = std::min(8, total_available_workers);
-        ideal_mineral_workers = min_mineral_workers;
-        ideal_gas_workers = total_available_workers - min_mineral_workers;
-    }
-    
+    int ideal_gas_workers = static_cast<int>(assimilators.size()) * ideal_workers_per_gas;
+
     // 4. Reassign workers to achieve optimal distribution
     // First, make sure gas has exactly the right number of workers
-    int gas_workers_delta = ideal_gas_workers - gas_workers.size();
-    
+    int gas_workers_delta = ideal_gas_workers - static_cast<int>(gas_workers.size());
+
     if (gas_workers_delta > 0) {
         // Need to add workers to gas
         int to_move = std::min(gas_workers_delta, (int)idle_workers.size());
-        
+
         // First use idle workers
         for (int i = 0; i < to_move; i++) {
             AssignWorkerToNearestAssimilator(idle_workers[i], assimilators, actions);
         }
-        
+
         // Remove assigned workers from idle list
         if (to_move > 0) {
             idle_workers.erase(idle_workers.begin(), idle_workers.begin() + to_move);
         }
-        
+
         // If we still need more gas workers, pull from minerals
         gas_workers_delta -= to_move;
         to_move = std::min(gas_workers_delta, (int)mineral_workers.size());
-        
+
         for (int i = 0; i < to_move; i++) {
             AssignWorkerToNearestAssimilator(mineral_workers[i], assimilators, actions);
         }
-    } 
+    }
     else if (gas_workers_delta < 0) {
         // Too many workers on gas, move some to minerals
         int to_move = std::min(-gas_workers_delta, (int)gas_workers.size());
-        
+
         for (int i = 0; i < to_move; i++) {
-            AssignWorkerToNearestMineralPatch(gas_workers[i], mineral_fields, actions);
+            AssignWorkerToMinerals(gas_workers[i], pools, bases, observation, actions);
         }
     }
-    
+
     // 5. Assign any remaining idle workers to minerals
     for (const auto& worker : idle_workers) {
-        AssignWorkerToNearestMineralPatch(worker, mineral_fields, actions);
+        AssignWorkerToMinerals(worker, pools, bases, observation, actions);
+    }
+
+    // 6. Even out the bases: one worker per step from the most
+    // oversaturated base to the hungriest one
+    MineralPool* surplus = nullptr;
+    MineralPool* deficit = nullptr;
+    for (auto& pool : pools) {
+        int excess = pool.Assigned() - pool.ideal;
+        if (excess > 0 && (!surplus || excess > surplus->Assigned() - surplus->ideal))
+            surplus = &pool;
+        if (excess < 0 && (!deficit || excess < deficit->Assigned() - deficit->ideal))
+            deficit = &pool;
+    }
+    if (surplus && deficit && !surplus->workers.empty()) {
+        const Unit* worker = surplus->workers.back();
+        surplus->workers.pop_back();
+        AssignWorkerToPool(worker, *deficit, observation, actions);
     }
 }
 
 // Helper methods
-bool PylonManager::IsMineralField(UNIT_TYPEID unit_type) {
-    // Check if it's a mineral field type
-    return unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD || 
-           unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750 ||
-           unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD ||
-           unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750;
+AbilityID PylonManager::GeneralAbility(AbilityID ability, const ObservationInterface* observation) {
+    // Orders carry the race-specific variant, e.g. HARVEST_GATHER_PROBE
+    const Abilities& abilities = observation->GetAbilityData();
+    uint32_t id = ability;
+    if (id < abilities.size() && abilities[id].remaps_to_ability_id != 0)
+        return AbilityID(abilities[id].remaps_to_ability_id);
+    return ability;
+}
+
+bool PylonManager::CarriesGas(const Unit* worker) {
+    for (const auto& buff : worker->buffs) {
+        if (buff == BUFF_ID::CARRYHARVESTABLEVESPENEGEYSERGAS || buff == BUFF_ID::CARRYHARVESTABLEVESPENEGEYSERGASPROTOSS)
+            return true;
+    }
+    return false;
 }
 
 void PylonManager::AssignWorkerToNearestAssimilator(const Unit* worker, 
@@ -174,23 +220,80 @@ void PylonManager::AssignWorkerToNearestAssimilator(const Unit* worker,
     }
 }
 
-void PylonManager::AssignWorkerToNearestMineralPatch(const Unit* worker,
-                                                    const std::vector<const Unit*>& minerals,
-                                                    ActionInterface* actions) {
-    if (minerals.empty()) return;
-    
-    // Find nearest mineral patch
-    float closest_dist = std::numeric_limits<float>::max();
+void PylonManager::AssignWorkerToPool(const Unit* worker, MineralPool& pool,
+                                      const ObservationInterface* observation, ActionInterface* actions) {
+    // Least used patch, closest to the Nexus on ties
+    const Unit* best_patch = nullptr;
+    int best_count = std::numeric_limits<int>::max();
+    float best_dist = std::numeric_limits<float>::max();
+
+    for (Tag tag : pool.site->minerals) {
+        const Unit* patch = observation->GetUnit(tag);
+        if (!patch)
+            continue;
+        int count = pool.per_patch[tag];
+        float dist = DistanceSquared2D(patch->pos, pool.nexus->pos);
+        if (count < best_count || (count == best_count && dist < best_dist)) {
+            best_count = count;
+            best_dist = dist;
+            best_patch = patch;
+        }
+    }
+
+    if (best_patch) {
+        actions->UnitCommand(worker, ABILITY_ID::HARVEST_GATHER, best_patch);
+        pool.workers.push_back(worker);
+        ++pool.per_patch[best_patch->tag];
+    }
+}
+
+void PylonManager::AssignWorkerToMinerals(const Unit* worker, std::vector<MineralPool>& pools, const BaseIndex& bases,
+                                          const ObservationInterface* observation, ActionInterface* actions) {
+    // Base with the most open slots, nearest on ties
+    MineralPool* best_pool = nullptr;
+    int best_open = std::numeric_limits<int>::min();
+    float best_dist = std::numeric_limits<float>::max();
+
+    for (auto& pool : pools) {
+        int open = pool.ideal - pool.Assigned();
+        float dist = DistanceSquared2D(worker->pos, pool.nexus->pos);
+        if (open > best_open || (open == best_open && dist < best_dist)) {
+            best_open = open;
+            best_dist = dist;
+            best_pool = &pool;
+        }
+    }
+
+    if (best_pool) {
+        AssignWorkerToPool(worker, *best_pool, observation, actions);
+        return;
+    }
+
+    // No mining base left: long-distance mine the nearest site. Before the
+    // base index is built, any visible mineral field will do
+    const BaseSite* site = bases.NearestSite(worker->pos);
+    Units candidates;
+    if (site) {
+        for (Tag tag : site->minerals) {
+            if (const Unit* mineral = observation->GetUnit(tag))
+                candidates.push_back(mineral);
+        }
+    }
+    else if (bases.Sites().empty()) {
+        candidates = observation->GetUnits(Unit::Alliance::Neutral,
+            [](const Unit& unit) { return unit.mineral_contents > 0; });
+    }
+
     const Unit* closest_mineral = nullptr;
-    
-    for (const auto& mineral : minerals) {
-        float dist = Distance2D(worker->pos, mineral->pos);
+    float closest_dist = std::numeric_limits<float>::max();
+    for (const Unit* mineral : candidates) {
+        float dist = DistanceSquared2D(worker->pos, mineral->pos);
         if (dist < closest_dist) {
             closest_dist = dist;
             closest_mineral = mineral;
         }
     }
-    
+
     if (closest_mineral) {
         actions->UnitCommand(worker, ABILITY_ID::HARVEST_GATHER, closest_mineral);
     }
@@ -231,7 +334,8 @@ void PylonManager::AssignIdleWorkersToVespene(sc2::ActionInterface* actions, con
     }
 }
 
-void PylonManager::BuildAssimilator(const sc2::ObservationInterface* observation, sc2::ActionInterface* actions) {
+void PylonManager::BuildAssimilator(const sc2::ObservationInterface* observation, sc2::ActionInterface* actions,
+                                    const BaseIndex& bases) {
     std::cout << "\nWe are trying to build an Assimilator" << std::endl;
     // Check if we have enough minerals
     if (observation->GetMinerals() < 75) {
@@ -239,96 +343,50 @@ void PylonManager::BuildAssimilator(const sc2::ObservationInterface* observation
         return;
     }
 
-    // Find all our bases (Nexuses)
-    auto bases = observation->GetUnits(sc2::Unit::Alliance::Self,
-        [](const sc2::Unit& unit) {
-            return unit.unit_type == sc2::UNIT_TYPEID::PROTOSS_NEXUS;
-        });
-
-    if (bases.empty()) {
+    std::vector<const BaseSite*> owned;
+    bases.OwnedSites(&owned);
+    if (owned.empty()) {
         std::cout << "No bases!" << std::endl;
         return; // No bases, can't assign geysers effectively
     }
 
-    // For each base, find the closest available geysers
-    for (const auto& base : bases) {
-        float maxDistanceToBase = 15.0f;
-
-        // Find all nearby vespene geysers without assimilators
-		auto nearbyGeysers = observation->GetUnits(sc2::Unit::Alliance::Neutral,
-		[&observation, &base, maxDistanceToBase](const sc2::Unit& unit) {
-			// Check if it's a vespene geyser
-			if (unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER &&
-				unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_RICHVESPENEGEYSER &&
-				unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_PURIFIERVESPENEGEYSER &&
-				unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_SHAKURASVESPENEGEYSER &&
-				unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_SPACEPLATFORMGEYSER &&
-				unit.unit_type != sc2::UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER) {
-				return false;
-			}
-
-			// Check if the geyser is close enough to this base
-			float distance = sc2::Distance2D(unit.pos, base->pos);
-			if (distance > maxDistanceToBase) {
-				return false;
-			}
-
-			// Debug the distance
-			std::cout << "Found geyser at distance: " << distance << " from base" << std::endl;
-
-			// Check if there's already an assimilator on this geyser
-			auto assimilators = observation->GetUnits(sc2::Unit::Alliance::Self,
-				[&unit](const sc2::Unit& assimilator) {
-					return (assimilator.unit_type == sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR ||
-							assimilator.unit_type == sc2::UNIT_TYPEID::PROTOSS_ASSIMILATORRICH) &&
-							sc2::Distance2D(assimilator.pos, unit.pos) < 1.0f;
-				});
-
-			// Only return true if there's no assimilator on this geyser
-			bool isAvailable = assimilators.empty();
-			if (!isAvailable) {
-				std::cout << "Geyser already has an assimilator" << std::endl;
-			}
-			return isAvailable;
-		});
-        // If there are no available geysers near this base, continue to the next base
-        if (nearbyGeysers.empty()) {
-            std::cout << "No geysers found here!" << std::endl;
-            continue;
-        }
-        std::cout << "Geysers found:" << nearbyGeysers.size() << std::endl;
-
-        // Count existing assimilators near this base
-        int assimilatorsNearBase = 0;
-        auto existingAssimilators = observation->GetUnits(sc2::Unit::Alliance::Self,
-            [&base, maxDistanceToBase](const sc2::Unit& unit) {
-                return (unit.unit_type == sc2::UNIT_TYPEID::PROTOSS_ASSIMILATOR ||
-                    unit.unit_type == sc2::UNIT_TYPEID::PROTOSS_ASSIMILATORRICH) &&
-                    sc2::Distance2D(unit.pos, base->pos) <= maxDistanceToBase;
-            });
-        assimilatorsNearBase = existingAssimilators.size();
-
-        // Don't build more than 2 assimilators per base (typical number of geysers)
-        if (assimilatorsNearBase >= 2) {
-            std::cout << "Already have enough assimilators!" << std::endl;
+    // Workers not already on their way to build one, and the geysers those
+    // that are will take
+    std::vector<const Unit*> workers;
+    std::vector<Tag> claimed;
+    for (const auto& unit : observation->GetUnits(Unit::Alliance::Self)) {
+        if (unit->unit_type != UNIT_TYPEID::PROTOSS_PROBE)
             continue;
+        if (!unit->orders.empty() && unit->orders.front().ability_id == ABILITY_ID::BUILD_ASSIMILATOR)
+            claimed.push_back(unit->orders.front().target_unit_tag);
+        else if (unit->orders.size() <= 1)
+            workers.push_back(unit);
+    }
+
+    std::vector<Tag> free_geysers;
+    for (const auto* site : owned) {
+        free_geysers.clear();
+        bases.FreeGeysers(*site, &free_geysers);
+
+        // Closest free geyser to this base
+        const Unit* geyser = nullptr;
+        float closest_dist = std::numeric_limits<float>::max();
+        for (Tag tag : free_geysers) {
+            if (std::find(claimed.begin(), claimed.end(), tag) != claimed.end())
+                continue;
+            const Unit* candidate = observation->GetUnit(tag);
+            if (!candidate)
+                continue;
+            float dist = DistanceSquared2D(candidate->pos, site->town_hall_pos);
+            if (dist < closest_dist) {
+                closest_dist = dist;
+                geyser = candidate;
+            }
         }
 
-        // Sort geysers by distance to the base
-        std::sort(nearbyGeysers.begin(), nearbyGeysers.end(),
-            [&base](const sc2::Unit* a, const sc2::Unit* b) {
-                return sc2::Distance2D(a->pos, base->pos) < sc2::Distance2D(b->pos, base->pos);
-            });
-
-        // Find idle workers
-        auto workers = observation->GetUnits(sc2::Unit::Alliance::Self,
-            [](const sc2::Unit& unit) {
-                return unit.unit_type == sc2::UNIT_TYPEID::PROTOSS_PROBE &&
-                    // Only use workers that aren't already building something
-                    (unit.orders.empty() ||
-                        (unit.orders.size() == 1 &&
-                            unit.orders[0].ability_id != sc2::ABILITY_ID::BUILD_ASSIMILATOR));
-            });
+        // If there are no available geysers near this base, continue to the next base
+        if (!geyser)
+            continue;
 
         if (workers.empty()) {
             std::cout << "no Workers found!!" << std::endl;
@@ -336,8 +394,7 @@ void PylonManager::BuildAssimilator(const sc2::ObservationInterface* observation
         }
 
         // Order a worker to build an assimilator on the closest geyser to this base
-		std::cout << "Building Assimilator" << std::endl;
-        actions->UnitCommand(workers.front(), sc2::ABILITY_ID::BUILD_ASSIMILATOR, nearbyGeysers.front());
+        actions->UnitCommand(workers.front(), sc2::ABILITY_ID::BUILD_ASSIMILATOR, geyser);
 
         // Only build one assimilator per step
         return;
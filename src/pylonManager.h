@@ -2,25 +2,52 @@
 #define PYLON_MANAGER_H
 
 #include "sc2api/sc2_api.h"
+#include "baseIndex.h"
+#include "powerGrid.h"
+
+#include <unordered_map>
+#include <vector>
 
 using namespace sc2;
 
 class PylonManager {
 public:
     static bool IsPylonPowered(const sc2::Unit* pylon);
-    static sc2::Point2D FindBuildLocationNearPylon(const sc2::Unit* pylon, const sc2::ObservationInterface* observation);
+    static sc2::Point2D FindBuildLocationNearPylon(const sc2::Unit* pylon, const PowerGrid& grid, int footprint_size);
     static void AssignIdleWorkersToVespene(sc2::ActionInterface* actions, const sc2::ObservationInterface* observation);
-    void BuildAssimilator(const sc2::ObservationInterface* observation, sc2::ActionInterface* actions);
-    void ManageWorkerAssignments(sc2::ActionInterface* actions, const sc2::ObservationInterface* observation);
+    void BuildAssimilator(const sc2::ObservationInterface* observation, sc2::ActionInterface* actions,
+                          const BaseIndex& bases);
+    void ManageWorkerAssignments(sc2::ActionInterface* actions, const sc2::ObservationInterface* observation,
+                                 const BaseIndex& bases);
     
 private:
-    bool IsMineralField(UNIT_TYPEID unit_type);
+    // Mineral line of one of our bases and who mines it
+    struct MineralPool {
+        const BaseSite* site = nullptr;
+        const Unit* nexus = nullptr;
+        int ideal = 0;                                  // two per patch
+        std::vector<const Unit*> workers;
+        int returning = 0;                              // carrying minerals back to this Nexus
+        std::unordered_map<sc2::Tag, int> per_patch;
+
+        // Workers mining here, counting those on their way back with cargo
+        int Assigned() const { return static_cast<int>(workers.size()) + returning; }
+    };
+
+    // The generic ability an order's specific one stands for, e.g.
+    // HARVEST_GATHER for HARVEST_GATHER_PROBE; the ability itself otherwise
+    static sc2::AbilityID GeneralAbility(sc2::AbilityID ability, const sc2::ObservationInterface* observation);
+
+    // Whether a returning worker is bringing back gas rather than minerals
+    static bool CarriesGas(const Unit* worker);
+
     void AssignWorkerToNearestAssimilator(const Unit* worker, 
                                          const std::vector<const Unit*>& assimilators,
                                          sc2::ActionInterface* actions);
-    void AssignWorkerToNearestMineralPatch(const Unit* worker,
-                                          const std::vector<const Unit*>& minerals,
-                                          sc2::ActionInterface* actions);
+    void AssignWorkerToPool(const Unit* worker, MineralPool& pool,
+                            const sc2::ObservationInterface* observation, sc2::ActionInterface* actions);
+    void AssignWorkerToMinerals(const Unit* worker, std::vector<MineralPool>& pools, const BaseIndex& bases,
+                                const sc2::ObservationInterface* observation, sc2::ActionInterface* actions);
 };
 
 #endif // PYLON_MANAGER_H
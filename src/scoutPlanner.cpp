@@ -0,0 +1,259 @@
+#include "scoutPlanner.h"
+
+#include "baseIndex.h"
+#include "pathfinder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <system_error>
+
+using namespace sc2;
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+// Sites nearest an enemy main in a straight line that are tried as its natural
+const size_t NATURAL_CANDIDATES = 4;
+
+// Stops closer than this are the same place
+const float SAME_STOP = 4.0f;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t map_hash;
+    uint32_t stops;
+    float length;
+};
+
+struct CacheStop {
+    float x;
+    float y;
+    uint32_t start_location;
+};
+
+}  // namespace
+
+bool ScoutPlanner::Plan(const GameInfo& game_info, const Point2D& start, const BaseIndex& bases,
+                        Pathfinder& pathfinder, const std::string& cache_dir) {
+    route_.clear();
+    length_ = 0.0f;
+    from_cache_ = false;
+
+    uint32_t hash = MapHash(game_info);
+    std::string path = cache_dir.empty() ? std::string() : CachePath(cache_dir, game_info, start);
+    if (!path.empty() && Load(path, hash)) {
+        from_cache_ = true;
+        return !route_.empty();
+    }
+
+    std::vector<ScoutStop> stops;
+    for (const auto& location : game_info.enemy_start_locations) {
+        stops.push_back({location, true});
+    }
+    if (stops.size() > MAX_STOPS) {
+        std::cerr << "Scout route: " << stops.size() - MAX_STOPS << " enemy mains left out" << std::endl;
+        stops.resize(MAX_STOPS);
+    }
+
+    // The natural of each enemy main is the closest other site by ground,
+    // while the route has room for it
+    size_t starts = stops.size();
+    size_t skipped = 0;
+    for (size_t i = 0; i < starts; ++i) {
+        if (stops.size() >= MAX_STOPS) {
+            skipped = starts - i;
+            break;
+        }
+
+        std::vector<const BaseSite*> candidates;
+        for (const auto& site : bases.Sites()) {
+            if (!site.is_start_location && DistanceSquared2D(site.town_hall_pos, stops[i].pos) > SAME_STOP * SAME_STOP)
+                candidates.push_back(&site);
+        }
+        size_t count = std::min(candidates.size(), NATURAL_CANDIDATES);
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                          [&](const BaseSite* a, const BaseSite* b) {
+                              return DistanceSquared2D(a->town_hall_pos, stops[i].pos) <
+                                     DistanceSquared2D(b->town_hall_pos, stops[i].pos);
+                          });
+
+        const BaseSite* natural = nullptr;
+        float best = INF;
+        for (size_t c = 0; c < count; ++c) {
+            float length = pathfinder.PathLength(stops[i].pos, candidates[c]->town_hall_pos);
+            if (length >= 0.0f && length < best) {
+                best = length;
+                natural = candidates[c];
+            }
+        }
+        if (!natural)
+            continue;
+
+        bool known = std::any_of(stops.begin(), stops.end(), [&](const ScoutStop& stop) {
+            return DistanceSquared2D(stop.pos, natural->town_hall_pos) < SAME_STOP * SAME_STOP;
+        });
+        if (!known)
+            stops.push_back({natural->town_hall_pos, false});
+    }
+    if (skipped > 0)
+        std::cerr << "Scout route: naturals of " << skipped << " enemy mains left out" << std::endl;
+
+    if (stops.empty())
+        return false;
+
+    // Node 0 is our main; a pair the pathfinder cannot connect falls back to
+    // the straight line and leaves the detour to the game
+    size_t nodes = stops.size() + 1;
+    std::vector<float> distances(nodes * nodes, 0.0f);
+    for (size_t a = 0; a < nodes; ++a) {
+        Point2D from = a == 0 ? start : stops[a - 1].pos;
+        for (size_t b = a + 1; b < nodes; ++b) {
+            Point2D to = stops[b - 1].pos;
+            float length = pathfinder.PathLength(from, to);
+            if (length < 0.0f)
+                length = Distance2D(from, to);
+            distances[a * nodes + b] = length;
+            distances[b * nodes + a] = length;
+        }
+    }
+
+    std::vector<size_t> order;
+    length_ = SolveOrder(distances, nodes, &order);
+    for (size_t node : order)
+        route_.push_back(stops[node - 1]);
+
+    if (!path.empty() && !Save(path, hash))
+        std::cerr << "Scout route: could not write " << path << std::endl;
+    return true;
+}
+
+float ScoutPlanner::SolveOrder(const std::vector<float>& distances, size_t nodes, std::vector<size_t>* order) {
+    // Held-Karp over the stops 1..nodes-1: best[mask][last] is the shortest
+    // walk from node 0 through the stops in mask, ending at last
+    size_t stops = nodes - 1;
+    size_t masks = size_t(1) << stops;
+    std::vector<float> best(masks * stops, INF);
+    std::vector<uint8_t> previous(masks * stops, 0);
+
+    for (size_t last = 0; last < stops; ++last)
+        best[(size_t(1) << last) * stops + last] = distances[last + 1];
+
+    for (size_t mask = 1; mask < masks; ++mask) {
+        for (size_t last = 0; last < stops; ++last) {
+            float cost = best[mask * stops + last];
+            if (!(mask & (size_t(1) << last)) || cost == INF)
+                continue;
+
+            for (size_t next = 0; next < stops; ++next) {
+                if (mask & (size_t(1) << next))
+                    continue;
+                size_t next_mask = mask | (size_t(1) << next);
+                float candidate = cost + distances[(last + 1) * nodes + next + 1];
+                if (candidate < best[next_mask * stops + next]) {
+                    best[next_mask * stops + next] = candidate;
+                    previous[next_mask * stops + next] = static_cast<uint8_t>(last);
+                }
+            }
+        }
+    }
+
+    size_t full = masks - 1;
+    size_t last = 0;
+    for (size_t i = 1; i < stops; ++i) {
+        if (best[full * stops + i] < best[full * stops + last])
+            last = i;
+    }
+    float length = best[full * stops + last];
+
+    order->assign(stops, 0);
+    size_t mask = full;
+    for (size_t i = stops; i > 0; --i) {
+        (*order)[i - 1] = last + 1;
+        size_t before = previous[mask * stops + last];
+        mask &= ~(size_t(1) << last);
+        last = before;
+    }
+    return length;
+}
+
+uint32_t ScoutPlanner::MapHash(const GameInfo& game_info) {
+    // FNV-1a over the map size and pathing grid, so an updated map with the
+    // same name is planned again
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 16777619u;
+    };
+    for (int shift = 0; shift < 32; shift += 8) {
+        mix(static_cast<uint8_t>(game_info.width >> shift));
+        mix(static_cast<uint8_t>(game_info.height >> shift));
+    }
+    for (char byte : game_info.pathing_grid.data)
+        mix(static_cast<uint8_t>(byte));
+    return hash;
+}
+
+std::string ScoutPlanner::CachePath(const std::string& cache_dir, const GameInfo& game_info, const Point2D& start) {
+    std::string name;
+    for (char c : game_info.map_name)
+        name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    return cache_dir + "/" + name + "_" + std::to_string(static_cast<int>(start.x)) + "_" +
+           std::to_string(static_cast<int>(start.y)) + ".bin";
+}
+
+bool ScoutPlanner::Load(const std::string& path, uint32_t hash) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    CacheHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == MAGIC &&
+                 header.version == VERSION && header.map_hash == hash && header.stops > 0 &&
+                 header.stops <= MAX_STOPS;
+
+    std::vector<CacheStop> stops(valid ? header.stops : 0);
+    if (valid)
+        valid = std::fread(stops.data(), sizeof(CacheStop), stops.size(), file) == stops.size();
+    std::fclose(file);
+    if (!valid)
+        return false;
+
+    for (const auto& stop : stops)
+        route_.push_back({Point2D(stop.x, stop.y), stop.start_location != 0});
+    length_ = header.length;
+    return true;
+}
+
+bool ScoutPlanner::Save(const std::string& path, uint32_t hash) const {
+    // Written next to the cache and renamed over it, so a failed or
+    // interrupted write never leaves a truncated route behind
+    std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    CacheHeader header = {MAGIC, VERSION, hash, static_cast<uint32_t>(route_.size()), length_};
+    std::vector<CacheStop> stops;
+    for (const auto& stop : route_)
+        stops.push_back({stop.pos.x, stop.pos.y, stop.start_location ? 1u : 0u});
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(stops.data(), sizeof(CacheStop), stops.size(), file) == stops.size();
+    if (std::fclose(file) != 0)
+        written = false;
+
+    std::error_code ec;
+    if (written)
+        std::filesystem::rename(temp_path, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SCOUT_PLANNER_H
+#define SCOUT_PLANNER_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BaseIndex;
+class Pathfinder;
+
+// One place the scout has to look at.
+struct ScoutStop {
+    sc2::Point2D pos;
+    bool start_location = false;    // an enemy main, as opposed to a natural
+};
+
+// Order in which a worker scout visits the possible enemy mains and their
+// natural expansions. Ground distances between every pair of stops come
+// from the pathfinder, and the visiting order is the shortest open tour
+// from our main, solved exactly over the few stops a map has. The route
+// depends only on the map and our start, so it is written to a small file
+// per map and start location and read back in later games.
+class ScoutPlanner {
+public:
+    // Exact search is 2^n * n^2; maps have at most a handful of starts
+    static constexpr size_t MAX_STOPS = 12;
+
+    // Plans the route from our main, or loads it from cache_dir if this map
+    // and start were planned before. False if there is nothing to scout.
+    bool Plan(const sc2::GameInfo& game_info, const sc2::Point2D& start, const BaseIndex& bases,
+              Pathfinder& pathfinder, const std::string& cache_dir);
+
+    const std::vector<ScoutStop>& Route() const { return route_; }
+
+    // Ground length of the tour, as planned.
+    float Length() const { return length_; }
+
+    bool FromCache() const { return from_cache_; }
+
+private:
+    static constexpr uint32_t MAGIC = 0x52534242;  // "BBSR"
+    static constexpr uint32_t VERSION = 1;
+
+    // Shortest path through all stops starting at node 0, which is not a stop.
+    static float SolveOrder(const std::vector<float>& distances, size_t nodes, std::vector<size_t>* order);
+
+    static uint32_t MapHash(const sc2::GameInfo& game_info);
+    static std::string CachePath(const std::string& cache_dir, const sc2::GameInfo& game_info,
+                                 const sc2::Point2D& start);
+
+    bool Load(const std::string& path, uint32_t hash);
+    // False if the cache could not be written; an older one is left as it was.
+    bool Save(const std::string& path, uint32_t hash) const;
+
+    std::vector<ScoutStop> route_;
+    float length_ = 0.0f;
+    bool from_cache_ = false;
+};
+
+#endif // SCOUT_PLANNER_H
@@ -0,0 +1,66 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity must be a power of two; one slot is kept empty to tell a
+// full ring from an empty one. Head and tail live on separate cache lines so
+// the two threads do not invalidate each other on every operation.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. False if the queue is full.
+    bool Push(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & MASK;
+        if (next == head_cache_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (next == head_cache_)
+                return false;
+        }
+
+        slots_[tail] = std::move(value);
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. False if the queue is empty.
+    bool Pop(T* out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_)
+                return false;
+        }
+
+        *out = std::move(slots_[head]);
+        head_.store((head + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is active.
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Consumer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+
+    // Producer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+
+    alignas(CACHE_LINE) T slots_[Capacity];
+};
+
+#endif // SPSC_QUEUE_H
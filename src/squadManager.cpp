@@ -0,0 +1,175 @@
+#include "squadManager.h"
+
+#include "unitStats.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+namespace {
+
+// A unit stays in its squad while within this distance of the centroid.
+const float LEAVE_RADIUS = 14.0f;
+
+// A stray unit joins the nearest squad within this distance.
+const float JOIN_RADIUS = 10.0f;
+
+// Squads whose centroids come this close are merged.
+const float MERGE_RADIUS = 6.0f;
+
+}  // namespace
+
+float SquadManager::Dps(UnitTypeID type, const ObservationInterface* observation) {
+    uint32_t id = type;
+    auto it = dps_cache_.find(id);
+    if (it != dps_cache_.end())
+        return it->second;
+
+    const UnitTypes& types = observation->GetUnitTypeData();
+    float dps = id < types.size() ? UnitStats::Dps(types[id]) : 0.0f;
+    dps_cache_[id] = dps;
+    return dps;
+}
+
+void SquadManager::Refresh(Squad& squad, const ObservationInterface* observation) {
+    Point2D sum;
+    squad.health = 0.0f;
+    squad.dps = 0.0f;
+    squad.composition.clear();
+
+    for (const auto& unit : squad.units) {
+        sum += unit->pos;
+        squad.health += unit->health + unit->shield;
+        squad.dps += Dps(unit->unit_type, observation);
+
+        auto entry = std::find_if(squad.composition.begin(), squad.composition.end(),
+            [unit](const std::pair<UnitTypeID, int>& e) { return e.first == unit->unit_type; });
+        if (entry != squad.composition.end())
+            ++entry->second;
+        else
+            squad.composition.emplace_back(unit->unit_type, 1);
+    }
+
+    squad.centroid = sum / static_cast<float>(squad.units.size());
+    squad.radius = 0.0f;
+    for (const auto& unit : squad.units)
+        squad.radius = std::max(squad.radius, Distance2D(unit->pos, squad.centroid));
+
+    squad.strength = squad.health * squad.dps;
+}
+
+void SquadManager::Update(const std::vector<const Unit*>& army, const ObservationInterface* observation) {
+    for (auto& squad : squads_) {
+        squad.units.clear();
+    }
+
+    auto find_squad = [this](uint32_t id) -> Squad* {
+        for (auto& squad : squads_) {
+            if (squad.id == id)
+                return &squad;
+        }
+        return nullptr;
+    };
+
+    // Keep units in their squad while they stay close, otherwise re-home them
+    for (const auto& unit : army) {
+        auto member = membership_.find(unit->tag);
+        if (member != membership_.end()) {
+            Squad* squad = find_squad(member->second);
+            if (squad && Distance2D(unit->pos, squad->centroid) <= LEAVE_RADIUS) {
+                squad->units.push_back(unit);
+                continue;
+            }
+        }
+
+        Squad* nearest = nullptr;
+        float nearest_distance = JOIN_RADIUS;
+        for (auto& squad : squads_) {
+            float distance = Distance2D(unit->pos, squad.centroid);
+            if (distance <= nearest_distance) {
+                nearest_distance = distance;
+                nearest = &squad;
+            }
+        }
+
+        if (!nearest) {
+            squads_.emplace_back();
+            nearest = &squads_.back();
+            nearest->id = next_id_++;
+            nearest->centroid = unit->pos;
+        }
+
+        nearest->units.push_back(unit);
+        nearest->members_changed = true;
+    }
+
+    squads_.erase(std::remove_if(squads_.begin(), squads_.end(),
+        [](const Squad& squad) { return squad.units.empty(); }), squads_.end());
+
+    for (auto& squad : squads_)
+        Refresh(squad, observation);
+
+    // Merge squads that have drifted together into the larger one
+    for (size_t i = 0; i < squads_.size(); ++i) {
+        for (size_t j = i + 1; j < squads_.size();) {
+            if (Distance2D(squads_[i].centroid, squads_[j].centroid) > MERGE_RADIUS) {
+                ++j;
+                continue;
+            }
+
+            if (squads_[j].units.size() > squads_[i].units.size())
+                std::swap(squads_[i], squads_[j]);
+
+            Squad& keep = squads_[i];
+            keep.units.insert(keep.units.end(), squads_[j].units.begin(), squads_[j].units.end());
+            keep.members_changed = true;
+            squads_.erase(squads_.begin() + static_cast<std::ptrdiff_t>(j));
+            Refresh(keep, observation);
+        }
+    }
+
+    membership_.clear();
+    for (const auto& squad : squads_) {
+        for (const auto& unit : squad.units)
+            membership_[unit->tag] = squad.id;
+    }
+}
+
+float SquadManager::EnemyStrengthNear(const Point2D& pos, float radius,
+                                      const std::vector<const Unit*>& enemies,
+                                      const ObservationInterface* observation) {
+    float health = 0.0f;
+    float dps = 0.0f;
+    float radius_sq = radius * radius;
+
+    for (const auto& enemy : enemies) {
+        if (DistanceSquared2D(enemy->pos, pos) > radius_sq || UnitStats::IsWorker(enemy->unit_type))
+            continue;
+
+        // Unarmed structures and units only soak damage; they do not make a fight harder
+        float unit_dps = Dps(enemy->unit_type, observation);
+        if (unit_dps <= 0.0f)
+            continue;
+
+        health += enemy->health + enemy->shield;
+        dps += unit_dps;
+    }
+
+    return health * dps;
+}
+
+void SquadManager::Order(Squad& squad, SquadOrder order, const Point2D& target, ActionInterface* actions) {
+    if (!squad.members_changed && squad.order == order && Distance2D(squad.order_target, target) < 1.0f)
+        return;
+
+    AbilityID ability = order == SquadOrder::RETREAT ? ABILITY_ID::MOVE_MOVE : ABILITY_ID::ATTACK_ATTACK;
+    actions->UnitCommand(squad.units, ability, target);
+
+    squad.order = order;
+    squad.order_target = target;
+    squad.members_changed = false;
+}
+
+void SquadManager::Release(Squad& squad) {
+    squad.order = SquadOrder::ENGAGE;
+}
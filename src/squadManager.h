@@ -0,0 +1,73 @@
+#ifndef SQUAD_MANAGER_H
+#define SQUAD_MANAGER_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// What a squad has last been told to do as a group.
+enum class SquadOrder {
+    NONE,
+    ADVANCE,
+    ENGAGE,
+    RETREAT,
+    DEFEND
+};
+
+// A spatial cluster of army units commanded as one.
+struct Squad {
+    uint32_t id = 0;
+    sc2::Units units;
+
+    // Aggregates, refreshed on every SquadManager::Update
+    sc2::Point2D centroid;
+    float radius = 0.0f;
+    float health = 0.0f;        // health + shields of all members
+    float dps = 0.0f;           // summed damage per second of all members
+    float strength = 0.0f;      // Lanchester square-law strength: health * dps
+    std::vector<std::pair<sc2::UnitTypeID, int>> composition;
+
+    // Last group order, so it is only re-issued when something changed.
+    // New members stay flagged until the next order reaches them.
+    SquadOrder order = SquadOrder::NONE;
+    sc2::Point2D order_target;
+    bool members_changed = true;
+};
+
+// Clusters the army into squads and keeps membership stable between steps,
+// so decisions and group commands scale with squads instead of units.
+class SquadManager {
+public:
+    // Re-clusters the army incrementally and refreshes squad aggregates.
+    void Update(const std::vector<const sc2::Unit*>& army, const sc2::ObservationInterface* observation);
+
+    std::vector<Squad>& Squads() { return squads_; }
+
+    // Strength of the armed enemies within radius of a point, comparable to
+    // Squad::strength. Workers and anything without a weapon are left out.
+    float EnemyStrengthNear(const sc2::Point2D& pos, float radius,
+                            const std::vector<const sc2::Unit*>& enemies,
+                            const sc2::ObservationInterface* observation);
+
+    // Issues one group command to the squad unless it already follows it.
+    void Order(Squad& squad, SquadOrder order, const sc2::Point2D& target, sc2::ActionInterface* actions);
+
+    // Marks the squad as no longer following a group order, e.g. while its
+    // units are being micro-managed individually.
+    void Release(Squad& squad);
+
+private:
+    float Dps(sc2::UnitTypeID type, const sc2::ObservationInterface* observation);
+
+    void Refresh(Squad& squad, const sc2::ObservationInterface* observation);
+
+    std::vector<Squad> squads_;
+    std::unordered_map<sc2::Tag, uint32_t> membership_;
+    std::unordered_map<uint32_t, float> dps_cache_;
+    uint32_t next_id_ = 1;
+};
+
+#endif // SQUAD_MANAGER_H
@@ -0,0 +1,252 @@
+#include "targetSelector.h"
+
+#include "unitStats.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+namespace {
+
+// Enemies this far beyond weapon range are still considered, at a discount.
+const float LEASH_DISTANCE = 3.0f;
+const float OUT_OF_RANGE_FACTOR = 0.3f;
+
+// A unit that is already going to die from pending damage is a poor pick.
+const float OVERKILL_FACTOR = 0.05f;
+
+// Pending damage is the attacker's dps over this many seconds.
+const float DAMAGE_HORIZON = 1.0f;
+
+// How much the enemy's own damage output raises its priority.
+const float THREAT_WEIGHT = 0.5f;
+
+// Hysteresis: a new target must score this much better, and the old one must
+// have been held this many loops, before an attacker switches.
+const float SWITCH_MARGIN = 1.3f;
+const uint32_t MIN_DWELL_LOOPS = 11;
+
+}  // namespace
+
+const TargetSelector::TypeProfile& TargetSelector::Profile(UnitTypeID type, const UnitTypes& types) {
+    uint32_t id = type;
+    auto it = profiles_.find(id);
+    if (it != profiles_.end())
+        return it->second;
+
+    TypeProfile profile;
+    if (id < types.size()) {
+        const UnitTypeData& data = types[id];
+        profile.armor = data.armor;
+        profile.attributes = data.attributes;
+        profile.threat = UnitStats::Dps(data);
+
+        for (const auto& weapon : data.weapons) {
+            float cooldown = weapon.speed > 0.0f ? weapon.speed : 1.0f;
+            float rate = static_cast<float>(weapon.attacks) / cooldown;
+            float dps = weapon.damage_ * rate;
+            bool ground = weapon.type != Weapon::TargetType::Air;
+            bool air = weapon.type != Weapon::TargetType::Ground;
+
+            if (ground && dps > profile.ground_damage * profile.ground_rate) {
+                profile.ground_range = weapon.range;
+                profile.ground_damage = weapon.damage_;
+                profile.ground_rate = rate;
+                profile.ground_bonus = weapon.damage_bonus;
+            }
+            if (air && dps > profile.air_damage * profile.air_rate) {
+                profile.air_range = weapon.range;
+                profile.air_damage = weapon.damage_;
+                profile.air_rate = rate;
+                profile.air_bonus = weapon.damage_bonus;
+            }
+        }
+    }
+
+    return profiles_.emplace(id, std::move(profile)).first->second;
+}
+
+void TargetSelector::ComputeDpsRow(const TypeProfile& attacker) {
+    size_t count = enemy_tag_.size();
+    dps_row_.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const TypeProfile& enemy = *enemy_profile_[i];
+        float dps = 0.0f;
+        if (enemy_flying_[i]) {
+            if (attacker.air_damage > 0.0f)
+                dps = UnitStats::HitDamage(attacker.air_damage, attacker.air_bonus, enemy.attributes, enemy.armor) * attacker.air_rate;
+        }
+        else if (attacker.ground_damage > 0.0f) {
+            dps = UnitStats::HitDamage(attacker.ground_damage, attacker.ground_bonus, enemy.attributes, enemy.armor) * attacker.ground_rate;
+        }
+        dps_row_[i] = dps;
+    }
+}
+
+void TargetSelector::Update(const std::vector<const Unit*>& attackers,
+                            const std::vector<const Unit*>& enemies,
+                            const ObservationInterface* observation) {
+    Update(attackers, enemies, observation->GetUnitTypeData(), observation->GetGameLoop());
+}
+
+void TargetSelector::Update(const std::vector<const Unit*>& attackers,
+                            const std::vector<const Unit*>& enemies,
+                            const UnitTypes& types, uint32_t game_loop) {
+    retargeted_.clear();
+    unassigned_.clear();
+
+    // Build the enemy batch
+    enemy_tag_.clear();
+    enemy_unit_.clear();
+    enemy_profile_.clear();
+    enemy_x_.clear();
+    enemy_y_.clear();
+    enemy_radius_.clear();
+    enemy_hp_.clear();
+    enemy_threat_.clear();
+    enemy_flying_.clear();
+    enemy_index_.clear();
+
+    float max_threat = 0.0f;
+    for (const auto& enemy : enemies) {
+        if (!enemy->is_alive || enemy->display_type != Unit::DisplayType::Visible)
+            continue;
+
+        const TypeProfile& profile = Profile(enemy->unit_type, types);
+        enemy_index_[enemy->tag] = static_cast<uint32_t>(enemy_tag_.size());
+        enemy_tag_.push_back(enemy->tag);
+        enemy_unit_.push_back(enemy);
+        enemy_profile_.push_back(&profile);
+        enemy_x_.push_back(enemy->pos.x);
+        enemy_y_.push_back(enemy->pos.y);
+        enemy_radius_.push_back(enemy->radius);
+        enemy_hp_.push_back(enemy->health + enemy->shield);
+        enemy_threat_.push_back(profile.threat);
+        enemy_flying_.push_back(enemy->is_flying ? 1 : 0);
+        max_threat = std::max(max_threat, profile.threat);
+    }
+
+    size_t count = enemy_tag_.size();
+    enemy_pending_.assign(count, 0.0f);
+    score_row_.resize(count);
+
+    if (max_threat > 0.0f) {
+        float scale = THREAT_WEIGHT / max_threat;
+        for (size_t i = 0; i < count; ++i)
+            enemy_threat_[i] = 1.0f + enemy_threat_[i] * scale;
+    }
+    else {
+        std::fill(enemy_threat_.begin(), enemy_threat_.end(), 1.0f);
+    }
+
+    // Attackers holding a live target commit their damage first, then the
+    // rest are grouped by type so the dps row is computed once per type.
+    std::vector<const Unit*> order(attackers.begin(), attackers.end());
+    auto holds_target = [this](const Unit* unit) {
+        auto it = sticky_.find(unit->tag);
+        return it != sticky_.end() && enemy_index_.count(it->second.target) > 0;
+    };
+    std::stable_sort(order.begin(), order.end(), [&holds_target](const Unit* a, const Unit* b) {
+        bool ha = holds_target(a);
+        bool hb = holds_target(b);
+        if (ha != hb)
+            return ha;
+        return static_cast<uint32_t>(a->unit_type) < static_cast<uint32_t>(b->unit_type);
+    });
+
+    std::unordered_map<Tag, Sticky> next_sticky;
+    next_sticky.reserve(order.size());
+
+    const TypeProfile* row_profile = nullptr;
+    for (const auto& attacker : order) {
+        const TypeProfile& profile = Profile(attacker->unit_type, types);
+        if (&profile != row_profile) {
+            ComputeDpsRow(profile);
+            row_profile = &profile;
+        }
+
+        float ax = attacker->pos.x;
+        float ay = attacker->pos.y;
+        float ar = attacker->radius;
+        float ground_reach = profile.ground_range + ar;
+        float air_reach = profile.air_range + ar;
+
+        // Branch-free pass over every enemy
+        const float* dps = dps_row_.data();
+        const float* ex = enemy_x_.data();
+        const float* ey = enemy_y_.data();
+        const float* er = enemy_radius_.data();
+        const float* hp = enemy_hp_.data();
+        const float* pending = enemy_pending_.data();
+        const float* threat = enemy_threat_.data();
+        const uint8_t* flying = enemy_flying_.data();
+        float* score = score_row_.data();
+        for (size_t i = 0; i < count; ++i) {
+            float dx = ex[i] - ax;
+            float dy = ey[i] - ay;
+            float d2 = dx * dx + dy * dy;
+            float reach = (flying[i] ? air_reach : ground_reach) + er[i];
+            float leash = reach + LEASH_DISTANCE;
+            float remaining = std::max(hp[i] - pending[i], 1.0f);
+            float value = dps[i] / remaining * threat[i];
+            value *= pending[i] >= hp[i] ? OVERKILL_FACTOR : 1.0f;
+            value *= d2 <= reach * reach ? 1.0f : OUT_OF_RANGE_FACTOR;
+            score[i] = d2 <= leash * leash ? value : 0.0f;
+        }
+
+        size_t best = count;
+        float best_score = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            if (score[i] > best_score) {
+                best_score = score[i];
+                best = i;
+            }
+        }
+
+        // Hysteresis against the previous choice
+        Sticky previous;
+        auto old = sticky_.find(attacker->tag);
+        if (old != sticky_.end())
+            previous = old->second;
+
+        size_t chosen = best;
+        auto held = enemy_index_.find(previous.target);
+        if (held != enemy_index_.end() && score[held->second] > 0.0f) {
+            bool clearly_better = best_score > score[held->second] * SWITCH_MARGIN;
+            bool dwelled = game_loop - previous.since_loop >= MIN_DWELL_LOOPS;
+            if (!(clearly_better && dwelled))
+                chosen = held->second;
+        }
+
+        if (chosen == count) {
+            unassigned_.push_back(attacker);
+            continue;
+        }
+
+        enemy_pending_[chosen] += dps[chosen] * DAMAGE_HORIZON;
+
+        Sticky next;
+        next.target = enemy_tag_[chosen];
+        next.since_loop = next.target == previous.target ? previous.since_loop : game_loop;
+        next_sticky[attacker->tag] = next;
+
+        // Also when the attacker dropped the order, e.g. after a move command
+        bool ordered = !attacker->orders.empty() && attacker->orders.front().target_unit_tag == next.target;
+        if (next.target != previous.target || !ordered)
+            retargeted_.push_back({attacker, enemy_unit_[chosen]});
+    }
+
+    sticky_.swap(next_sticky);
+}
+
+Tag TargetSelector::TargetOf(Tag attacker) const {
+    auto it = sticky_.find(attacker);
+    return it != sticky_.end() ? it->second.target : 0;
+}
+
+void TargetSelector::Reset() {
+    sticky_.clear();
+    retargeted_.clear();
+    unassigned_.clear();
+}
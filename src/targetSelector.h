@@ -0,0 +1,96 @@
+#ifndef TARGET_SELECTOR_H
+#define TARGET_SELECTOR_H
+
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Focus-fire target assignment for the army.
+// Every step the selector scores all attacker/enemy pairs within reach and
+// assigns each attacker one target. Assignments are sticky: an attacker only
+// switches when its current target is gone or a clearly better one appears,
+// so orders are re-issued rarely.
+class TargetSelector {
+public:
+    struct Assignment {
+        const sc2::Unit* attacker;
+        const sc2::Unit* target;
+    };
+
+    // Scores all pairs and updates the assignments.
+    void Update(const std::vector<const sc2::Unit*>& attackers,
+                const std::vector<const sc2::Unit*>& enemies,
+                const sc2::ObservationInterface* observation);
+
+    // Same, from unit type data and a game loop captured earlier, so it can
+    // run away from the coordinator thread.
+    void Update(const std::vector<const sc2::Unit*>& attackers,
+                const std::vector<const sc2::Unit*>& enemies,
+                const sc2::UnitTypes& types, uint32_t game_loop);
+
+    // Attackers whose target changed this step, or whose current order is
+    // not on it, and need a new order.
+    const std::vector<Assignment>& Retargeted() const { return retargeted_; }
+
+    // Attackers with nothing worth shooting within reach.
+    const sc2::Units& Unassigned() const { return unassigned_; }
+
+    // Current target tag of an attacker, 0 if none.
+    sc2::Tag TargetOf(sc2::Tag attacker) const;
+
+    void Reset();
+
+private:
+    // Weapon and defensive stats cached per unit type.
+    struct TypeProfile {
+        float ground_range = 0.0f;
+        float air_range = 0.0f;
+        float ground_damage = 0.0f;     // per hit, before bonuses and armor
+        float air_damage = 0.0f;
+        float ground_rate = 0.0f;       // hits per game second
+        float air_rate = 0.0f;
+        float armor = 0.0f;
+        std::vector<sc2::DamageBonus> ground_bonus;
+        std::vector<sc2::DamageBonus> air_bonus;
+        std::vector<sc2::Attribute> attributes;
+        float threat = 0.0f;            // best dps of this type against anything
+    };
+
+    struct Sticky {
+        sc2::Tag target = 0;
+        uint32_t since_loop = 0;
+    };
+
+    const TypeProfile& Profile(sc2::UnitTypeID type, const sc2::UnitTypes& types);
+
+    // Fills dps_row_ with the damage per second an attacker of the given type
+    // deals to every enemy in the current batch.
+    void ComputeDpsRow(const TypeProfile& attacker);
+
+    std::unordered_map<uint32_t, TypeProfile> profiles_;
+    std::unordered_map<sc2::Tag, Sticky> sticky_;
+
+    // Enemy batch, structure-of-arrays so the scoring loops vectorise.
+    std::vector<sc2::Tag> enemy_tag_;
+    std::vector<const sc2::Unit*> enemy_unit_;
+    std::vector<const TypeProfile*> enemy_profile_;
+    std::vector<float> enemy_x_;
+    std::vector<float> enemy_y_;
+    std::vector<float> enemy_radius_;
+    std::vector<float> enemy_hp_;
+    std::vector<float> enemy_pending_;
+    std::vector<float> enemy_threat_;
+    std::vector<uint8_t> enemy_flying_;
+    std::unordered_map<sc2::Tag, uint32_t> enemy_index_;
+
+    // Scratch rows reused by every attacker.
+    std::vector<float> dps_row_;
+    std::vector<float> score_row_;
+
+    std::vector<Assignment> retargeted_;
+    sc2::Units unassigned_;
+};
+
+#endif // TARGET_SELECTOR_H
@@ -0,0 +1,205 @@
+#include "telemetry.h"
+
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::string TelemetrySegmentName(uint32_t pid) {
+    return TELEMETRY_SEGMENT_PREFIX + std::to_string(pid);
+}
+
+uint32_t TelemetryProcessId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+TelemetrySegment::~TelemetrySegment() {
+    Close();
+}
+
+bool TelemetrySegment::Create(const char* name) {
+    Close();
+    std::strncpy(name_, name, sizeof(name_) - 1);
+
+#ifdef _WIN32
+    handle_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        0, sizeof(TelemetryFrame), name_);
+    if (!handle_)
+        return false;
+
+    void* memory = MapViewOfFile(handle_, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(TelemetryFrame));
+    if (!memory) {
+        CloseHandle(handle_);
+        handle_ = nullptr;
+        return false;
+    }
+#else
+    int fd = shm_open(name_, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, sizeof(TelemetryFrame)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    void* memory = mmap(nullptr, sizeof(TelemetryFrame), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return false;
+#endif
+
+    // std::atomic<uint32_t> is trivially constructible, so placement new
+    // does not touch the memory; every field is then initialised explicitly.
+    frame_ = new (memory) TelemetryFrame;
+    owner_ = true;
+
+    frame_->sequence.store(0, std::memory_order_relaxed);
+    TelemetrySample empty;
+    Publish(empty);
+    frame_->version.store(TelemetryFrame::VERSION, std::memory_order_relaxed);
+    frame_->writer_alive.store(1, std::memory_order_relaxed);
+    frame_->magic.store(TelemetryFrame::MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool TelemetrySegment::Open(const char* name) {
+    Close();
+    std::strncpy(name_, name, sizeof(name_) - 1);
+
+#ifdef _WIN32
+    handle_ = OpenFileMappingA(FILE_MAP_READ, FALSE, name_);
+    if (!handle_)
+        return false;
+
+    void* memory = MapViewOfFile(handle_, FILE_MAP_READ, 0, 0, sizeof(TelemetryFrame));
+    if (!memory) {
+        CloseHandle(handle_);
+        handle_ = nullptr;
+        return false;
+    }
+#else
+    int fd = shm_open(name_, O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    // A stale or half-created segment shorter than a frame would fault on
+    // first access instead of failing here
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TelemetryFrame))) {
+        close(fd);
+        return false;
+    }
+
+    void* memory = mmap(nullptr, sizeof(TelemetryFrame), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return false;
+#endif
+
+    frame_ = static_cast<TelemetryFrame*>(memory);
+    owner_ = false;
+    return true;
+}
+
+void TelemetrySegment::Close() {
+    if (!frame_)
+        return;
+
+    if (owner_)
+        frame_->writer_alive.store(0, std::memory_order_release);
+
+#ifdef _WIN32
+    UnmapViewOfFile(frame_);
+    CloseHandle(handle_);
+    handle_ = nullptr;
+#else
+    munmap(frame_, sizeof(TelemetryFrame));
+    if (owner_)
+        shm_unlink(name_);
+#endif
+
+    frame_ = nullptr;
+    owner_ = false;
+}
+
+void TelemetrySegment::Publish(const TelemetrySample& sample) {
+    if (!frame_)
+        return;
+
+    uint32_t seq = frame_->sequence.load(std::memory_order_relaxed);
+    frame_->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    frame_->game_loop.store(sample.game_loop, std::memory_order_relaxed);
+    frame_->step_duration_us.store(sample.step_duration_us, std::memory_order_relaxed);
+    frame_->actions_sent.store(sample.actions_sent, std::memory_order_relaxed);
+    frame_->query_count.store(sample.query_count, std::memory_order_relaxed);
+    frame_->minerals_rate.store(sample.minerals_rate, std::memory_order_relaxed);
+    frame_->vespene_rate.store(sample.vespene_rate, std::memory_order_relaxed);
+    frame_->worker_saturation.store(sample.worker_saturation, std::memory_order_relaxed);
+    frame_->bot_state.store(sample.bot_state, std::memory_order_relaxed);
+    frame_->workers.store(sample.workers, std::memory_order_relaxed);
+    frame_->army.store(sample.army, std::memory_order_relaxed);
+    frame_->production_buildings.store(sample.production_buildings, std::memory_order_relaxed);
+    frame_->tech_buildings.store(sample.tech_buildings, std::memory_order_relaxed);
+    frame_->base_buildings.store(sample.base_buildings, std::memory_order_relaxed);
+    frame_->defensive_buildings.store(sample.defensive_buildings, std::memory_order_relaxed);
+    frame_->enemy_units.store(sample.enemy_units, std::memory_order_relaxed);
+
+    frame_->sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool TelemetrySegment::Read(TelemetrySample* sample) const {
+    if (!frame_ || frame_->magic.load(std::memory_order_acquire) != TelemetryFrame::MAGIC)
+        return false;
+
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        uint32_t before = frame_->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        sample->game_loop = frame_->game_loop.load(std::memory_order_relaxed);
+        sample->step_duration_us = frame_->step_duration_us.load(std::memory_order_relaxed);
+        sample->actions_sent = frame_->actions_sent.load(std::memory_order_relaxed);
+        sample->query_count = frame_->query_count.load(std::memory_order_relaxed);
+        sample->minerals_rate = frame_->minerals_rate.load(std::memory_order_relaxed);
+        sample->vespene_rate = frame_->vespene_rate.load(std::memory_order_relaxed);
+        sample->worker_saturation = frame_->worker_saturation.load(std::memory_order_relaxed);
+        sample->bot_state = frame_->bot_state.load(std::memory_order_relaxed);
+        sample->workers = frame_->workers.load(std::memory_order_relaxed);
+        sample->army = frame_->army.load(std::memory_order_relaxed);
+        sample->production_buildings = frame_->production_buildings.load(std::memory_order_relaxed);
+        sample->tech_buildings = frame_->tech_buildings.load(std::memory_order_relaxed);
+        sample->base_buildings = frame_->base_buildings.load(std::memory_order_relaxed);
+        sample->defensive_buildings = frame_->defensive_buildings.load(std::memory_order_relaxed);
+        sample->enemy_units = frame_->enemy_units.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (frame_->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+
+    return false;
+}
+
+uint32_t TelemetrySegment::Sequence() const {
+    return frame_ ? frame_->sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool TelemetrySegment::WriterAlive() const {
+    return frame_ && frame_->writer_alive.load(std::memory_order_acquire) != 0;
+}
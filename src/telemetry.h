@@ -0,0 +1,119 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared-memory segments are named by this prefix and the writer's process
+// id, so bots running on the same host each publish into their own.
+#ifdef _WIN32
+#define TELEMETRY_SEGMENT_PREFIX "Local\\BlankBotTelemetry_"
+#else
+#define TELEMETRY_SEGMENT_PREFIX "/BlankBotTelemetry_"
+#endif
+
+// Name of the segment published by process pid.
+std::string TelemetrySegmentName(uint32_t pid);
+
+// Id of the calling process.
+uint32_t TelemetryProcessId();
+
+// Plain copy of the values published each step.
+struct TelemetrySample {
+    uint32_t game_loop = 0;
+    uint32_t step_duration_us = 0;
+    uint32_t actions_sent = 0;
+    uint32_t query_count = 0;
+    uint32_t minerals_rate = 0;         // collection rate per game minute
+    uint32_t vespene_rate = 0;          // collection rate per game minute
+    uint32_t worker_saturation = 0;     // assigned/ideal harvesters, per mille
+    uint32_t bot_state = 0;             // BotState of the step
+    uint32_t workers = 0;
+    uint32_t army = 0;
+    uint32_t production_buildings = 0;
+    uint32_t tech_buildings = 0;
+    uint32_t base_buildings = 0;
+    uint32_t defensive_buildings = 0;
+    uint32_t enemy_units = 0;
+};
+
+// Fixed layout of the shared-memory segment.
+// Writes are guarded by a sequence lock: the writer bumps sequence to an odd
+// value, stores the fields and bumps it to an even value again. Readers retry
+// until they observe the same even sequence before and after the copy,
+// so neither side ever blocks the other.
+struct TelemetryFrame {
+    static constexpr uint32_t MAGIC = 0x424c4254;  // "BLBT"
+    static constexpr uint32_t VERSION = 1;
+
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> writer_alive;
+
+    std::atomic<uint32_t> game_loop;
+    std::atomic<uint32_t> step_duration_us;
+    std::atomic<uint32_t> actions_sent;
+    std::atomic<uint32_t> query_count;
+    std::atomic<uint32_t> minerals_rate;
+    std::atomic<uint32_t> vespene_rate;
+    std::atomic<uint32_t> worker_saturation;
+    std::atomic<uint32_t> bot_state;
+    std::atomic<uint32_t> workers;
+    std::atomic<uint32_t> army;
+    std::atomic<uint32_t> production_buildings;
+    std::atomic<uint32_t> tech_buildings;
+    std::atomic<uint32_t> base_buildings;
+    std::atomic<uint32_t> defensive_buildings;
+    std::atomic<uint32_t> enemy_units;
+};
+
+static_assert(sizeof(TelemetryFrame) == 19 * sizeof(uint32_t),
+    "TelemetryFrame must keep a fixed layout");
+
+// Owns a named shared-memory mapping of a TelemetryFrame.
+class TelemetrySegment {
+public:
+    TelemetrySegment() = default;
+    ~TelemetrySegment();
+
+    TelemetrySegment(const TelemetrySegment&) = delete;
+    TelemetrySegment& operator=(const TelemetrySegment&) = delete;
+
+    // Creates (or reuses) the segment for writing.
+    bool Create(const char* name);
+
+    // Opens an existing segment for reading.
+    bool Open(const char* name);
+
+    void Close();
+
+    bool IsOpen() const { return frame_ != nullptr; }
+
+    // Publishes a sample. Only a handful of relaxed atomic stores.
+    void Publish(const TelemetrySample& sample);
+
+    // Copies a consistent sample out of the segment.
+    // Returns false if the segment is not initialised or the writer kept it
+    // busy for the whole retry budget.
+    bool Read(TelemetrySample* sample) const;
+
+    // Sequence number of the last complete publication.
+    uint32_t Sequence() const;
+
+    // False once the writer has closed the segment.
+    bool WriterAlive() const;
+
+private:
+    TelemetryFrame* frame_ = nullptr;
+    bool owner_ = false;
+    char name_[64] = {};
+
+#ifdef _WIN32
+    void* handle_ = nullptr;
+#endif
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,93 @@
+// Companion tool: tails the telemetry segment published by a running bot.
+//
+// Usage: BlankBotTelemetry <bot-pid> [poll-interval-ms]
+
+#include "telemetry.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+const char* StateName(uint32_t state) {
+    // Mirrors BotState in Bot_behaviorTree.h.
+    static const char* names[] = {"INIT", "ECONOMY", "ARMY", "ATTACK", "DEFEND", "SCOUT"};
+    if (state < sizeof(names) / sizeof(names[0]))
+        return names[state];
+    return "?";
+}
+
+void PrintHeader() {
+    std::cout << std::setw(8) << "loop" << std::setw(10) << "step_us"
+        << std::setw(6) << "acts" << std::setw(6) << "qry"
+        << std::setw(7) << "min/m" << std::setw(7) << "gas/m"
+        << std::setw(6) << "sat%" << std::setw(9) << "state"
+        << std::setw(5) << "wrk" << std::setw(5) << "army"
+        << std::setw(5) << "prod" << std::setw(5) << "tech"
+        << std::setw(5) << "base" << std::setw(5) << "def"
+        << std::setw(5) << "enmy" << std::endl;
+}
+
+void PrintSample(const TelemetrySample& s) {
+    std::cout << std::setw(8) << s.game_loop << std::setw(10) << s.step_duration_us
+        << std::setw(6) << s.actions_sent << std::setw(6) << s.query_count
+        << std::setw(7) << s.minerals_rate << std::setw(7) << s.vespene_rate
+        << std::setw(6) << s.worker_saturation / 10 << std::setw(9) << StateName(s.bot_state)
+        << std::setw(5) << s.workers << std::setw(5) << s.army
+        << std::setw(5) << s.production_buildings << std::setw(5) << s.tech_buildings
+        << std::setw(5) << s.base_buildings << std::setw(5) << s.defensive_buildings
+        << std::setw(5) << s.enemy_units << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Provide the process id of the bot to tail!" << std::endl;
+        return 1;
+    }
+
+    std::string name = TelemetrySegmentName(static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)));
+    int interval_ms = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (interval_ms <= 0)
+        interval_ms = 100;
+
+    TelemetrySegment segment;
+    std::cout << "Waiting for telemetry segment " << name << "..." << std::endl;
+    while (!segment.Open(name.c_str()))
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    PrintHeader();
+
+    uint32_t last_sequence = 0;
+    int printed = 0;
+    while (true)
+    {
+        uint32_t sequence = segment.Sequence();
+        if (sequence != last_sequence) {
+            TelemetrySample sample;
+            if (segment.Read(&sample)) {
+                last_sequence = sequence;
+                PrintSample(sample);
+
+                if (++printed % 40 == 0)
+                    PrintHeader();
+            }
+        }
+        else if (!segment.WriterAlive()) {
+            std::cout << "Writer closed the segment" << std::endl;
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "unitStats.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+namespace {
+
+// Weapons without a cooldown in the data fire once a second
+float Cooldown(const Weapon& weapon) {
+    return weapon.speed > 0.0f ? weapon.speed : 1.0f;
+}
+
+}  // namespace
+
+bool UnitStats::IsWorker(UnitTypeID type) {
+    switch (type.ToType()) {
+        case UNIT_TYPEID::TERRAN_SCV:
+        case UNIT_TYPEID::TERRAN_MULE:
+        case UNIT_TYPEID::ZERG_DRONE:
+        case UNIT_TYPEID::PROTOSS_PROBE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool UnitStats::IsStructure(const UnitTypeData& type) {
+    return HasAttribute(type.attributes, Attribute::Structure);
+}
+
+bool UnitStats::IsArmy(UnitTypeID type, const UnitTypes& types) {
+    uint32_t id = type;
+    if (id >= types.size() || types[id].weapons.empty())
+        return false;
+    return !IsWorker(type) && !IsStructure(types[id]);
+}
+
+bool UnitStats::HasAttribute(const std::vector<Attribute>& attributes, Attribute attribute) {
+    return std::find(attributes.begin(), attributes.end(), attribute) != attributes.end();
+}
+
+float UnitStats::HitDamage(float damage, const std::vector<DamageBonus>& bonuses,
+                           const std::vector<Attribute>& attributes, float armor) {
+    for (const auto& bonus : bonuses) {
+        if (HasAttribute(attributes, bonus.attribute))
+            damage += bonus.bonus;
+    }
+    return std::max(damage - armor, 0.5f);
+}
+
+float UnitStats::Dps(const UnitTypeData& attacker) {
+    float best = 0.0f;
+    for (const auto& weapon : attacker.weapons)
+        best = std::max(best, weapon.damage_ * weapon.attacks / Cooldown(weapon));
+    return best;
+}
+
+float UnitStats::Dps(const UnitTypeData& attacker, const UnitTypeData& target, bool target_flying) {
+    float best = 0.0f;
+    for (const auto& weapon : attacker.weapons) {
+        if ((weapon.type == Weapon::TargetType::Ground && target_flying) ||
+            (weapon.type == Weapon::TargetType::Air && !target_flying))
+            continue;
+
+        float damage = HitDamage(weapon.damage_, weapon.damage_bonus, target.attributes, target.armor);
+        best = std::max(best, damage * weapon.attacks / Cooldown(weapon));
+    }
+    return best;
+}
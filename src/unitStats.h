@@ -0,0 +1,36 @@
+#ifndef UNIT_STATS_H
+#define UNIT_STATS_H
+
+#include <sc2api/sc2_api.h>
+
+#include <vector>
+
+// Unit type facts shared by the army logic: who is a worker, who is army,
+// and how hard one type hits another, all from the game's unit type data.
+class UnitStats {
+public:
+    // Workers of any race, MULEs included.
+    static bool IsWorker(sc2::UnitTypeID type);
+
+    static bool IsStructure(const sc2::UnitTypeData& type);
+
+    // Armed and neither a worker nor a structure: the units an army is made
+    // of. Cannons, spines and bunkers are armed but stay where they are.
+    static bool IsArmy(sc2::UnitTypeID type, const sc2::UnitTypes& types);
+
+    static bool HasAttribute(const std::vector<sc2::Attribute>& attributes, sc2::Attribute attribute);
+
+    // Damage of one hit after bonuses against the target's attributes and
+    // its armor, never below half a point.
+    static float HitDamage(float damage, const std::vector<sc2::DamageBonus>& bonuses,
+                           const std::vector<sc2::Attribute>& attributes, float armor);
+
+    // Best sustained damage per second of a type's weapons, before bonuses
+    // and armor; 0 if unarmed.
+    static float Dps(const sc2::UnitTypeData& attacker);
+
+    // Best sustained damage per second of attacker's weapons against target.
+    static float Dps(const sc2::UnitTypeData& attacker, const sc2::UnitTypeData& target, bool target_flying);
+};
+
+#endif // UNIT_STATS_H
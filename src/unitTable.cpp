@@ -0,0 +1,75 @@
+#include "unitTable.h"
+
+void UnitTable::Update(const SC2APIProtocol::ObservationRaw& raw, uint32_t game_loop) {
+    for (const auto& unit : raw.units()) {
+        auto found = slot_of_.find(unit.tag());
+        if (found == slot_of_.end()) {
+            found = slot_of_.emplace(unit.tag(), static_cast<uint32_t>(units_.size())).first;
+            units_.emplace_back();
+            units_.back().tag = unit.tag();
+            units_.back().alliance = static_cast<uint8_t>(unit.alliance());
+        }
+
+        // Comparing first would read every field anyway, so just write them
+        CompactUnit& record = units_[found->second];
+        record.x = unit.pos().x();
+        record.y = unit.pos().y();
+        record.health = unit.health() + unit.shield();
+        record.build_progress = unit.build_progress();
+        record.unit_type = unit.unit_type();
+        record.order_ability = unit.orders_size() > 0 ? unit.orders(0).ability_id() : 0;
+        record.last_seen_loop = game_loop;
+        record.order_count = static_cast<uint16_t>(unit.orders_size());
+        record.display_type = static_cast<uint8_t>(unit.display_type());
+    }
+
+    // Drop units missing from this observation, keeping the vector dense
+    for (size_t i = 0; i < units_.size();) {
+        if (units_[i].last_seen_loop == game_loop) {
+            ++i;
+            continue;
+        }
+        slot_of_.erase(units_[i].tag);
+        if (i + 1 != units_.size()) {
+            units_[i] = units_.back();
+            slot_of_[units_[i].tag] = static_cast<uint32_t>(i);
+        }
+        units_.pop_back();
+    }
+
+    own_.clear();
+    enemies_.clear();
+    for (uint32_t i = 0; i < units_.size(); ++i) {
+        if (units_[i].alliance == SC2APIProtocol::Self)
+            own_.push_back(i);
+        else if (units_[i].alliance == SC2APIProtocol::Enemy)
+            enemies_.push_back(i);
+    }
+}
+
+const CompactUnit* UnitTable::Find(uint64_t tag) const {
+    auto found = slot_of_.find(tag);
+    return found != slot_of_.end() ? &units_[found->second] : nullptr;
+}
+
+google::protobuf::ArenaOptions ObservationDecoder::Options(std::vector<char>* block, size_t size) {
+    block->resize(size);
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block->data();
+    options.initial_block_size = block->size();
+    return options;
+}
+
+ObservationDecoder::ObservationDecoder(size_t initial_block)
+    : arena_(Options(&block_, initial_block)) {
+}
+
+const SC2APIProtocol::ResponseObservation* ObservationDecoder::Decode(const std::string& bytes) {
+    // Everything from the previous decode goes at once
+    arena_.Reset();
+
+    auto* response = google::protobuf::Arena::CreateMessage<SC2APIProtocol::Response>(&arena_);
+    if (!response->ParseFromString(bytes) || !response->has_observation())
+        return nullptr;
+    return &response->observation();
+}
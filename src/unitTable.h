@@ -0,0 +1,74 @@
+#ifndef UNIT_TABLE_H
+#define UNIT_TABLE_H
+
+#include <google/protobuf/arena.h>
+#include <s2clientprotocol/sc2api.pb.h>
+#include <sc2api/sc2_common.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The few unit fields the bot reads every step, in 40 bytes.
+struct CompactUnit {
+    uint64_t tag = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    float health = 0.0f;            // hit points plus shields
+    float build_progress = 0.0f;
+    uint32_t unit_type = 0;
+    uint32_t order_ability = 0;     // first order, 0 if idle
+    uint32_t last_seen_loop = 0;
+    uint8_t alliance = 0;           // SC2APIProtocol::Alliance
+    uint8_t display_type = 0;       // SC2APIProtocol::DisplayType
+    uint16_t order_count = 0;
+};
+
+static_assert(sizeof(CompactUnit) == 40, "CompactUnit is meant to fit 40 bytes");
+
+// Compact unit records converted straight from the raw observation.
+// Only the fields in CompactUnit are read. Records live in one dense vector
+// keyed by tag that keeps its capacity between updates.
+// Pairs with ObservationDecoder below: the bot's own connection is decoded
+// by cpp-sc2, so converting its observation again would only add work.
+class UnitTable {
+public:
+    // Converts this step's units and drops the ones that are gone.
+    void Update(const SC2APIProtocol::ObservationRaw& raw, uint32_t game_loop);
+
+    const std::vector<CompactUnit>& Units() const { return units_; }
+
+    // Slots in Units() by alliance, rebuilt on every update.
+    const std::vector<uint32_t>& Own() const { return own_; }
+    const std::vector<uint32_t>& Enemies() const { return enemies_; }
+
+    const CompactUnit* Find(uint64_t tag) const;
+
+private:
+    std::vector<CompactUnit> units_;
+    std::unordered_map<uint64_t, uint32_t> slot_of_;
+    std::vector<uint32_t> own_;
+    std::vector<uint32_t> enemies_;
+};
+
+// Parses serialized responses into an arena that is reset, not freed,
+// between steps, so a decode costs no heap allocations once warm.
+// For code that owns the response bytes; cpp-sc2 decodes the bot's own
+// connection itself.
+class ObservationDecoder {
+public:
+    explicit ObservationDecoder(size_t initial_block = 1 << 20);
+
+    // The observation in a serialized Response, nullptr if it has none.
+    // Valid until the next call.
+    const SC2APIProtocol::ResponseObservation* Decode(const std::string& bytes);
+
+private:
+    static google::protobuf::ArenaOptions Options(std::vector<char>* block, size_t size);
+
+    std::vector<char> block_;
+    google::protobuf::Arena arena_;
+};
+
+#endif // UNIT_TABLE_H
@@ -0,0 +1,155 @@
+#include "visibilityGrid.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace sc2;
+
+namespace {
+
+// Map state visibility values
+const uint8_t VISIBLE = 2;
+
+}  // namespace
+
+void VisibilityGrid::Initialize(const GameInfo& game_info) {
+    width_ = game_info.width;
+    height_ = game_info.height;
+    tiles_x_ = (width_ + TILE - 1) / TILE;
+    tiles_y_ = (height_ + TILE - 1) / TILE;
+    game_loop_ = 0;
+
+    visible_.Resize(width_, height_);
+    explored_.Resize(width_, height_);
+    pathable_ = BitGrid::FromImage(ImageView(game_info.pathing_grid));
+    pathable_count_ = pathable_.Count();
+
+    size_t tiles = static_cast<size_t>(tiles_x_) * tiles_y_;
+    last_seen_.assign(tiles * TILE * TILE, 0);
+    tile_seen_.assign(tiles, 0);
+    tile_point_.assign(tiles, Point2D());
+    pathable_tiles_.clear();
+
+    // Queries hand out the pathable cell closest to each tile's center, and
+    // skip tiles that are mostly cliff or out of bounds
+    for (int ty = 0; ty < tiles_y_; ++ty) {
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            Point2D center((tx + 0.5f) * TILE, (ty + 0.5f) * TILE);
+            float best = std::numeric_limits<float>::max();
+            int cells = 0;
+            for (int y = ty * TILE; y < std::min(height_, (ty + 1) * TILE); ++y) {
+                for (int x = tx * TILE; x < std::min(width_, (tx + 1) * TILE); ++x) {
+                    if (!pathable_.Get(x, y))
+                        continue;
+                    ++cells;
+                    Point2D cell(x + 0.5f, y + 0.5f);
+                    float distance_sq = DistanceSquared2D(cell, center);
+                    if (distance_sq < best) {
+                        best = distance_sq;
+                        tile_point_[static_cast<size_t>(ty) * tiles_x_ + tx] = cell;
+                    }
+                }
+            }
+            if (cells >= TILE * TILE / 4)
+                pathable_tiles_.push_back(static_cast<uint32_t>(ty * tiles_x_ + tx));
+        }
+    }
+
+    start_locations_ = game_info.enemy_start_locations;
+}
+
+size_t VisibilityGrid::TileOf(int x, int y) const {
+    return static_cast<size_t>(y / TILE) * tiles_x_ + x / TILE;
+}
+
+void VisibilityGrid::MarkVisible(int x, int y, uint8_t mask, uint16_t stamp) {
+    // x is a multiple of eight, so the mask never straddles a tile
+    size_t tile = TileOf(x, y);
+    tile_seen_[tile] = game_loop_;
+    uint16_t* cells = &last_seen_[tile * TILE * TILE + static_cast<size_t>(y % TILE) * TILE];
+    if (mask == 0xFF) {
+        std::fill(cells, cells + TILE, stamp);
+        return;
+    }
+    for (int i = 0; i < TILE; ++i) {
+        if (mask & (1u << i))
+            cells[i] = stamp;
+    }
+}
+
+void VisibilityGrid::Update(const SC2APIProtocol::ImageData& visibility, uint32_t game_loop) {
+    if (!IsInitialized())
+        return;
+
+    const std::string& data = visibility.data();
+    if (visibility.bits_per_pixel() != 8 || visibility.size().x() != width_ ||
+        data.size() < static_cast<size_t>(width_) * height_)
+        return;
+
+    game_loop_ = game_loop;
+    uint16_t stamp = static_cast<uint16_t>(std::min<uint32_t>(game_loop / LOOP_QUANTUM + 1, UINT16_MAX));
+    BitGrid::FromImageEqual(ImageView(data.data(), data.size(), width_, height_, 8), VISIBLE, &visible_);
+
+    // Tile stamps only for the bytes of each word with a visible cell
+    for (int y = 0; y < height_; ++y) {
+        const uint64_t* row = visible_.Row(y);
+        for (int word = 0; word < visible_.Stride(); ++word) {
+            uint64_t bits = row[word];
+            for (int byte = 0; bits != 0; ++byte, bits >>= 8) {
+                uint8_t mask = static_cast<uint8_t>(bits);
+                if (mask)
+                    MarkVisible(word * 64 + byte * 8, y, mask, stamp);
+            }
+        }
+    }
+
+    explored_.Or(visible_);
+}
+
+bool VisibilityGrid::IsVisible(const Point2D& pos) const {
+    int x = static_cast<int>(pos.x);
+    int y = static_cast<int>(pos.y);
+    return Contains(x, y) && visible_.Get(x, y);
+}
+
+bool VisibilityGrid::IsExplored(const Point2D& pos) const {
+    int x = static_cast<int>(pos.x);
+    int y = static_cast<int>(pos.y);
+    return Contains(x, y) && explored_.Get(x, y);
+}
+
+uint32_t VisibilityGrid::LastSeen(const Point2D& pos) const {
+    int x = static_cast<int>(pos.x);
+    int y = static_cast<int>(pos.y);
+    if (!Contains(x, y))
+        return 0;
+
+    uint16_t stamp = last_seen_[TileOf(x, y) * TILE * TILE + static_cast<size_t>(y % TILE) * TILE + x % TILE];
+    return stamp == 0 ? 0 : std::max<uint32_t>(1, (stamp - 1u) * LOOP_QUANTUM);
+}
+
+void VisibilityGrid::StalestRegions(size_t count, std::vector<Point2D>* out) const {
+    out->clear();
+    std::vector<uint32_t> tiles = pathable_tiles_;
+    count = std::min(count, tiles.size());
+    std::partial_sort(tiles.begin(), tiles.begin() + count, tiles.end(), [this](uint32_t a, uint32_t b) {
+        return tile_seen_[a] != tile_seen_[b] ? tile_seen_[a] < tile_seen_[b] : a < b;
+    });
+    for (size_t i = 0; i < count; ++i)
+        out->push_back(tile_point_[tiles[i]]);
+}
+
+void VisibilityGrid::UnexploredStartLocations(std::vector<Point2D>* out) const {
+    out->clear();
+    for (const auto& location : start_locations_) {
+        if (!IsExplored(location))
+            out->push_back(location);
+    }
+}
+
+float VisibilityGrid::ExploredShare() const {
+    if (pathable_count_ == 0)
+        return 0.0f;
+
+    return static_cast<float>(explored_.CountAnd(pathable_)) / pathable_count_;
+}
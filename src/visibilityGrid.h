@@ -0,0 +1,80 @@
+#ifndef VISIBILITY_GRID_H
+#define VISIBILITY_GRID_H
+
+#include "mapGrid.h"
+
+#include <s2clientprotocol/sc2api.pb.h>
+#include <sc2api/sc2_api.h>
+
+#include <cstdint>
+#include <vector>
+
+// What we can see now, what we have ever seen and when each cell was last
+// in vision. The map state visibility image is packed into a bit grid
+// a register of cells at a time, and last-seen loops are kept in 8x8 tiles so
+// one image row chunk updates one contiguous tile row. Every tile also
+// remembers when any of it was last visible, which is what the staleness
+// queries read.
+class VisibilityGrid {
+public:
+    // Tile edge length in cells
+    static constexpr int TILE = 8;
+
+    // Sizes the grids to the map, marks nothing as seen and picks a
+    // pathable point per tile for queries to return.
+    void Initialize(const sc2::GameInfo& game_info);
+
+    // Folds this step's visibility image in.
+    void Update(const SC2APIProtocol::ImageData& visibility, uint32_t game_loop);
+
+    bool IsVisible(const sc2::Point2D& pos) const;
+
+    // Visible now or at some point earlier in the game.
+    bool IsExplored(const sc2::Point2D& pos) const;
+
+    // Last loop the cell was visible, 0 if it never was.
+    uint32_t LastSeen(const sc2::Point2D& pos) const;
+
+    // One pathable point per tile, for the tiles seen longest ago, never
+    // seen first.
+    void StalestRegions(size_t count, std::vector<sc2::Point2D>* out) const;
+
+    // Possible enemy start locations none of our units has seen yet.
+    void UnexploredStartLocations(std::vector<sc2::Point2D>* out) const;
+
+    // Share of pathable cells explored so far, 0..1.
+    float ExploredShare() const;
+
+    bool IsInitialized() const { return width_ > 0; }
+
+private:
+    // Last-seen loops are stored divided by this, saturating, to fit 16 bits
+    static constexpr uint32_t LOOP_QUANTUM = 16;
+
+    bool Contains(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
+    size_t TileOf(int x, int y) const;
+    void MarkVisible(int x, int y, uint8_t mask, uint16_t stamp);
+
+    int width_ = 0;
+    int height_ = 0;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    uint32_t game_loop_ = 0;
+
+    BitGrid visible_;
+    BitGrid explored_;
+    BitGrid pathable_;
+
+    // TILE * TILE quantized loops per tile, row-major inside the tile
+    std::vector<uint16_t> last_seen_;
+
+    // Per tile: last loop any cell was visible, and a pathable point in it
+    std::vector<uint32_t> tile_seen_;
+    std::vector<sc2::Point2D> tile_point_;
+    std::vector<uint32_t> pathable_tiles_;
+    size_t pathable_count_ = 0;
+
+    std::vector<sc2::Point2D> start_locations_;
+};
+
+#endif // VISIBILITY_GRID_H
@@ -0,0 +1,71 @@
+#include "warmUp.h"
+
+#include <utility>
+
+using namespace sc2;
+
+WarmUp::~WarmUp() {
+    Wait();
+}
+
+void WarmUp::Start(const GameInfo& game_info, const Units& neutral_units, const UnitTypes& types) {
+    Wait();
+    ready_.store(false, std::memory_order_relaxed);
+
+    game_info_ = game_info;
+    types_ = types;
+    neutral_copies_.clear();
+    for (const auto* unit : neutral_units)
+        neutral_copies_.push_back(*unit);
+    neutral_units_.clear();
+    for (const auto& unit : neutral_copies_)
+        neutral_units_.push_back(&unit);
+
+    results_ = WarmUpResults();
+    started_ = std::chrono::steady_clock::now();
+    pending_.store(3, std::memory_order_relaxed);
+
+    // Each task writes only its own part of the results; the inputs are
+    // read-only until Wait()
+    workers_.emplace_back([this] {
+        results_.power_grid.Initialize(game_info_, neutral_units_);
+        results_.base_index.Build(game_info_, neutral_units_, types_, results_.power_grid);
+        Finish();
+    });
+    workers_.emplace_back([this] {
+        results_.pathfinder.Initialize(game_info_, neutral_units_);
+        results_.pathfinder.Prepare();
+        Finish();
+    });
+    workers_.emplace_back([this] {
+        results_.visibility.Initialize(game_info_);
+        results_.composition.Initialize(types_);
+        for (const auto& type : types_) {
+            if (type.ability_id != ABILITY_ID::INVALID && type.build_time > 0.0f)
+                results_.build_time_by_ability[type.ability_id] = type.build_time;
+        }
+        Finish();
+    });
+}
+
+void WarmUp::Finish() {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    elapsed_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_);
+    ready_.store(true, std::memory_order_release);
+}
+
+WarmUpResults WarmUp::Take() {
+    Wait();
+    ready_.store(false, std::memory_order_relaxed);
+    return std::move(results_);
+}
+
+void WarmUp::Wait() {
+    for (auto& worker : workers_) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers_.clear();
+}
@@ -0,0 +1,76 @@
+#ifndef WARM_UP_H
+#define WARM_UP_H
+
+#include "baseIndex.h"
+#include "compositionSolver.h"
+#include "pathfinder.h"
+#include "powerGrid.h"
+#include "visibilityGrid.h"
+
+#include <sc2api/sc2_api.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Everything the bot precomputes from the map and the data tables.
+struct WarmUpResults {
+    PowerGrid power_grid;
+    Pathfinder pathfinder;
+    BaseIndex base_index;
+    VisibilityGrid visibility;
+    CompositionSolver composition;
+
+    // Build or train time of each ability, in game loops
+    std::unordered_map<uint32_t, float> build_time_by_ability;
+};
+
+// Builds WarmUpResults on background threads so the first steps are not
+// held up by map analysis. Start copies the game info, the neutral units
+// and the unit type data and returns at once; placement and base
+// clustering, pathfinding regions, and visibility plus the data tables are
+// computed in parallel from those copies. The game thread polls Ready()
+// and swaps the results in between steps, replaying any structure events
+// it saw in the meantime.
+class WarmUp {
+public:
+    WarmUp() = default;
+    WarmUp(const WarmUp&) = delete;
+    WarmUp& operator=(const WarmUp&) = delete;
+    ~WarmUp();
+
+    void Start(const sc2::GameInfo& game_info, const sc2::Units& neutral_units, const sc2::UnitTypes& types);
+
+    // True once every task has finished and the results were not taken yet.
+    bool Ready() const { return ready_.load(std::memory_order_acquire); }
+
+    // Hands the results over; call only after Ready().
+    WarmUpResults Take();
+
+    // Joins the workers, e.g. when the game ends before they are done.
+    void Wait();
+
+    // Start to the last task finishing.
+    std::chrono::microseconds Elapsed() const { return elapsed_; }
+
+private:
+    void Finish();
+
+    // Inputs, copied so the game thread can keep stepping
+    sc2::GameInfo game_info_;
+    std::vector<sc2::Unit> neutral_copies_;
+    sc2::Units neutral_units_;
+    sc2::UnitTypes types_;
+
+    WarmUpResults results_;
+    std::vector<std::thread> workers_;
+    std::atomic<int> pending_{0};
+    std::atomic<bool> ready_{false};
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::microseconds elapsed_{0};
+};
+
+#endif // WARM_UP_H